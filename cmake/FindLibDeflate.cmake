@@ -0,0 +1,32 @@
+find_path(LIBDEFLATE_INCLUDE_DIR
+  NAMES libdeflate.h
+  DOC "libdeflate include directory")
+mark_as_advanced(LIBDEFLATE_INCLUDE_DIR)
+find_library(LIBDEFLATE_LIBRARY
+  NAMES deflate libdeflate
+  DOC "libdeflate library")
+mark_as_advanced(LIBDEFLATE_LIBRARY)
+
+if (LIBDEFLATE_INCLUDE_DIR)
+  file(STRINGS "${LIBDEFLATE_INCLUDE_DIR}/libdeflate.h" _libdeflate_version_line
+    REGEX "#define[ \t]+LIBDEFLATE_VERSION_STRING")
+  string(REGEX REPLACE ".*LIBDEFLATE_VERSION_STRING[ \t]+\"([0-9.]*)\".*" "\\1" LIBDEFLATE_VERSION "${_libdeflate_version_line}")
+  unset(_libdeflate_version_line)
+endif ()
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(LibDeflate
+  REQUIRED_VARS LIBDEFLATE_LIBRARY LIBDEFLATE_INCLUDE_DIR
+  VERSION_VAR LIBDEFLATE_VERSION)
+
+if (LIBDEFLATE_FOUND)
+  set(LIBDEFLATE_INCLUDE_DIRS "${LIBDEFLATE_INCLUDE_DIR}")
+  set(LIBDEFLATE_LIBRARIES "${LIBDEFLATE_LIBRARY}")
+
+  if (NOT TARGET LibDeflate::LibDeflate)
+    add_library(LibDeflate::LibDeflate UNKNOWN IMPORTED)
+    set_target_properties(LibDeflate::LibDeflate PROPERTIES
+      IMPORTED_LOCATION "${LIBDEFLATE_LIBRARY}"
+      INTERFACE_INCLUDE_DIRECTORIES "${LIBDEFLATE_INCLUDE_DIR}")
+  endif ()
+endif ()
@@ -48,6 +48,10 @@ namespace osmium {
     class Way;
     class WayNodeList;
 
+    namespace io {
+        class NodeColumns;
+    } // namespace io
+
     /**
      * @brief Osmium handlers provide callbacks for OSM objects
      */
@@ -67,6 +71,10 @@ namespace osmium {
          *
          * If you are working with changesets, implement the changeset()
          * function.
+         *
+         * The node_columns() function is only called from
+         * osmium::io::apply_node_columns() with the ids and locations of
+         * all nodes from one blob of a PBF file.
          */
         class Handler {
 
@@ -78,6 +86,9 @@ namespace osmium {
             void node(const osmium::Node& /*node*/) const noexcept {
             }
 
+            void node_columns(const osmium::io::NodeColumns& /*node_columns*/) const noexcept {
+            }
+
             void way(const osmium::Way& /*way*/) const noexcept {
             }
 
@@ -37,12 +37,14 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/index/index.hpp>
 #include <osmium/index/map/dummy.hpp>
 #include <osmium/index/node_locations_map.hpp>
+#include <osmium/io/node_columns.hpp>
 #include <osmium/osm/location.hpp>
 #include <osmium/osm/node.hpp>
 #include <osmium/osm/node_ref.hpp>
 #include <osmium/osm/types.hpp>
 #include <osmium/osm/way.hpp>
 
+#include <cstddef>
 #include <limits>
 #include <type_traits>
 
@@ -88,6 +90,20 @@ namespace osmium {
 
             bool m_must_sort = false;
 
+            void set_node_location(const osmium::object_id_type id, const osmium::Location location) {
+                const auto positive_id = static_cast<osmium::unsigned_object_id_type>(id < 0 ? -id : id);
+                if (positive_id < m_last_id) {
+                    m_must_sort = true;
+                }
+                m_last_id = positive_id;
+
+                if (id >= 0) {
+                    m_storage_pos.set(static_cast<osmium::unsigned_object_id_type>( id), location);
+                } else {
+                    m_storage_neg.set(static_cast<osmium::unsigned_object_id_type>(-id), location);
+                }
+            }
+
             // It is okay to have this static dummy instance, even when using several threads,
             // because it is read-only.
             static dummy_type& get_dummy() {
@@ -127,16 +143,15 @@ namespace osmium {
              * Store the location of the node in the storage.
              */
             void node(const osmium::Node& node) {
-                if (node.positive_id() < m_last_id) {
-                    m_must_sort = true;
-                }
-                m_last_id = node.positive_id();
+                set_node_location(node.id(), node.location());
+            }
 
-                const auto id = node.id();
-                if (id >= 0) {
-                    m_storage_pos.set(static_cast<osmium::unsigned_object_id_type>( id), node.location());
-                } else {
-                    m_storage_neg.set(static_cast<osmium::unsigned_object_id_type>(-id), node.location());
+            /**
+             * Store the locations of all nodes in the columns in the storage.
+             */
+            void node_columns(const osmium::io::NodeColumns& columns) {
+                for (std::size_t n = 0; n < columns.size(); ++n) {
+                    set_node_location(columns.id(n), columns.location(n));
                 }
             }
 
@@ -39,6 +39,10 @@ DEALINGS IN THE SOFTWARE.
  * Include this file if you want to read or write bzip2-compressed OSM
  * files.
  *
+ * Compression and decompression is done in parallel on the thread pool.
+ * The compressor writes one bzip2 stream per block, the decompressor
+ * splits the input at the block boundaries.
+ *
  * @attention If you include this file, you'll need to link with `libbz2`.
  */
 
@@ -51,12 +55,19 @@ DEALINGS IN THE SOFTWARE.
 
 #include <bzlib.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cerrno>
+#include <cstddef>
+#include <cstdint>
 #include <cstdio>
+#include <deque>
+#include <future>
 #include <limits>
+#include <memory>
 #include <string>
 #include <system_error>
+#include <utility>
 
 #ifndef _MSC_VER
 # include <unistd.h>
@@ -100,90 +111,255 @@ namespace osmium {
                 throw osmium::bzip2_error{error, errnum};
             }
 
-            class file_wrapper {
+            // Block size (in units of 100k) used for compression.
+            enum : int {
+                bzip2_block_size_100k = 6
+            };
 
-                FILE* m_file = nullptr;
+            enum : uint64_t {
+                bzip2_block_magic = 0x314159265359ULL,
+                bzip2_eos_magic   = 0x177245385090ULL
+            };
 
-            public:
+            inline bool is_bzip2_stream_header(const char* data) noexcept {
+                return data[0] == 'B' && data[1] == 'Z' && data[2] == 'h' &&
+                       data[3] >= '1' && data[3] <= '9';
+            }
 
-                file_wrapper() noexcept = default;
+            /**
+             * Get count (at most 64) bits starting at the specified bit
+             * position from the data, most significant bit first.
+             */
+            inline uint64_t get_bits(const std::string& data, const std::size_t bit, const unsigned int count) noexcept {
+                uint64_t result = 0;
+                for (std::size_t b = bit; b < bit + count; ++b) {
+                    result = (result << 1U) | ((static_cast<unsigned char>(data[b / 8]) >> (7U - b % 8)) & 1U);
+                }
+                return result;
+            }
 
-                file_wrapper(const int fd, const char* mode) {
-#ifdef _MSC_VER
-                    osmium::detail::disable_invalid_parameter_handler diph;
-#endif
-                    m_file = fdopen(fd, mode); // NOLINT(cppcoreguidelines-prefer-member-initializer)
-                    if (!m_file) {
+            /**
+             * Find the next block or end-of-stream magic number in bzip2
+             * data starting at or after the specified bit position. The
+             * magic numbers are not byte-aligned. Returns the bit position
+             * of the magic number or std::string::npos if there is none.
+             * Sets *eos if it is an end-of-stream magic number.
+             */
+            inline std::size_t find_bzip2_magic(const std::string& data, const std::size_t from_bit, bool* eos) noexcept {
+                const auto* d = reinterpret_cast<const unsigned char*>(data.data());
+                uint64_t window = 0;
+                unsigned int loaded = 0;
+                for (std::size_t i = from_bit / 8; i < data.size(); ++i) {
+                    window = (window << 8U) | d[i];
+                    loaded = std::min(loaded + 8U, 64U);
+                    if (loaded < 48) {
+                        continue;
+                    }
+                    // check the (up to) eight positions ending in this byte
+                    // in order of their start bit
+                    for (unsigned int k = std::min(loaded - 48U, 7U) + 1; k-- > 0;) {
+                        const std::size_t start = (i + 1) * 8 - 48 - k;
+                        if (start < from_bit) {
+                            continue;
+                        }
+                        const uint64_t value = (window >> k) & 0xffffffffffffULL;
+                        if (value == bzip2_block_magic || value == bzip2_eos_magic) {
+                            *eos = (value == bzip2_eos_magic);
+                            return start;
+                        }
+                    }
+                }
+                return std::string::npos;
+            }
+
+            class bit_writer {
+
+                std::string m_data;
+                unsigned int m_bits = 0;
+                unsigned int m_num_bits = 0;
+
+            public:
+
+                void reserve(const std::size_t size) {
+                    m_data.reserve(size);
+                }
 
-                        // Do not close stdout
-                        if (fd != 1) {
-                            ::close(fd);
+                void put(const uint64_t value, const unsigned int count) {
+                    for (unsigned int i = count; i > 0; --i) {
+                        m_bits = (m_bits << 1U) | static_cast<unsigned int>((value >> (i - 1)) & 1U);
+                        if (++m_num_bits == 8) {
+                            m_data += static_cast<char>(m_bits);
+                            m_bits = 0;
+                            m_num_bits = 0;
                         }
-                        throw std::system_error{errno, std::system_category(), "fdopen failed"};
                     }
                 }
 
-                file_wrapper(const file_wrapper&) = delete;
-                file_wrapper& operator=(const file_wrapper&) = delete;
+                /// Append whole bytes, only allowed at a byte boundary.
+                void put_byte(const unsigned char byte) {
+                    assert(m_num_bits == 0);
+                    m_data += static_cast<char>(byte);
+                }
 
-                file_wrapper(file_wrapper&&) = delete;
-                file_wrapper& operator=(file_wrapper&&) = delete;
+                std::string finish() {
+                    if (m_num_bits > 0) {
+                        m_data += static_cast<char>(m_bits << (8U - m_num_bits));
+                        m_bits = 0;
+                        m_num_bits = 0;
+                    }
+                    return std::move(m_data);
+                }
 
-                ~file_wrapper() noexcept {
-#ifdef _MSC_VER
-                    osmium::detail::disable_invalid_parameter_handler diph;
-#endif
-                    if (m_file) {
-                        (void)fclose(m_file);
+            }; // class bit_writer
+
+            /**
+             * Decompress a single bzip2 block. The block is given as the
+             * bits in the data starting at start_bit (the position of the
+             * block magic number). It is wrapped into a complete bzip2
+             * stream with the given block size level which is then
+             * decompressed.
+             */
+            inline std::string decompress_bzip2_block(const std::string& data, const std::size_t start_bit, const std::size_t num_bits, const char level) {
+                bit_writer writer;
+                writer.reserve(num_bits / 8 + 32);
+                writer.put_byte('B');
+                writer.put_byte('Z');
+                writer.put_byte('h');
+                writer.put_byte(static_cast<unsigned char>(level));
+
+                const auto* d = reinterpret_cast<const unsigned char*>(data.data()) + start_bit / 8;
+                const unsigned int shift = start_bit % 8;
+                const std::size_t num_bytes = num_bits / 8;
+                for (std::size_t i = 0; i < num_bytes; ++i) {
+                    writer.put_byte(shift == 0 ? d[i] : static_cast<unsigned char>((d[i] << shift) | (d[i + 1] >> (8U - shift))));
+                }
+                writer.put(get_bits(data, start_bit + num_bytes * 8, static_cast<unsigned int>(num_bits % 8)), static_cast<unsigned int>(num_bits % 8));
+
+                // With only one block, the stream CRC is the block CRC.
+                writer.put(bzip2_eos_magic, 48);
+                writer.put(get_bits(data, start_bit + 48, 32), 32);
+                std::string stream{writer.finish()};
+
+                bz_stream bzstream{};
+                int result = BZ2_bzDecompressInit(&bzstream, 0, 0);
+                if (result != BZ_OK) {
+                    throw bzip2_error{"bzip2 error: decompression init failed", result};
+                }
+
+                std::string output(static_cast<std::size_t>(level - '0') * 100000U, '\0');
+                bzstream.next_in = &stream[0];
+                bzstream.avail_in = static_cast<unsigned int>(stream.size());
+                bzstream.next_out = &output[0];
+                bzstream.avail_out = static_cast<unsigned int>(output.size());
+
+                while ((result = BZ2_bzDecompress(&bzstream)) == BZ_OK) {
+                    if (bzstream.avail_out > 0) {
+                        result = BZ_UNEXPECTED_EOF;
+                        break;
                     }
+                    const std::size_t done = output.size();
+                    output.resize(done * 2);
+                    bzstream.next_out = &output[done];
+                    bzstream.avail_out = static_cast<unsigned int>(output.size() - done);
                 }
+                output.resize(output.size() - bzstream.avail_out);
+                BZ2_bzDecompressEnd(&bzstream);
 
-                FILE* file() const noexcept {
-                    return m_file;
+                if (result != BZ_STREAM_END) {
+                    throw bzip2_error{"bzip2 error: decompress failed", result};
                 }
 
-                void close() {
-#ifdef _MSC_VER
-                    osmium::detail::disable_invalid_parameter_handler diph;
-#endif
-                    if (m_file) {
-                        FILE* wrapped_file = m_file;
-                        m_file = nullptr;
+                return output;
+            }
 
-                        // Do not close stdout
-                        if (fileno(wrapped_file) == 1) {
-                            return;
-                        }
+            /**
+             * Task for the thread pool decompressing a bzip2 block.
+             */
+            class Bzip2DecompressTask {
 
-                        if (fclose(wrapped_file) != 0) {
-                            throw std::system_error{errno, std::system_category(), "fclose failed"};
-                        }
+                std::shared_ptr<const std::string> m_data;
+                std::size_t m_start_bit;
+                std::size_t m_num_bits;
+                char m_level;
+
+            public:
+
+                Bzip2DecompressTask(std::shared_ptr<const std::string> data, const std::size_t start_bit, const std::size_t num_bits, const char level) :
+                    m_data(std::move(data)),
+                    m_start_bit(start_bit),
+                    m_num_bits(num_bits),
+                    m_level(level) {
+                }
+
+                std::string operator()() const {
+                    return decompress_bzip2_block(*m_data, m_start_bit, m_num_bits, m_level);
+                }
+
+            }; // class Bzip2DecompressTask
+
+            /**
+             * Task for the thread pool compressing data into a complete
+             * bzip2 stream.
+             */
+            class Bzip2CompressTask {
+
+                std::string m_input;
+
+            public:
+
+                explicit Bzip2CompressTask(std::string&& input) :
+                    m_input(std::move(input)) {
+                }
+
+                std::string operator()() {
+                    // Worst case size as documented for
+                    // BZ2_bzBuffToBuffCompress().
+                    std::string output(m_input.size() + m_input.size() / 100 + 600, '\0');
+                    assert(output.size() < std::numeric_limits<unsigned int>::max());
+                    auto size = static_cast<unsigned int>(output.size());
+                    const int result = BZ2_bzBuffToBuffCompress(&output[0], &size,
+                                                                &m_input[0],
+                                                                static_cast<unsigned int>(m_input.size()),
+                                                                bzip2_block_size_100k, 0, 0);
+                    if (result != BZ_OK) {
+                        throw bzip2_error{"bzip2 error: compression failed", result};
                     }
+                    output.resize(size);
+                    return output;
                 }
 
-            }; // class file_wrapper
+            }; // class Bzip2CompressTask
 
         } // namespace detail
 
         class Bzip2Compressor final : public Compressor {
 
             std::size_t m_file_size = 0;
-            detail::file_wrapper m_file;
-            BZFILE* m_bzfile = nullptr;
+            int m_fd;
+            bool m_closed = false;
+            std::string m_pending;
+            std::deque<std::future<std::string>> m_compressed;
+
+            void submit_stream(std::string&& data) {
+                m_compressed.push_back(pool().submit(detail::Bzip2CompressTask{std::move(data)}));
+            }
+
+            // Write out compressed data until there are at most
+            // max_in_flight compression tasks left.
+            void write_streams(const std::size_t max_in_flight) {
+                while (m_compressed.size() > max_in_flight) {
+                    const std::string data{m_compressed.front().get()};
+                    m_compressed.pop_front();
+                    osmium::io::detail::reliable_write(m_fd, data.data(), data.size());
+                    m_file_size += data.size();
+                }
+            }
 
         public:
 
             explicit Bzip2Compressor(const int fd, const fsync sync) :
                 Compressor(sync),
-                m_file(fd, "wb") {
-#ifdef _MSC_VER
-                osmium::detail::disable_invalid_parameter_handler diph;
-#endif
-                int bzerror = BZ_OK;
-                m_bzfile = ::BZ2_bzWriteOpen(&bzerror, m_file.file(), 6, 0, 0);
-                if (!m_bzfile) {
-                    throw bzip2_error{"bzip2 error: write open failed", bzerror};
-                }
+                m_fd(fd) {
             }
 
             Bzip2Compressor(const Bzip2Compressor&) = delete;
@@ -201,37 +377,45 @@ namespace osmium {
             }
 
             void write(const std::string& data) override {
-                assert(data.size() < std::numeric_limits<int>::max());
-                assert(m_bzfile);
-#ifdef _MSC_VER
-                osmium::detail::disable_invalid_parameter_handler diph;
-#endif
-                int bzerror = BZ_OK;
-                ::BZ2_bzWrite(&bzerror, m_bzfile, const_cast<char*>(data.data()), static_cast<int>(data.size()));
-                if (bzerror != BZ_OK && bzerror != BZ_STREAM_END) {
-                    detail::throw_bzip2_error(m_bzfile, "write failed", bzerror);
+                assert(!m_closed);
+
+                // Each task compresses one block into a complete bzip2
+                // stream. The streams are written one after the other
+                // into the file, which is allowed by the format.
+                constexpr const std::size_t stream_size = static_cast<std::size_t>(detail::bzip2_block_size_100k) * 100000U;
+                m_pending.append(data);
+                std::size_t pos = 0;
+                for (; m_pending.size() - pos >= stream_size; pos += stream_size) {
+                    submit_stream(m_pending.substr(pos, stream_size));
                 }
+                m_pending.erase(0, pos);
+
+                write_streams(2 * static_cast<std::size_t>(pool().num_threads()));
             }
 
             void close() override {
-                if (m_bzfile) {
-#ifdef _MSC_VER
-                    osmium::detail::disable_invalid_parameter_handler diph;
-#endif
-                    int bzerror = BZ_OK;
-                    unsigned int nbytes_out_lo32 = 0;
-                    unsigned int nbytes_out_hi32 = 0;
-                    ::BZ2_bzWriteClose64(&bzerror, m_bzfile, 0, nullptr, nullptr, &nbytes_out_lo32, &nbytes_out_hi32);
-                    m_bzfile = nullptr;
-                    if (do_fsync() && m_file.file()) {
-                        osmium::io::detail::reliable_fsync(fileno(m_file.file()));
-                    }
-                    m_file.close();
-                    if (bzerror != BZ_OK) {
-                        throw bzip2_error{"bzip2 error: write close failed", bzerror};
-                    }
-                    m_file_size = static_cast<std::size_t>(static_cast<uint64_t>(nbytes_out_hi32) << 32U | nbytes_out_lo32);
+                if (m_closed) {
+                    return;
                 }
+                m_closed = true;
+
+                // Do not sync or close stdout
+                osmium::io::detail::fd_close_guard guard{m_fd == 1 ? -1 : m_fd};
+
+                // An empty file still gets one (empty) stream.
+                if (!m_pending.empty() || (m_compressed.empty() && m_file_size == 0)) {
+                    submit_stream(std::move(m_pending));
+                }
+                write_streams(0);
+
+                if (m_fd == 1) {
+                    return;
+                }
+
+                if (do_fsync()) {
+                    osmium::io::detail::reliable_fsync(m_fd);
+                }
+                osmium::io::detail::reliable_close(guard.release());
             }
 
             std::size_t file_size() const override {
@@ -242,22 +426,230 @@ namespace osmium {
 
         class Bzip2Decompressor final : public Decompressor {
 
-            detail::file_wrapper m_file;
-            BZFILE* m_bzfile = nullptr;
-            bool m_stream_end = false;
+            int m_fd;
+
+            // Data read from the file and not yet handed to the pool.
+            std::string m_input;
+
+            // Offset in the file of the first byte in m_input.
+            std::size_t m_input_offset = 0;
+
+            bool m_input_eof = false;
+
+            // Set once the header of the first stream has been seen.
+            bool m_had_stream = false;
+
+            enum class scan_state {
+                stream_header,
+                block,
+                done
+            } m_state = scan_state::stream_header;
+
+            // Bit position in m_input of the block magic of the current
+            // block or npos if the current stream has no block yet.
+            std::size_t m_block_start = std::string::npos;
+
+            // Bit position in m_input where to continue scanning.
+            std::size_t m_scan_pos = 0;
+
+            // Block size level from the header of the current stream.
+            char m_level = '9';
+
+            // Checksum calculated from the block checksums in the
+            // current stream.
+            uint32_t m_stream_crc = 0;
+
+            struct bzip2_block {
+                std::future<std::string> data;
+                std::shared_ptr<const std::string> compressed;
+                std::size_t start_bit = 0;
+                std::size_t num_bits = 0;
+                std::size_t end_offset = 0;
+                uint32_t crc = 0;
+                char level = '9';
+                bool stream_end = false;
+            };
+
+            std::deque<bzip2_block> m_blocks;
+
+            bool fill_input() {
+                if (m_input_eof) {
+                    return false;
+                }
+                std::string buffer(osmium::io::Decompressor::input_buffer_size, '\0');
+                const auto nread = osmium::io::detail::reliable_read(m_fd, &*buffer.begin(), static_cast<unsigned int>(buffer.size()));
+                if (nread == 0) {
+                    m_input_eof = true;
+                    return false;
+                }
+                m_input.append(buffer.data(), static_cast<std::size_t>(nread));
+                return true;
+            }
+
+            void submit_block(const std::size_t start_bit, const std::size_t end_bit) {
+                const std::size_t first_byte = start_bit / 8;
+                const std::size_t end_byte = (end_bit + 7) / 8;
+
+                bzip2_block block;
+                block.compressed = std::make_shared<const std::string>(m_input, first_byte, end_byte - first_byte);
+                block.start_bit = start_bit - first_byte * 8;
+                block.num_bits = end_bit - start_bit;
+                block.end_offset = m_input_offset + end_bit / 8;
+                block.crc = static_cast<uint32_t>(detail::get_bits(m_input, start_bit + 48, 32));
+                block.level = m_level;
+                block.data = pool().submit(detail::Bzip2DecompressTask{block.compressed, block.start_bit, block.num_bits, block.level});
+                m_blocks.push_back(std::move(block));
+            }
+
+            // Remove data from the input buffer that is not needed any
+            // more.
+            void discard_input() {
+                const std::size_t keep = (m_state == scan_state::block && m_block_start != std::string::npos) ? m_block_start : m_scan_pos;
+                const std::size_t bytes = std::min(keep / 8, m_input.size());
+                m_input.erase(0, bytes);
+                m_input_offset += bytes;
+                m_scan_pos -= bytes * 8;
+                if (m_block_start != std::string::npos) {
+                    m_block_start -= bytes * 8;
+                }
+            }
+
+            // Is the end-of-stream magic number at this bit position
+            // really the end of the stream? It could also be a random
+            // bit pattern in the compressed data. It is real if it is
+            // followed by the header of the next stream or the end of
+            // the file.
+            bool is_stream_end(const std::size_t pos) {
+                const std::size_t next = (pos + 48 + 32 + 7) / 8;
+                while (m_input.size() < next + 4 && fill_input()) {
+                }
+                if (m_input.size() == next) {
+                    return m_input_eof;
+                }
+                return m_input.size() >= next + 4 && detail::is_bzip2_stream_header(&m_input[next]);
+            }
+
+            // Scan the input for the next block or end of stream and add
+            // it to m_blocks. Returns false if there is nothing more.
+            bool scan() {
+                while (m_state == scan_state::stream_header) {
+                    const std::size_t pos = m_scan_pos / 8;
+                    while (m_input.size() < pos + 10 && fill_input()) {
+                    }
+                    if (m_input.size() == pos && m_had_stream) {
+                        m_state = scan_state::done;
+                        return false;
+                    }
+                    if (m_input.size() < pos + 10) {
+                        throw bzip2_error{"bzip2 error: read failed: unexpected end of file", BZ_UNEXPECTED_EOF};
+                    }
+                    const uint64_t magic = detail::get_bits(m_input, (pos + 4) * 8, 48);
+                    if (!detail::is_bzip2_stream_header(&m_input[pos]) ||
+                        (magic != detail::bzip2_block_magic && magic != detail::bzip2_eos_magic)) {
+                        throw bzip2_error{"bzip2 error: read failed: not a bzip2 stream", BZ_DATA_ERROR_MAGIC};
+                    }
+                    m_had_stream = true;
+                    m_level = m_input[pos + 3];
+                    m_scan_pos = (pos + 4) * 8;
+                    m_block_start = std::string::npos;
+                    m_state = scan_state::block;
+                }
+
+                while (m_state == scan_state::block) {
+                    bool eos = false;
+                    const std::size_t pos = detail::find_bzip2_magic(m_input, m_scan_pos, &eos);
+
+                    if (pos == std::string::npos) {
+                        const std::size_t scanned_bits = m_input.size() * 8;
+                        if (fill_input()) {
+                            m_scan_pos = std::max(m_scan_pos, scanned_bits > 47 ? scanned_bits - 47 : 0);
+                            continue;
+                        }
+                        // Truncated file: the block extends to the end
+                        // of the file, decompressing it will fail.
+                        if (m_block_start != std::string::npos) {
+                            submit_block(m_block_start, m_input.size() * 8);
+                        }
+                        m_state = scan_state::done;
+                        return m_block_start != std::string::npos;
+                    }
+
+                    if (!eos) {
+                        if (m_block_start != std::string::npos) {
+                            submit_block(m_block_start, pos);
+                        }
+                        const bool submitted = m_block_start != std::string::npos;
+                        m_block_start = pos;
+                        m_scan_pos = pos + 48;
+                        discard_input();
+                        if (submitted) {
+                            return true;
+                        }
+                        continue;
+                    }
+
+                    if (!is_stream_end(pos)) {
+                        m_scan_pos = pos + 1;
+                        continue;
+                    }
+
+                    if (m_block_start != std::string::npos) {
+                        submit_block(m_block_start, pos);
+                    }
+
+                    bzip2_block block;
+                    block.crc = static_cast<uint32_t>(detail::get_bits(m_input, pos + 48, 32));
+                    block.end_offset = m_input_offset + (pos + 48 + 32 + 7) / 8;
+                    block.stream_end = true;
+                    m_blocks.push_back(std::move(block));
+
+                    m_scan_pos = (pos + 48 + 32 + 7) / 8 * 8;
+                    m_block_start = std::string::npos;
+                    m_state = scan_state::stream_header;
+                    discard_input();
+                    return true;
+                }
+
+                return false;
+            }
+
+            // Get decompressed data of a block. A block magic number can
+            // appear by chance inside the compressed data. In that case
+            // the data was split in the wrong place and decompression
+            // fails. Try again with the data merged with the following
+            // blocks.
+            std::string get_block(bzip2_block& block) {
+                try {
+                    return block.data.get();
+                } catch (const bzip2_error&) {
+                    std::string data{*block.compressed};
+                    std::size_t num_bits = block.num_bits;
+                    for (int merged = 0; merged < 2; ++merged) {
+                        if (m_blocks.empty() && m_state != scan_state::done) {
+                            scan();
+                        }
+                        if (m_blocks.empty() || m_blocks.front().stream_end) {
+                            break;
+                        }
+                        const bzip2_block next{std::move(m_blocks.front())};
+                        m_blocks.pop_front();
+                        data.resize((block.start_bit + num_bits) / 8);
+                        data += *next.compressed;
+                        num_bits += next.num_bits;
+                        block.end_offset = next.end_offset;
+                        try {
+                            return detail::decompress_bzip2_block(data, block.start_bit, num_bits, block.level);
+                        } catch (const bzip2_error&) {
+                        }
+                    }
+                    throw;
+                }
+            }
 
         public:
 
             explicit Bzip2Decompressor(const int fd) :
-                m_file(fd, "rb") {
-#ifdef _MSC_VER
-                osmium::detail::disable_invalid_parameter_handler diph;
-#endif
-                int bzerror = BZ_OK;
-                m_bzfile = ::BZ2_bzReadOpen(&bzerror, m_file.file(), 0, 0, nullptr, 0);
-                if (!m_bzfile) {
-                    throw bzip2_error{"bzip2 error: read open failed", bzerror};
-                }
+                m_fd(fd) {
             }
 
             Bzip2Decompressor(const Bzip2Decompressor&) = delete;
@@ -275,69 +667,57 @@ namespace osmium {
             }
 
             std::string read() override {
-                const auto offset = ftell(m_file.file());
-                if (offset > 0 && want_buffered_pages_removed()) {
-                    osmium::io::detail::remove_buffered_pages(fileno(m_file.file()), static_cast<std::size_t>(offset));
-                }
-#ifdef _MSC_VER
-                osmium::detail::disable_invalid_parameter_handler diph;
-#endif
-                assert(m_bzfile);
-                std::string buffer;
-
-                if (!m_stream_end) {
-                    buffer.resize(osmium::io::Decompressor::input_buffer_size);
-                    int bzerror = BZ_OK;
-                    assert(buffer.size() < std::numeric_limits<int>::max());
-                    const int nread = ::BZ2_bzRead(&bzerror, m_bzfile, &*buffer.begin(), static_cast<int>(buffer.size()));
-                    if (bzerror != BZ_OK && bzerror != BZ_STREAM_END) {
-                        detail::throw_bzip2_error(m_bzfile, "read failed", bzerror);
+                const auto max_in_flight = 2 * static_cast<std::size_t>(pool().num_threads());
+
+                while (true) {
+                    while (m_state != scan_state::done && m_blocks.size() < max_in_flight) {
+                        if (!scan()) {
+                            break;
+                        }
                     }
-                    if (bzerror == BZ_STREAM_END) {
-                        void* unused = nullptr;
-                        int nunused = 0;
-                        if (!feof(m_file.file())) {
-                            ::BZ2_bzReadGetUnused(&bzerror, m_bzfile, &unused, &nunused);
-                            if (bzerror != BZ_OK) {
-                                detail::throw_bzip2_error(m_bzfile, "get unused failed", bzerror);
-                            }
-                            std::string unused_data{static_cast<const char*>(unused), static_cast<std::string::size_type>(nunused)};
-                            ::BZ2_bzReadClose(&bzerror, m_bzfile);
-                            if (bzerror != BZ_OK) {
-                                throw bzip2_error{"bzip2 error: read close failed", bzerror};
-                            }
-                            assert(unused_data.size() < std::numeric_limits<int>::max());
-                            m_bzfile = ::BZ2_bzReadOpen(&bzerror, m_file.file(), 0, 0, &*unused_data.begin(), static_cast<int>(unused_data.size()));
-                            if (!m_bzfile) {
-                                throw bzip2_error{"bzip2 error: read open failed", bzerror};
-                            }
-                        } else {
-                            m_stream_end = true;
+
+                    if (m_blocks.empty()) {
+                        return std::string{};
+                    }
+
+                    bzip2_block block{std::move(m_blocks.front())};
+                    m_blocks.pop_front();
+
+                    if (block.stream_end) {
+                        if (block.crc != m_stream_crc) {
+                            throw bzip2_error{"bzip2 error: read failed: stream checksum mismatch", BZ_DATA_ERROR};
                         }
+                        m_stream_crc = 0;
+                        set_offset(block.end_offset);
+                        continue;
                     }
-                    buffer.resize(static_cast<std::string::size_type>(nread));
-                }
 
-                set_offset(static_cast<std::size_t>(ftell(m_file.file())));
+                    std::string output{get_block(block)};
+                    m_stream_crc = ((m_stream_crc << 1U) | (m_stream_crc >> 31U)) ^ block.crc;
 
-                return buffer;
+                    if (want_buffered_pages_removed()) {
+                        osmium::io::detail::remove_buffered_pages(m_fd, block.end_offset);
+                    }
+                    set_offset(block.end_offset);
+
+                    if (!output.empty()) {
+                        return output;
+                    }
+                }
             }
 
             void close() override {
-                if (m_bzfile) {
+                if (m_fd >= 0) {
+                    // Tasks still running on the pool own their data, so
+                    // the futures can be dropped here.
+                    m_blocks.clear();
+                    m_state = scan_state::done;
                     if (want_buffered_pages_removed()) {
-                        osmium::io::detail::remove_buffered_pages(fileno(m_file.file()));
-                    }
-#ifdef _MSC_VER
-                    osmium::detail::disable_invalid_parameter_handler diph;
-#endif
-                    int bzerror = BZ_OK;
-                    ::BZ2_bzReadClose(&bzerror, m_bzfile);
-                    m_bzfile = nullptr;
-                    m_file.close();
-                    if (bzerror != BZ_OK) {
-                        throw bzip2_error{"bzip2 error: read close failed", bzerror};
+                        osmium::io::detail::remove_buffered_pages(m_fd);
                     }
+                    const int fd = m_fd;
+                    m_fd = -1;
+                    osmium::io::detail::reliable_close(fd);
                 }
             }
 
@@ -381,12 +761,29 @@ namespace osmium {
             std::string read() override {
                 std::string output;
 
-                if (m_buffer) {
+                // Loop until there is some output, because an empty
+                // string signals the end of the data. Streams can be
+                // empty.
+                while (m_buffer && output.empty()) {
                     const std::size_t buffer_size = 10240;
                     output.resize(buffer_size);
                     m_bzstream.next_out = &*output.begin();
                     m_bzstream.avail_out = buffer_size;
-                    const int result = BZ2_bzDecompress(&m_bzstream);
+                    int result = BZ2_bzDecompress(&m_bzstream);
+
+                    // Another stream follows.
+                    if (result == BZ_STREAM_END && m_bzstream.avail_in >= 4 &&
+                        detail::is_bzip2_stream_header(m_bzstream.next_in)) {
+                        char* next_in = m_bzstream.next_in;
+                        const unsigned int avail_in = m_bzstream.avail_in;
+                        char* next_out = m_bzstream.next_out;
+                        BZ2_bzDecompressEnd(&m_bzstream);
+                        m_bzstream = bz_stream{};
+                        m_bzstream.next_in = next_in;
+                        m_bzstream.avail_in = avail_in;
+                        m_bzstream.next_out = next_out;
+                        result = BZ2_bzDecompressInit(&m_bzstream, 0, 0);
+                    }
 
                     if (result != BZ_OK) {
                         m_buffer = nullptr;
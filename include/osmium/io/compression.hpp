@@ -33,11 +33,16 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/io/detail/direct_write.hpp>
+#include <osmium/io/detail/read_ahead.hpp>
 #include <osmium/io/detail/read_write.hpp>
 #include <osmium/io/error.hpp>
 #include <osmium/io/file_compression.hpp>
 #include <osmium/io/writer_options.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/util/config.hpp>
 #include <osmium/util/file.hpp>
+#include <osmium/util/options.hpp>
 
 #include <atomic>
 #include <cerrno>
@@ -58,12 +63,23 @@ namespace osmium {
 
             fsync m_fsync;
 
+            osmium::thread::Pool* m_pool = nullptr;
+
         protected:
 
             bool do_fsync() const noexcept {
                 return m_fsync == fsync::yes;
             }
 
+            /**
+             * The thread pool compressors can use to compress data in
+             * parallel. This is the pool set with set_pool() or the
+             * default pool.
+             */
+            osmium::thread::Pool& pool() const {
+                return m_pool ? *m_pool : osmium::thread::Pool::default_instance();
+            }
+
         public:
 
             explicit Compressor(const fsync sync) noexcept :
@@ -78,6 +94,23 @@ namespace osmium {
 
             virtual ~Compressor() noexcept = default;
 
+            /**
+             * Set the thread pool used by compressors that can compress
+             * in parallel. Must be called before the first write().
+             */
+            void set_pool(osmium::thread::Pool& pool) noexcept {
+                m_pool = &pool;
+            }
+
+            /**
+             * Called by the Writer with the options of the output file
+             * before the first write(). Compressors can use this to
+             * select compression settings. The default implementation
+             * ignores all options.
+             */
+            virtual void set_options(const osmium::Options& /*options*/) {
+            }
+
             virtual void write(const std::string& data) = 0;
 
             virtual void close() = 0;
@@ -94,6 +127,20 @@ namespace osmium {
 
             std::atomic_bool m_want_buffered_pages_removed{false};
 
+            std::atomic<osmium::thread::Pool*> m_pool{nullptr};
+
+        protected:
+
+            /**
+             * The thread pool decompressors can use to decompress data in
+             * parallel. This is the pool set with set_pool() or the
+             * default pool.
+             */
+            osmium::thread::Pool& pool() const {
+                osmium::thread::Pool* pool = m_pool;
+                return pool ? *pool : osmium::thread::Pool::default_instance();
+            }
+
         public:
 
             enum {
@@ -136,6 +183,16 @@ namespace osmium {
                 m_want_buffered_pages_removed = value;
             }
 
+            /**
+             * Set the thread pool used by decompressors that can
+             * decompress in parallel. This can be called while the
+             * decompressor is already in use, the new pool is used
+             * for all tasks submitted after that.
+             */
+            void set_pool(osmium::thread::Pool& pool) noexcept {
+                m_pool = &pool;
+            }
+
         }; // class Decompressor
 
         /**
@@ -229,6 +286,7 @@ namespace osmium {
 
             std::size_t m_file_size = 0;
             int m_fd;
+            std::unique_ptr<osmium::io::detail::direct_writer> m_direct_writer;
 
         public:
 
@@ -251,8 +309,24 @@ namespace osmium {
                 }
             }
 
+            /**
+             * If the file option "direct_io" is set, data is collected
+             * into large buffers which are written out by a separate
+             * thread bypassing the page cache if possible. See
+             * osmium::io::detail::direct_writer for details.
+             */
+            void set_options(const osmium::Options& options) override {
+                if (options.is_true("direct_io") && m_fd >= 0 && !m_direct_writer) {
+                    m_direct_writer.reset(new osmium::io::detail::direct_writer{m_fd});
+                }
+            }
+
             void write(const std::string& data) override {
-                osmium::io::detail::reliable_write(m_fd, data.data(), data.size());
+                if (m_direct_writer) {
+                    m_direct_writer->write(data.data(), data.size());
+                } else {
+                    osmium::io::detail::reliable_write(m_fd, data.data(), data.size());
+                }
                 m_file_size += data.size();
             }
 
@@ -262,6 +336,13 @@ namespace osmium {
                     m_fd = -1;
 
                     // Do not sync or close stdout
+                    osmium::io::detail::fd_close_guard guard{fd == 1 ? -1 : fd};
+
+                    if (m_direct_writer) {
+                        const std::unique_ptr<osmium::io::detail::direct_writer> writer{std::move(m_direct_writer)};
+                        writer->close();
+                    }
+
                     if (fd == 1) {
                         return;
                     }
@@ -269,7 +350,7 @@ namespace osmium {
                     if (do_fsync()) {
                         osmium::io::detail::reliable_fsync(fd);
                     }
-                    osmium::io::detail::reliable_close(fd);
+                    osmium::io::detail::reliable_close(guard.release());
                 }
             }
 
@@ -316,11 +397,13 @@ namespace osmium {
             const char* m_buffer = nullptr;
             std::size_t m_buffer_size = 0;
             std::size_t m_offset = 0;
+            osmium::io::detail::read_ahead m_read_ahead;
 
         public:
 
             explicit NoDecompressor(const int fd) :
-                m_fd(fd) {
+                m_fd(fd),
+                m_read_ahead(fd, osmium::config::get_read_ahead_bytes()) {
             }
 
             NoDecompressor(const char* buffer, const std::size_t size) :
@@ -358,6 +441,7 @@ namespace osmium {
                     }
                     const auto nread = detail::reliable_read(m_fd, &*buffer.begin(), osmium::io::Decompressor::input_buffer_size);
                     buffer.resize(std::string::size_type(nread));
+                    m_read_ahead.advance(buffer.size());
                 }
 
                 m_offset += buffer.size();
@@ -583,7 +583,8 @@ namespace osmium {
                 }
 
                 void write_buffer(osmium::memory::Buffer&& buffer) final {
-                    m_output_queue.push(m_pool.submit(DebugOutputBlock{std::move(buffer), m_options}));
+                    const auto size = buffer.committed();
+                    send_to_output_queue(submit(DebugOutputBlock{std::move(buffer), m_options}), size);
                 }
 
             }; // class DebugOutputFormat
@@ -0,0 +1,320 @@
+#ifndef OSMIUM_IO_DETAIL_DIRECT_WRITE_HPP
+#define OSMIUM_IO_DETAIL_DIRECT_WRITE_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2023 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/thread/util.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <fcntl.h>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+
+#ifdef __linux__
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            /**
+             * Collects written data into large aligned buffers and writes
+             * them out from a separate thread, so that the next buffer can
+             * be filled while the last one is written (double buffering).
+             *
+             * On Linux the file is switched to O_DIRECT if it is a regular
+             * file and the filesystem supports it, so the data doesn't go
+             * through the page cache at all. If O_DIRECT is not available,
+             * writeback of each buffer is started with sync_file_range()
+             * and the pages of the buffer before it are waited for and then
+             * removed from the page cache. Either way writing huge files
+             * doesn't evict everything else from the page cache and the
+             * amount of dirty data stays bounded.
+             *
+             * This doesn't do an fsync() on close(), that's up to the user.
+             */
+            class direct_writer {
+
+                enum : std::size_t {
+                    alignment = 4096,
+                    buffer_size = 8UL * 1024UL * 1024UL
+                };
+
+                struct aligned_buffer {
+                    std::unique_ptr<char[]> memory{new char[buffer_size + alignment]};
+                    char* data = memory.get() + (alignment - reinterpret_cast<std::uintptr_t>(memory.get()) % alignment) % alignment;
+                    std::size_t size = 0;
+                }; // struct aligned_buffer
+
+                aligned_buffer m_buffers[2];
+
+                // The buffer currently being filled.
+                aligned_buffer* m_current = &m_buffers[0];
+
+                int m_fd;
+
+                // Is O_DIRECT set on the file descriptor?
+                bool m_direct = false;
+
+                // File status flags before O_DIRECT was set.
+                int m_flags = -1;
+
+                // Is this a regular file? (Only for those we use
+                // sync_file_range() and posix_fadvise().)
+                bool m_regular = false;
+
+                // File offset of the next buffer to be written out and
+                // of the last buffer written out. Only used in the flush
+                // thread and, after it has ended, in close().
+                std::size_t m_offset = 0;
+                std::size_t m_last_offset = 0;
+                std::size_t m_last_size = 0;
+
+                std::mutex m_mutex;
+                std::condition_variable m_cv;
+                aligned_buffer* m_pending = nullptr;
+                bool m_done = false;
+                std::exception_ptr m_error;
+
+                std::thread m_thread;
+
+                void disable_direct_io() {
+#ifdef __linux__
+                    if (::fcntl(m_fd, F_SETFL, m_flags) == -1) {
+                        throw std::system_error{errno, std::system_category(), "Clearing O_DIRECT failed"};
+                    }
+#endif
+                    m_direct = false;
+                }
+
+                void write_out(const char* data, const std::size_t size) {
+                    try {
+                        reliable_write(m_fd, data, size);
+                    } catch (const std::system_error& e) {
+                        // Some filesystems accept O_DIRECT when it is set
+                        // but not the writes. Write buffered in that case.
+                        if (!m_direct || e.code().value() != EINVAL) {
+                            throw;
+                        }
+                        disable_direct_io();
+#ifdef __linux__
+                        if (::lseek(m_fd, static_cast<off_t>(m_offset), SEEK_SET) == -1) {
+                            throw std::system_error{errno, std::system_category(), "Seek failed"};
+                        }
+#endif
+                        reliable_write(m_fd, data, size);
+                    }
+
+#ifdef __linux__
+                    if (m_regular && !m_direct) {
+                        // Start writeback of the data just written, then
+                        // wait for the writeback of the data written
+                        // before that and remove it from the page cache.
+                        ::sync_file_range(m_fd, static_cast<off_t>(m_offset), static_cast<off_t>(size), SYNC_FILE_RANGE_WRITE);
+                        if (m_last_size > 0) {
+                            ::sync_file_range(m_fd, static_cast<off_t>(m_last_offset), static_cast<off_t>(m_last_size),
+                                              SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER); // NOLINT(hicpp-signed-bitwise)
+                            ::posix_fadvise(m_fd, static_cast<off_t>(m_last_offset), static_cast<off_t>(m_last_size), POSIX_FADV_DONTNEED);
+                        }
+                    }
+#endif
+
+                    m_last_offset = m_offset;
+                    m_last_size = size;
+                    m_offset += size;
+                }
+
+                void flush_thread() {
+                    osmium::thread::set_thread_name("_osmium_flush");
+
+                    std::unique_lock<std::mutex> lock{m_mutex};
+                    while (true) {
+                        m_cv.wait(lock, [this]() {
+                            return m_pending || m_done;
+                        });
+                        if (!m_pending) {
+                            return;
+                        }
+                        aligned_buffer* buffer = m_pending;
+                        if (!m_error) {
+                            lock.unlock();
+                            try {
+                                write_out(buffer->data, buffer->size);
+                            } catch (...) {
+                                lock.lock();
+                                m_error = std::current_exception();
+                                lock.unlock();
+                            }
+                            lock.lock();
+                        }
+                        buffer->size = 0;
+                        m_pending = nullptr;
+                        m_cv.notify_all();
+                    }
+                }
+
+                // Wait until the flush thread is ready for the next
+                // buffer. Rethrows any error from an earlier write.
+                void wait_for_flush(std::unique_lock<std::mutex>& lock) {
+                    m_cv.wait(lock, [this]() {
+                        return m_pending == nullptr;
+                    });
+                    if (m_error) {
+                        std::rethrow_exception(m_error);
+                    }
+                }
+
+                void submit_current() {
+                    std::unique_lock<std::mutex> lock{m_mutex};
+                    wait_for_flush(lock);
+                    m_pending = m_current;
+                    m_current = m_current == &m_buffers[0] ? &m_buffers[1] : &m_buffers[0];
+                    m_cv.notify_all();
+                }
+
+                void stop_thread() {
+                    {
+                        const std::lock_guard<std::mutex> lock{m_mutex};
+                        m_done = true;
+                    }
+                    m_cv.notify_all();
+                    if (m_thread.joinable()) {
+                        m_thread.join();
+                    }
+                }
+
+            public:
+
+                explicit direct_writer(const int fd) :
+                    m_fd(fd) {
+#ifdef __linux__
+                    struct stat s; // NOLINT(cppcoreguidelines-pro-type-member-init,hicpp-member-init)
+                    if (::fstat(fd, &s) == 0 && S_ISREG(s.st_mode)) { // NOLINT(hicpp-signed-bitwise)
+                        m_regular = true;
+                        const auto offset = ::lseek(fd, 0, SEEK_CUR);
+                        if (offset >= 0) {
+                            m_offset = static_cast<std::size_t>(offset);
+                        }
+# ifdef O_DIRECT
+                        // O_DIRECT needs aligned file offsets.
+                        if (offset >= 0 && m_offset % alignment == 0) {
+                            m_flags = ::fcntl(fd, F_GETFL);
+                            m_direct = m_flags != -1 && ::fcntl(fd, F_SETFL, m_flags | O_DIRECT) != -1; // NOLINT(hicpp-signed-bitwise)
+                        }
+# endif
+                    }
+#endif
+                    m_thread = std::thread{&direct_writer::flush_thread, this};
+                }
+
+                direct_writer(const direct_writer&) = delete;
+                direct_writer& operator=(const direct_writer&) = delete;
+
+                direct_writer(direct_writer&&) = delete;
+                direct_writer& operator=(direct_writer&&) = delete;
+
+                ~direct_writer() noexcept {
+                    stop_thread();
+#ifdef __linux__
+                    // If close() wasn't called or failed, the file might
+                    // still have O_DIRECT set.
+                    if (m_direct) {
+                        ::fcntl(m_fd, F_SETFL, m_flags);
+                    }
+#endif
+                }
+
+                /// Is O_DIRECT used for writing?
+                bool direct_io() const noexcept {
+                    return m_direct;
+                }
+
+                void write(const char* data, std::size_t size) {
+                    while (size > 0) {
+                        const auto n = std::min(size, buffer_size - m_current->size);
+                        std::memcpy(m_current->data + m_current->size, data, n);
+                        m_current->size += n;
+                        data += n;
+                        size -= n;
+                        if (m_current->size == buffer_size) {
+                            submit_current();
+                        }
+                    }
+                }
+
+                /**
+                 * Write out all remaining data and stop the flush thread.
+                 * The file descriptor is not closed, but its original
+                 * flags are restored.
+                 */
+                void close() {
+                    {
+                        std::unique_lock<std::mutex> lock{m_mutex};
+                        wait_for_flush(lock);
+                    }
+                    stop_thread();
+
+                    // The tail of the file is generally not a multiple
+                    // of the alignment, so write it without O_DIRECT.
+                    if (m_direct) {
+                        disable_direct_io();
+                    }
+
+                    if (m_current->size > 0) {
+                        write_out(m_current->data, m_current->size);
+                        m_current->size = 0;
+                    }
+                }
+
+            }; // class direct_writer
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_DIRECT_WRITE_HPP
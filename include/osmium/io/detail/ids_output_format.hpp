@@ -138,7 +138,8 @@ namespace osmium {
                 }
 
                 void write_buffer(osmium::memory::Buffer&& buffer) final {
-                    m_output_queue.push(m_pool.submit(IDSOutputBlock{std::move(buffer), m_options}));
+                    const auto size = buffer.committed();
+                    send_to_output_queue(submit(IDSOutputBlock{std::move(buffer), m_options}), size);
                 }
 
             }; // class IDSOutputFormat
@@ -38,11 +38,18 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/io/file.hpp>
 #include <osmium/io/file_format.hpp>
 #include <osmium/io/header.hpp>
+#include <osmium/io/pipeline_stats.hpp>
 #include <osmium/memory/buffer.hpp>
+#include <osmium/memory/buffer_recycler.hpp>
+#include <osmium/osm/box.hpp>
 #include <osmium/osm/entity_bits.hpp>
+#include <osmium/osm/metadata_options.hpp>
+#include <osmium/tags/tags_filter.hpp>
 #include <osmium/thread/pool.hpp>
+#include <osmium/util/tracer.hpp>
 
 #include <array>
+#include <chrono>
 #include <exception>
 #include <functional>
 #include <future>
@@ -67,6 +74,15 @@ namespace osmium {
                 osmium::io::read_meta read_metadata;
                 osmium::io::buffers_type buffers_kind;
                 bool want_buffered_pages_removed;
+                osmium::io::read_mmap use_mmap;
+                osmium::io::blob_range range;
+                osmium::Box bbox;
+                std::shared_ptr<osmium::memory::detail::recycler_handle> recycler;
+                osmium::io::read_fields::type read_which_fields;
+                osmium::metadata_options read_metadata_options;
+                std::shared_ptr<const osmium::TagsFilter> tags_filter;
+                osmium::io::read_order order;
+                std::shared_ptr<pipeline_counters> counters;
             };
 
             class Parser {
@@ -74,11 +90,37 @@ namespace osmium {
                 osmium::thread::Pool& m_pool;
                 future_buffer_queue_type& m_output_queue;
                 std::promise<osmium::io::Header>& m_header_promise;
-                queue_wrapper<std::string> m_input_queue;
+                queue_wrapper<std::string, future_string_queue_type> m_input_queue;
                 osmium::osm_entity_bits::type m_read_which_entities;
                 osmium::io::read_meta m_read_metadata;
+                osmium::io::read_fields::type m_read_which_fields;
+                osmium::metadata_options m_read_metadata_options;
+                std::shared_ptr<pipeline_counters> m_counters;
+                std::chrono::steady_clock::time_point m_busy_since{};
+                bool m_time_parsing = true;
                 bool m_header_is_done = false;
 
+                // The time the parser thread is busy is added to the parse
+                // stage and recorded by the tracer. The timer is paused
+                // while waiting for input or for space in the output queue.
+                void pause_parse_timer() {
+                    if (m_busy_since == std::chrono::steady_clock::time_point{}) {
+                        return;
+                    }
+                    const auto now = std::chrono::steady_clock::now();
+                    if (m_counters) {
+                        m_counters->add_time(pipeline_stage::parse, now - m_busy_since);
+                    }
+                    osmium::Tracer::instance().add_event(stage_name(pipeline_stage::parse), m_busy_since, now);
+                    m_busy_since = std::chrono::steady_clock::time_point{};
+                }
+
+                void resume_parse_timer() {
+                    if (m_time_parsing && (m_counters || osmium::Tracer::instance().enabled())) {
+                        m_busy_since = std::chrono::steady_clock::now();
+                    }
+                }
+
             protected:
 
                 osmium::thread::Pool& get_pool() {
@@ -93,6 +135,18 @@ namespace osmium {
                     return m_read_metadata;
                 }
 
+                osmium::io::read_fields::type read_which_fields() const noexcept {
+                    return m_read_which_fields;
+                }
+
+                /**
+                 * The metadata fields that should be read. None if
+                 * read_metadata() is osmium::io::read_meta::no.
+                 */
+                osmium::metadata_options read_metadata_options() const noexcept {
+                    return m_read_metadata_options;
+                }
+
                 bool header_is_done() const noexcept {
                     return m_header_is_done;
                 }
@@ -115,11 +169,42 @@ namespace osmium {
                  * Wrap the buffer into a future and add it to the output queue.
                  */
                 void send_to_output_queue(osmium::memory::Buffer&& buffer) {
+                    pause_parse_timer();
                     add_to_queue(m_output_queue, std::move(buffer));
+                    resume_parse_timer();
+                }
+
+                /**
+                 * Add the future to the output queue. The bytes parameter
+                 * is an estimate of the size of the buffer the future will
+                 * contain. It is used if the size of the output queue is
+                 * limited by bytes.
+                 */
+                void send_to_output_queue(std::future<osmium::memory::Buffer>&& future, std::size_t bytes = 0) {
+                    pause_parse_timer();
+                    m_output_queue.push(std::move(future), bytes);
+                    resume_parse_timer();
+                }
+
+                future_buffer_queue_type& output_queue() noexcept {
+                    return m_output_queue;
                 }
 
-                void send_to_output_queue(std::future<osmium::memory::Buffer>&& future) {
-                    m_output_queue.push(std::move(future));
+                /**
+                 * The counters used for Reader::stats(). Can be nullptr.
+                 */
+                const std::shared_ptr<pipeline_counters>& counters() const noexcept {
+                    return m_counters;
+                }
+
+                /**
+                 * Don't add the time the parser thread is busy to the parse
+                 * stage. For parsers which do their own accounting, because
+                 * they do other work in the parser thread or hand the
+                 * parsing off to the thread pool.
+                 */
+                void disable_parse_timer() noexcept {
+                    m_time_parsing = false;
                 }
 
             public:
@@ -130,7 +215,10 @@ namespace osmium {
                     m_header_promise(args.header_promise),
                     m_input_queue(args.input_queue),
                     m_read_which_entities(args.read_which_entities),
-                    m_read_metadata(args.read_metadata) {
+                    m_read_metadata(args.read_metadata),
+                    m_read_which_fields(args.read_which_fields),
+                    m_read_metadata_options(args.read_metadata == osmium::io::read_meta::yes ? args.read_metadata_options : osmium::metadata_options{"none"}),
+                    m_counters(args.counters) {
                 }
 
                 Parser(const Parser&) = delete;
@@ -144,7 +232,10 @@ namespace osmium {
                 virtual void run() = 0;
 
                 std::string get_input() {
-                    return m_input_queue.pop();
+                    pause_parse_timer();
+                    std::string data{m_input_queue.pop()};
+                    resume_parse_timer();
+                    return data;
                 }
 
                 bool input_done() const {
@@ -153,7 +244,9 @@ namespace osmium {
 
                 void parse() {
                     try {
+                        resume_parse_timer();
                         run();
+                        pause_parse_timer();
                     } catch (...) {
                         std::exception_ptr exception = std::current_exception();
                         set_header_exception(exception);
@@ -44,6 +44,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/osm/entity_bits.hpp>
 #include <osmium/osm/item_type.hpp>
 #include <osmium/osm/location.hpp>
+#include <osmium/osm/metadata_options.hpp>
 #include <osmium/osm/node.hpp>
 #include <osmium/osm/object.hpp>
 #include <osmium/osm/relation.hpp>
@@ -66,6 +67,7 @@ DEALINGS IN THE SOFTWARE.
 #include <limits>
 #include <memory>
 #include <string>
+#include <tuple>
 #include <utility>
 
 namespace osmium {
@@ -313,37 +315,51 @@ namespace osmium {
                     return {static_cast<osmium::user_id_type>(uid), user};
                 }
 
-                void decode_tags(osmium::builder::Builder& parent, const char** dataptr, const char* const end) {
-                    osmium::builder::TagListBuilder builder{parent};
-
-                    while (*dataptr != end) {
-                        const bool update_pointer = (**dataptr == 0x00);
-                        const char* data = decode_string(dataptr, end);
-                        const char* start = data;
+                std::pair<const char*, const char*> decode_tag(const char** dataptr, const char* const end) {
+                    const bool update_pointer = (**dataptr == 0x00);
+                    const char* data = decode_string(dataptr, end);
+                    const char* start = data;
 
-                        while (*data++) {
-                            if (data == end) {
-                                throw o5m_error{"no null byte in tag key"};
-                            }
+                    while (*data++) {
+                        if (data == end) {
+                            throw o5m_error{"no null byte in tag key"};
                         }
+                    }
 
+                    if (data == end) {
+                        throw o5m_error{"no null byte in tag value"};
+                    }
+
+                    const char* value = data;
+                    while (*data++) {
                         if (data == end) {
                             throw o5m_error{"no null byte in tag value"};
                         }
+                    }
 
-                        const char* value = data;
-                        while (*data++) {
-                            if (data == end) {
-                                throw o5m_error{"no null byte in tag value"};
-                            }
-                        }
+                    if (update_pointer) {
+                        m_reference_table.add(start, data - start);
+                        *dataptr = data;
+                    }
 
-                        if (update_pointer) {
-                            m_reference_table.add(start, data - start);
-                            *dataptr = data;
+                    return {start, value};
+                }
+
+                void decode_tags(osmium::builder::Builder& parent, const char** dataptr, const char* const end) {
+                    if (!(read_which_fields() & osmium::io::read_fields::tags)) {
+                        // Tags have to be decoded anyway, because later
+                        // objects can refer to their strings.
+                        while (*dataptr != end) {
+                            decode_tag(dataptr, end);
                         }
+                        return;
+                    }
 
-                        builder.add_tag(start, value);
+                    osmium::builder::TagListBuilder builder{parent};
+
+                    while (*dataptr != end) {
+                        const auto tag = decode_tag(dataptr, end);
+                        builder.add_tag(tag.first, tag.second);
                     }
                 }
 
@@ -354,6 +370,11 @@ namespace osmium {
                         throw o5m_error{"premature end of file while parsing object metadata"};
                     }
 
+                    // All fields have to be decoded to keep the delta
+                    // encoding and reference table in sync, but only
+                    // the wanted ones are set in the object.
+                    const auto metadata = read_metadata_options();
+
                     if (**dataptr == 0x00) { // no info section
                         ++*dataptr;
                     } else { // has info section
@@ -361,17 +382,28 @@ namespace osmium {
                         if (version > std::numeric_limits<object_version_type>::max()) {
                             throw o5m_error{"object version too large"};
                         }
-                        object.set_version(static_cast<object_version_type>(version));
+                        if (metadata.version()) {
+                            object.set_version(static_cast<object_version_type>(version));
+                        }
 
                         const auto timestamp = m_delta_timestamp.update(zvarint(dataptr, end));
                         if (timestamp != 0) { // has timestamp
-                            object.set_timestamp(timestamp);
-                            object.set_changeset(m_delta_changeset.update(zvarint(dataptr, end)));
+                            if (metadata.timestamp()) {
+                                object.set_timestamp(timestamp);
+                            }
+                            const auto changeset = m_delta_changeset.update(zvarint(dataptr, end));
+                            if (metadata.changeset()) {
+                                object.set_changeset(changeset);
+                            }
                             if (*dataptr != end) {
                                 const auto uid_user = decode_user(dataptr, end);
-                                object.set_uid(uid_user.first);
-                                user = uid_user.second;
-                            } else {
+                                if (metadata.uid()) {
+                                    object.set_uid(uid_user.first);
+                                }
+                                if (metadata.user()) {
+                                    user = uid_user.second;
+                                }
+                            } else if (metadata.uid()) {
                                 object.set_uid(user_id_type{0});
                             }
                         }
@@ -420,10 +452,16 @@ namespace osmium {
                                 throw o5m_error{"way nodes ref section too long"};
                             }
 
-                            osmium::builder::WayNodeListBuilder wn_builder{builder};
+                            if (read_which_fields() & osmium::io::read_fields::way_nodes) {
+                                osmium::builder::WayNodeListBuilder wn_builder{builder};
 
-                            while (data < end_refs) {
-                                wn_builder.add_node_ref(m_delta_way_node_id.update(zvarint(&data, end)));
+                                while (data < end_refs) {
+                                    wn_builder.add_node_ref(m_delta_way_node_id.update(zvarint(&data, end)));
+                                }
+                            } else {
+                                while (data < end_refs) {
+                                    m_delta_way_node_id.update(zvarint(&data, end));
+                                }
                             }
                         }
 
@@ -467,6 +505,17 @@ namespace osmium {
                     return {member_type, role};
                 }
 
+                std::tuple<osmium::item_type, osmium::object_id_type, const char*> decode_member(const char** dataptr, const char* const end) {
+                    const auto delta_id = zvarint(dataptr, end);
+                    if (*dataptr == end) {
+                        throw o5m_error{"relation member format error"};
+                    }
+                    const auto type_role = decode_role(dataptr, end);
+                    const auto i = osmium::item_type_to_nwr_index(type_role.first);
+                    const auto ref = m_delta_member_ids[i].update(delta_id);
+                    return std::make_tuple(type_role.first, ref, type_role.second);
+                }
+
                 void decode_relation(const char* data, const char* const end) {
                     osmium::builder::RelationBuilder builder{buffer()};
 
@@ -485,17 +534,17 @@ namespace osmium {
                                 throw o5m_error{"relation format error"};
                             }
 
-                            osmium::builder::RelationMemberListBuilder rml_builder{builder};
+                            if (read_which_fields() & osmium::io::read_fields::members) {
+                                osmium::builder::RelationMemberListBuilder rml_builder{builder};
 
-                            while (data < end_refs) {
-                                const auto delta_id = zvarint(&data, end);
-                                if (data == end) {
-                                    throw o5m_error{"relation member format error"};
+                                while (data < end_refs) {
+                                    const auto member = decode_member(&data, end);
+                                    rml_builder.add_member(std::get<0>(member), std::get<1>(member), std::get<2>(member));
+                                }
+                            } else {
+                                while (data < end_refs) {
+                                    decode_member(&data, end);
                                 }
-                                const auto type_role = decode_role(&data, end);
-                                const auto i = osmium::item_type_to_nwr_index(type_role.first);
-                                const auto ref = m_delta_member_ids[i].update(delta_id);
-                                rml_builder.add_member(type_role.first, ref, type_role.second);
                             }
                         }
 
@@ -38,14 +38,19 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/io/error.hpp>
 #include <osmium/io/file.hpp>
 #include <osmium/io/file_format.hpp>
+#include <osmium/io/pipeline_stats.hpp>
 #include <osmium/memory/buffer.hpp>
 #include <osmium/thread/pool.hpp>
 
 #include <array>
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <future>
 #include <memory>
 #include <string>
+#include <type_traits>
 #include <utility>
 
 namespace osmium {
@@ -110,13 +115,52 @@ namespace osmium {
 
                 osmium::thread::Pool& m_pool;
                 future_string_queue_type& m_output_queue;
+                std::shared_ptr<pipeline_counters> m_counters{};
+
+                // The Writer adds the time it spends in the functions of
+                // this class to the encode stage. Time spent waiting for
+                // space in the output queue is taken out again.
+                template <typename TFunction>
+                void push_to_output_queue(TFunction&& push) {
+                    if (!m_counters) {
+                        push();
+                        return;
+                    }
+                    const auto start = std::chrono::steady_clock::now();
+                    push();
+                    m_counters->add_time(pipeline_stage::encode, start - std::chrono::steady_clock::now());
+                }
+
+                /**
+                 * Submit a task creating (part of) the output to the thread
+                 * pool. The time the task runs is added to the given stage.
+                 */
+                template <typename TFunction>
+                std::future<std::string> submit(TFunction&& func, pipeline_stage stage = pipeline_stage::encode) {
+                    using function_type = typename std::decay<TFunction>::type;
+                    return m_pool.submit(timed_function<function_type>{std::forward<TFunction>(func), m_counters, stage});
+                }
 
                 /**
                  * Wrap the string into a future and add it to the output
                  * queue.
                  */
                 void send_to_output_queue(std::string&& data) {
-                    add_to_queue(m_output_queue, std::move(data));
+                    push_to_output_queue([&]() {
+                        add_to_queue(m_output_queue, std::move(data));
+                    });
+                }
+
+                /**
+                 * Add the future to the output queue. The bytes parameter
+                 * is an estimate of the size of the data the future will
+                 * contain. It is used if the size of the output queue is
+                 * limited by bytes.
+                 */
+                void send_to_output_queue(std::future<std::string>&& future, std::size_t bytes) {
+                    push_to_output_queue([&]() {
+                        m_output_queue.push(std::move(future), bytes);
+                    });
                 }
 
             public:
@@ -134,6 +178,13 @@ namespace osmium {
 
                 virtual ~OutputFormat() noexcept = default;
 
+                /**
+                 * Set the counters used for Writer::stats().
+                 */
+                void set_counters(std::shared_ptr<pipeline_counters> counters) noexcept {
+                    m_counters = std::move(counters);
+                }
+
                 virtual void write_header(const osmium::io::Header& /*header*/) {
                 }
 
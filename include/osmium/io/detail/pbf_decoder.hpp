@@ -33,6 +33,8 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <algorithm>
+#include <array>
 #include <cstdint>
 #include <cstring>
 #include <limits>
@@ -48,26 +50,38 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/io/detail/zlib.hpp>
 #include <osmium/io/file_format.hpp>
 #include <osmium/io/header.hpp>
+#include <osmium/io/node_columns.hpp>
+#include <osmium/io/pipeline_stats.hpp>
 #include <osmium/memory/buffer.hpp>
+#include <osmium/memory/buffer_recycler.hpp>
 #include <osmium/osm/box.hpp>
 #include <osmium/osm/entity_bits.hpp>
 #include <osmium/osm/item_type.hpp>
 #include <osmium/osm/location.hpp>
+#include <osmium/osm/metadata_options.hpp>
 #include <osmium/osm/node.hpp>
 #include <osmium/osm/object.hpp>
 #include <osmium/osm/relation.hpp>
 #include <osmium/osm/timestamp.hpp>
 #include <osmium/osm/types.hpp>
 #include <osmium/osm/way.hpp>
+#include <osmium/tags/tags_filter.hpp>
 #include <osmium/util/delta.hpp>
+#include <osmium/util/memory_mapping.hpp>
 
 #ifdef OSMIUM_WITH_LZ4
 # include <osmium/io/detail/lz4.hpp>
 #endif
 
+#ifdef OSMIUM_WITH_ZSTD
+# include <osmium/io/detail/zstd.hpp>
+#endif
+
+#include <protozero/exception.hpp>
 #include <protozero/iterators.hpp>
 #include <protozero/pbf_message.hpp>
 #include <protozero/types.hpp>
+#include <protozero/varint.hpp>
 
 namespace osmium {
 
@@ -134,15 +148,71 @@ namespace osmium {
 
             }; // class varint_range
 
-            using osm_string_len_type = std::pair<const char*, osmium::string_size_type>;
+            /**
+             * Decode all varints in a packed sint64 field, undo the zigzag
+             * and delta encoding and write the resulting values into the
+             * output vector (which is cleared first).
+             *
+             * This does in one pass over the data what varint_range and
+             * DeltaDecode do one value at a time. Delta encoded ids are
+             * often only one byte long, so eight bytes are checked at once
+             * and if none of them has the continuation bit set, they are
+             * decoded without any further tests.
+             *
+             * @throws protozero::end_of_buffer_exception if the data ends
+             *         in the middle of a varint.
+             */
+            inline void decode_packed_sint64_delta(const data_view& data, std::vector<int64_t>& output) {
+                output.clear();
 
-            class PBFPrimitiveBlockDecoder {
+                const char* it = data.data();
+                const char* const end = it + data.size();
 
-                enum {
-                    initial_buffer_size = 64UL * 1024UL
+                // Every varint ends with exactly one byte without the
+                // continuation bit, so this is the number of values.
+                output.reserve(static_cast<std::size_t>(std::count_if(it, end, [](char c) noexcept {
+                    return (static_cast<unsigned char>(c) & 0x80U) == 0;
+                })));
+
+                // Unsigned arithmetic, so that overflows in bad data are
+                // not undefined behaviour. See also DeltaDecode.
+                uint64_t value = 0;
+
+                const auto add = [&output, &value](uint64_t zigzag) {
+                    value += static_cast<uint64_t>(protozero::decode_zigzag64(zigzag));
+                    output.push_back(static_cast<int64_t>(value));
                 };
 
-                data_view m_data;
+                while (end - it >= 8) {
+                    uint64_t word = 0;
+                    std::memcpy(&word, it, sizeof(word));
+                    if ((word & 0x8080808080808080ULL) == 0) {
+                        for (int n = 0; n < 8; ++n) {
+                            add(static_cast<unsigned char>(it[n]));
+                        }
+                        it += 8;
+                    } else {
+                        add(protozero::decode_varint(&it, end));
+                    }
+                }
+
+                while (it != end) {
+                    add(protozero::decode_varint(&it, end));
+                }
+            }
+
+            using osm_string_len_type = std::pair<const char*, osmium::string_size_type>;
+
+            /**
+             * The parts shared by the decoders for PrimitiveBlocks: The
+             * block settings (string table, granularity and offsets) and
+             * the conversion of coordinates and dense node columns using
+             * them.
+             */
+            class PBFPrimitiveBlockDecoderBase {
+
+            protected:
+
                 std::vector<osm_string_len_type> m_stringtable;
 
                 int64_t m_lon_offset = 0;
@@ -150,11 +220,22 @@ namespace osmium {
                 int64_t m_date_factor = 1000;
                 int32_t m_granularity = 100;
 
-                osmium::osm_entity_bits::type m_read_types;
+                // Decoded ids and coordinates of dense nodes
+                std::vector<int64_t> m_dense_ids;
+                std::vector<int64_t> m_dense_lats;
+                std::vector<int64_t> m_dense_lons;
 
-                osmium::memory::Buffer m_buffer{initial_buffer_size, osmium::memory::Buffer::auto_grow::internal};
+                void decode_dense_node_columns(const data_view& ids, const data_view& lats, const data_view& lons) {
+                    decode_packed_sint64_delta(ids, m_dense_ids);
+                    decode_packed_sint64_delta(lats, m_dense_lats);
+                    decode_packed_sint64_delta(lons, m_dense_lons);
 
-                osmium::io::read_meta m_read_metadata;
+                    if (m_dense_lats.size() < m_dense_ids.size() ||
+                        m_dense_lons.size() < m_dense_ids.size()) {
+                        // this is against the spec, must have same number of elements
+                        throw osmium::pbf_error{"PBF format error"};
+                    }
+                }
 
                 void decode_stringtable(const data_view& data) {
                     if (!m_stringtable.empty()) {
@@ -172,12 +253,20 @@ namespace osmium {
                     }
                 }
 
-                void decode_primitive_block_metadata() {
-                    protozero::pbf_message<OSMFormat::PrimitiveBlock> pbf_primitive_block{m_data};
+                /**
+                 * Decode the settings of the PrimitiveBlock. The string
+                 * table is only decoded if with_stringtable is set.
+                 */
+                void decode_primitive_block_metadata(const data_view& data, bool with_stringtable = true) {
+                    protozero::pbf_message<OSMFormat::PrimitiveBlock> pbf_primitive_block{data};
                     while (pbf_primitive_block.next()) {
                         switch (pbf_primitive_block.tag_and_type()) {
                             case protozero::tag_and_type(OSMFormat::PrimitiveBlock::required_StringTable_stringtable, protozero::pbf_wire_type::length_delimited):
-                                decode_stringtable(pbf_primitive_block.get_view());
+                                if (with_stringtable) {
+                                    decode_stringtable(pbf_primitive_block.get_view());
+                                } else {
+                                    pbf_primitive_block.skip();
+                                }
                                 break;
                             case protozero::tag_and_type(OSMFormat::PrimitiveBlock::optional_int32_granularity, protozero::pbf_wire_type::varint):
                                 m_granularity = pbf_primitive_block.get_int32();
@@ -197,6 +286,137 @@ namespace osmium {
                     }
                 }
 
+                int32_t convert_pbf_lon(const int64_t c) const noexcept {
+                    return int32_t((c * m_granularity + m_lon_offset) / resolution_convert);
+                }
+
+                int32_t convert_pbf_lat(const int64_t c) const noexcept {
+                    return int32_t((c * m_granularity + m_lat_offset) / resolution_convert);
+                }
+
+            }; // class PBFPrimitiveBlockDecoderBase
+
+            class PBFPrimitiveBlockDecoder : public PBFPrimitiveBlockDecoderBase {
+
+                enum {
+                    initial_buffer_size = 64UL * 1024UL
+                };
+
+                data_view m_data;
+
+                osmium::osm_entity_bits::type m_read_types;
+
+                osmium::memory::Buffer m_buffer;
+
+                osmium::io::read_meta m_read_metadata;
+                osmium::io::read_fields::type m_read_which_fields;
+                osmium::metadata_options m_read_metadata_options;
+                const osmium::TagsFilter* m_tags_filter;
+
+                // Result of the tags filter for tags with each string in
+                // the string table as key. Only used with a tags filter.
+                enum class key_match : unsigned char {
+                    no               = 0,
+                    yes              = 1,
+                    depends_on_value = 2
+                };
+                std::vector<key_match> m_key_matches;
+
+                // Null-terminated copies of all strings in the string
+                // table for the string matchers of the tags filter.
+                std::string m_filter_strings;
+                std::vector<std::size_t> m_filter_string_offsets;
+
+                const char* filter_string(const std::size_t idx) const {
+                    return m_filter_strings.data() + m_filter_string_offsets.at(idx);
+                }
+
+                /**
+                 * Check all strings in the string table as keys against the
+                 * tags filter, so that the filter has to be evaluated for
+                 * tags with those keys only if the result depends on the
+                 * value.
+                 *
+                 * @returns false if no tag in this block can match.
+                 */
+                bool prepare_tags_filter() {
+                    m_filter_string_offsets.reserve(m_stringtable.size());
+                    for (const auto& str : m_stringtable) {
+                        m_filter_string_offsets.push_back(m_filter_strings.size());
+                        m_filter_strings.append(str.first, str.second);
+                        m_filter_strings.push_back('\0');
+                    }
+
+                    bool any_match = false;
+                    m_key_matches.reserve(m_stringtable.size());
+                    for (std::size_t idx = 0; idx < m_stringtable.size(); ++idx) {
+                        bool result = false;
+                        if (m_tags_filter->match_key(filter_string(idx), result)) {
+                            m_key_matches.push_back(result ? key_match::yes : key_match::no);
+                            any_match = any_match || result;
+                        } else {
+                            m_key_matches.push_back(key_match::depends_on_value);
+                            any_match = true;
+                        }
+                    }
+
+                    return any_match;
+                }
+
+                bool tag_matches(const uint32_t key, const uint32_t value) const {
+                    switch (m_key_matches.at(key)) {
+                        case key_match::no:
+                            return false;
+                        case key_match::yes:
+                            return true;
+                        default: // key_match::depends_on_value
+                            break;
+                    }
+                    return (*m_tags_filter)(filter_string(key), filter_string(value));
+                }
+
+                // Check whether any of the tags matches the tags filter.
+                // The ranges are copied, so they can still be used for
+                // building the tag list afterwards.
+                bool tags_match(varint_range keys, varint_range vals) const {
+                    while (!keys.empty() && !vals.empty()) {
+                        const auto key = keys.next_uint32();
+                        if (tag_matches(key, vals.next_uint32())) {
+                            return true;
+                        }
+                    }
+                    return false;
+                }
+
+                // Check whether any of the tags of the next node in a
+                // DenseNodes group matches the tags filter. Afterwards the
+                // range points to the tags of the node after that.
+                bool dense_node_tags_match(varint_range& tags) const {
+                    bool match = false;
+                    while (!tags.empty()) {
+                        const auto key = tags.next_int32();
+                        if (key == 0) {
+                            break;
+                        }
+                        if (tags.empty()) {
+                            throw osmium::pbf_error{"PBF format error"}; // this is against the spec, keys/vals must come in pairs
+                        }
+                        const auto value = tags.next_int32();
+                        match = match || tag_matches(static_cast<uint32_t>(key), static_cast<uint32_t>(value));
+                    }
+                    return match;
+                }
+
+                // Commit the object just decoded if it should be kept,
+                // otherwise remove it from the buffer again.
+                void commit_or_rollback(const bool keep) {
+                    if (keep) {
+                        m_buffer.commit();
+                    } else {
+                        m_buffer.rollback();
+                    }
+                }
+
                 void decode_primitive_block_data() {
                     protozero::pbf_message<OSMFormat::PrimitiveBlock> pbf_primitive_block{m_data};
                     while (pbf_primitive_block.next(OSMFormat::PrimitiveBlock::repeated_PrimitiveGroup_primitivegroup, protozero::pbf_wire_type::length_delimited)) {
@@ -205,8 +425,7 @@ namespace osmium {
                             switch (pbf_primitive_group.tag_and_type()) {
                                 case protozero::tag_and_type(OSMFormat::PrimitiveGroup::repeated_Node_nodes, protozero::pbf_wire_type::length_delimited):
                                     if (m_read_types & osmium::osm_entity_bits::node) {
-                                        decode_node(pbf_primitive_group.get_view());
-                                        m_buffer.commit();
+                                        commit_or_rollback(decode_node(pbf_primitive_group.get_view()));
                                     } else {
                                         pbf_primitive_group.skip();
                                     }
@@ -225,24 +444,21 @@ namespace osmium {
                                     break;
                                 case protozero::tag_and_type(OSMFormat::PrimitiveGroup::repeated_Way_ways, protozero::pbf_wire_type::length_delimited):
                                     if (m_read_types & osmium::osm_entity_bits::way) {
-                                        decode_way(pbf_primitive_group.get_view());
-                                        m_buffer.commit();
+                                        commit_or_rollback(decode_way(pbf_primitive_group.get_view()));
                                     } else {
                                         pbf_primitive_group.skip();
                                     }
                                     break;
                                 case protozero::tag_and_type(OSMFormat::PrimitiveGroup::repeated_Relation_relations, protozero::pbf_wire_type::length_delimited):
                                     if (m_read_types & osmium::osm_entity_bits::relation) {
-                                        decode_relation(pbf_primitive_group.get_view());
-                                        m_buffer.commit();
+                                        commit_or_rollback(decode_relation(pbf_primitive_group.get_view()));
                                     } else {
                                         pbf_primitive_group.skip();
                                     }
                                     break;
                                 case protozero::tag_and_type(OSMFormat::PrimitiveGroup::repeated_Area_areas, protozero::pbf_wire_type::length_delimited):
                                     if (m_read_types & osmium::osm_entity_bits::area) {
-                                        decode_area(pbf_primitive_group.get_view());
-                                        m_buffer.commit();
+                                        commit_or_rollback(decode_area(pbf_primitive_group.get_view()));
                                     } else {
                                         pbf_primitive_group.skip();
                                     }
@@ -261,7 +477,7 @@ namespace osmium {
                     while (pbf_info.next()) {
                         switch (pbf_info.tag_and_type()) {
                             case protozero::tag_and_type(OSMFormat::Info::optional_int32_version, protozero::pbf_wire_type::varint):
-                                {
+                                if (m_read_metadata_options.version()) {
                                     const auto version = pbf_info.get_int32();
                                     if (version < -1) {
                                         throw osmium::pbf_error{"object version must not be negative"};
@@ -272,13 +488,19 @@ namespace osmium {
                                     } else {
                                         object.set_version(static_cast<object_version_type>(version));
                                     }
+                                } else {
+                                    pbf_info.skip();
                                 }
                                 break;
                             case protozero::tag_and_type(OSMFormat::Info::optional_int64_timestamp, protozero::pbf_wire_type::varint):
-                                object.set_timestamp(pbf_info.get_int64() * m_date_factor / 1000);
+                                if (m_read_metadata_options.timestamp()) {
+                                    object.set_timestamp(pbf_info.get_int64() * m_date_factor / 1000);
+                                } else {
+                                    pbf_info.skip();
+                                }
                                 break;
                             case protozero::tag_and_type(OSMFormat::Info::optional_int64_changeset, protozero::pbf_wire_type::varint):
-                                {
+                                if (m_read_metadata_options.changeset()) {
                                     const auto changeset_id = pbf_info.get_int64();
                                     if (changeset_id < -1 || changeset_id >= std::numeric_limits<changeset_id_type>::max()) {
                                         throw osmium::pbf_error{"object changeset_id must be between 0 and 2^32-1"};
@@ -289,13 +511,23 @@ namespace osmium {
                                     } else {
                                         object.set_changeset(static_cast<changeset_id_type>(changeset_id));
                                     }
+                                } else {
+                                    pbf_info.skip();
                                 }
                                 break;
                             case protozero::tag_and_type(OSMFormat::Info::optional_int32_uid, protozero::pbf_wire_type::varint):
-                                object.set_uid_from_signed(pbf_info.get_int32());
+                                if (m_read_metadata_options.uid()) {
+                                    object.set_uid_from_signed(pbf_info.get_int32());
+                                } else {
+                                    pbf_info.skip();
+                                }
                                 break;
                             case protozero::tag_and_type(OSMFormat::Info::optional_uint32_user_sid, protozero::pbf_wire_type::varint):
-                                user = m_stringtable.at(pbf_info.get_uint32());
+                                if (m_read_metadata_options.user()) {
+                                    user = m_stringtable.at(pbf_info.get_uint32());
+                                } else {
+                                    pbf_info.skip();
+                                }
                                 break;
                             case protozero::tag_and_type(OSMFormat::Info::optional_bool_visible, protozero::pbf_wire_type::varint):
                                 object.set_visible(pbf_info.get_bool());
@@ -309,7 +541,7 @@ namespace osmium {
                 }
 
                 void build_tag_list(osmium::builder::Builder& parent, varint_range& keys, varint_range& vals) {
-                    if (keys.empty() || vals.empty()) {
+                    if (!(m_read_which_fields & osmium::io::read_fields::tags) || keys.empty() || vals.empty()) {
                         return;
                     }
 
@@ -321,15 +553,7 @@ namespace osmium {
                     } while (!keys.empty() && !vals.empty());
                 }
 
-                int32_t convert_pbf_lon(const int64_t c) const noexcept {
-                    return int32_t((c * m_granularity + m_lon_offset) / resolution_convert);
-                }
-
-                int32_t convert_pbf_lat(const int64_t c) const noexcept {
-                    return int32_t((c * m_granularity + m_lat_offset) / resolution_convert);
-                }
-
-                void decode_node(const data_view& data) {
+                bool decode_node(const data_view& data) {
                     osmium::builder::NodeBuilder builder{m_buffer};
                     osmium::Node& node = builder.object();
 
@@ -370,6 +594,10 @@ namespace osmium {
                         }
                     }
 
+                    if (m_tags_filter && !tags_match(keys, vals)) {
+                        return false;
+                    }
+
                     if (node.visible()) {
                         if (lon == std::numeric_limits<int64_t>::max() ||
                             lat == std::numeric_limits<int64_t>::max()) {
@@ -384,9 +612,11 @@ namespace osmium {
                     builder.set_user(user.first, user.second);
 
                     build_tag_list(builder, keys, vals);
+
+                    return true;
                 }
 
-                void decode_way(const data_view& data) {
+                bool decode_way(const data_view& data) {
                     osmium::builder::WayBuilder builder{m_buffer};
 
                     varint_range keys;
@@ -430,9 +660,13 @@ namespace osmium {
                         }
                     }
 
+                    if (m_tags_filter && !tags_match(keys, vals)) {
+                        return false;
+                    }
+
                     builder.set_user(user.first, user.second);
 
-                    if (!refs.empty()) {
+                    if ((m_read_which_fields & osmium::io::read_fields::way_nodes) && !refs.empty()) {
                         osmium::builder::WayNodeListBuilder wnl_builder{builder};
                         osmium::DeltaDecode<int64_t> ref;
                         if (lats.empty()) {
@@ -453,9 +687,11 @@ namespace osmium {
                     }
 
                     build_tag_list(builder, keys, vals);
+
+                    return true;
                 }
 
-                void decode_relation(const data_view& data) {
+                bool decode_relation(const data_view& data) {
                     osmium::builder::RelationBuilder builder{m_buffer};
 
                     varint_range keys;
@@ -499,9 +735,13 @@ namespace osmium {
                         }
                     }
 
+                    if (m_tags_filter && !tags_match(keys, vals)) {
+                        return false;
+                    }
+
                     builder.set_user(user.first, user.second);
 
-                    if (!refs.empty()) {
+                    if ((m_read_which_fields & osmium::io::read_fields::members) && !refs.empty()) {
                         osmium::builder::RelationMemberListBuilder rml_builder{builder};
                         osmium::DeltaDecode<int64_t> ref;
                         while (!roles.empty() && !refs.empty() && !types.empty()) {
@@ -520,6 +760,8 @@ namespace osmium {
                     }
 
                     build_tag_list(builder, keys, vals);
+
+                    return true;
                 }
 
                 void decode_innerring(const data_view& data, osmium::builder::AreaBuilder& area_builder/*, std::stringstream& ss*/) {
@@ -626,7 +868,7 @@ namespace osmium {
 
                 }
 
-                void decode_area(const data_view& data) {
+                bool decode_area(const data_view& data) {
 
                     //std::stringstream ss;
 
@@ -674,10 +916,15 @@ namespace osmium {
                         }
                     }
 
+                    if (m_tags_filter && !tags_match(keys, vals)) {
+                        return false;
+                    }
+
                     //ss << "  Building TagList\n";
                     build_tag_list(builder, keys, vals);
 
                     //std::cout << ss.str();
+                    return true;
                 }
 
                 void build_tag_list_from_dense_nodes(osmium::builder::NodeBuilder& builder, varint_range& tags) {
@@ -697,56 +944,60 @@ namespace osmium {
                 }
 
                 void decode_dense_nodes_without_metadata(const data_view& data) {
-                    varint_range ids;
-                    varint_range lats;
-                    varint_range lons;
+                    data_view ids;
+                    data_view lats;
+                    data_view lons;
                     varint_range tags;
 
                     protozero::pbf_message<OSMFormat::DenseNodes> pbf_dense_nodes{data};
                     while (pbf_dense_nodes.next()) {
                         switch (pbf_dense_nodes.tag_and_type()) {
                             case protozero::tag_and_type(OSMFormat::DenseNodes::packed_sint64_id, protozero::pbf_wire_type::length_delimited):
-                                ids = varint_range{pbf_dense_nodes.get_view()};
+                                ids = pbf_dense_nodes.get_view();
                                 break;
                             case protozero::tag_and_type(OSMFormat::DenseNodes::packed_sint64_lat, protozero::pbf_wire_type::length_delimited):
-                                lats = varint_range{pbf_dense_nodes.get_view()};
+                                lats = pbf_dense_nodes.get_view();
                                 break;
                             case protozero::tag_and_type(OSMFormat::DenseNodes::packed_sint64_lon, protozero::pbf_wire_type::length_delimited):
-                                lons = varint_range{pbf_dense_nodes.get_view()};
+                                lons = pbf_dense_nodes.get_view();
                                 break;
                             case protozero::tag_and_type(OSMFormat::DenseNodes::packed_int32_keys_vals, protozero::pbf_wire_type::length_delimited):
-                                tags = varint_range{pbf_dense_nodes.get_view()};
+                                if ((m_read_which_fields & osmium::io::read_fields::tags) || m_tags_filter) {
+                                    tags = varint_range{pbf_dense_nodes.get_view()};
+                                } else {
+                                    pbf_dense_nodes.skip();
+                                }
                                 break;
                             default:
                                 pbf_dense_nodes.skip();
                         }
                     }
 
-                    osmium::DeltaDecode<int64_t> dense_id;
-                    osmium::DeltaDecode<int64_t> dense_latitude;
-                    osmium::DeltaDecode<int64_t> dense_longitude;
+                    decode_dense_node_columns(ids, lats, lons);
 
-                    while (!ids.empty()) {
-                        if (lons.empty() ||
-                            lats.empty()) {
-                            // this is against the spec, must have same number of elements
-                            throw osmium::pbf_error{"PBF format error"};
+                    for (std::size_t i = 0; i < m_dense_ids.size(); ++i) {
+                        if (m_tags_filter) {
+                            const auto node_tags = tags;
+                            if (!dense_node_tags_match(tags)) {
+                                continue;
+                            }
+                            if (m_read_which_fields & osmium::io::read_fields::tags) {
+                                tags = node_tags;
+                            }
                         }
 
                         {
                             osmium::builder::NodeBuilder builder{m_buffer};
                             osmium::Node& node = builder.object();
 
-                            node.set_id(dense_id.update(ids.next_sint64()));
+                            node.set_id(m_dense_ids[i]);
 
-                            const auto lon = dense_longitude.update(lons.next_sint64());
-                            const auto lat = dense_latitude.update(lats.next_sint64());
                             builder.object().set_location(osmium::Location{
-                                    convert_pbf_lon(lon),
-                                    convert_pbf_lat(lat)
+                                    convert_pbf_lon(m_dense_lons[i]),
+                                    convert_pbf_lat(m_dense_lats[i])
                             });
 
-                            if (!tags.empty()) {
+                            if ((m_read_which_fields & osmium::io::read_fields::tags) && !tags.empty()) {
                                 build_tag_list_from_dense_nodes(builder, tags);
                             }
                         }
@@ -758,9 +1009,9 @@ namespace osmium {
                 void decode_dense_nodes(const data_view& data) {
                     bool has_info = false;
 
-                    varint_range ids;
-                    varint_range lats;
-                    varint_range lons;
+                    data_view ids;
+                    data_view lats;
+                    data_view lons;
                     varint_range tags;
                     varint_range versions;
                     varint_range timestamps;
@@ -773,7 +1024,7 @@ namespace osmium {
                     while (pbf_dense_nodes.next()) {
                         switch (pbf_dense_nodes.tag_and_type()) {
                             case protozero::tag_and_type(OSMFormat::DenseNodes::packed_sint64_id, protozero::pbf_wire_type::length_delimited):
-                                ids = varint_range{pbf_dense_nodes.get_view()};
+                                ids = pbf_dense_nodes.get_view();
                                 break;
                             case protozero::tag_and_type(OSMFormat::DenseNodes::optional_DenseInfo_denseinfo, protozero::pbf_wire_type::length_delimited):
                                 {
@@ -806,32 +1057,79 @@ namespace osmium {
                                 }
                                 break;
                             case protozero::tag_and_type(OSMFormat::DenseNodes::packed_sint64_lat, protozero::pbf_wire_type::length_delimited):
-                                lats = varint_range{pbf_dense_nodes.get_view()};
+                                lats = pbf_dense_nodes.get_view();
                                 break;
                             case protozero::tag_and_type(OSMFormat::DenseNodes::packed_sint64_lon, protozero::pbf_wire_type::length_delimited):
-                                lons = varint_range{pbf_dense_nodes.get_view()};
+                                lons = pbf_dense_nodes.get_view();
                                 break;
                             case protozero::tag_and_type(OSMFormat::DenseNodes::packed_int32_keys_vals, protozero::pbf_wire_type::length_delimited):
-                                tags = varint_range{pbf_dense_nodes.get_view()};
+                                if ((m_read_which_fields & osmium::io::read_fields::tags) || m_tags_filter) {
+                                    tags = varint_range{pbf_dense_nodes.get_view()};
+                                } else {
+                                    pbf_dense_nodes.skip();
+                                }
                                 break;
                             default:
                                 pbf_dense_nodes.skip();
                         }
                     }
 
-                    osmium::DeltaDecode<int64_t> dense_id;
-                    osmium::DeltaDecode<int64_t> dense_latitude;
-                    osmium::DeltaDecode<int64_t> dense_longitude;
+                    decode_dense_node_columns(ids, lats, lons);
+
+                    // Columns for metadata fields that are not wanted are
+                    // ignored completely, so they don't have to be decoded.
+                    if (!m_read_metadata_options.version()) {
+                        versions = varint_range{};
+                    }
+                    if (!m_read_metadata_options.timestamp()) {
+                        timestamps = varint_range{};
+                    }
+                    if (!m_read_metadata_options.changeset()) {
+                        changesets = varint_range{};
+                    }
+                    if (!m_read_metadata_options.uid()) {
+                        uids = varint_range{};
+                    }
+                    if (!m_read_metadata_options.user()) {
+                        user_sids = varint_range{};
+                    }
+
                     osmium::DeltaDecode<int64_t> dense_uid;
                     osmium::DeltaDecode<int64_t> dense_user_sid;
                     osmium::DeltaDecode<int64_t> dense_changeset;
                     osmium::DeltaDecode<int64_t> dense_timestamp;
 
-                    while (!ids.empty()) {
-                        if (lons.empty() ||
-                            lats.empty()) {
-                            // this is against the spec, must have same number of elements
-                            throw osmium::pbf_error{"PBF format error"};
+                    for (std::size_t i = 0; i < m_dense_ids.size(); ++i) {
+                        if (m_tags_filter) {
+                            const auto node_tags = tags;
+                            if (!dense_node_tags_match(tags)) {
+                                // The delta encoded metadata columns must
+                                // still be decoded for the following nodes.
+                                if (has_info) {
+                                    if (!versions.empty()) {
+                                        versions.next_int32();
+                                    }
+                                    if (!changesets.empty()) {
+                                        dense_changeset.update(changesets.next_sint64());
+                                    }
+                                    if (!timestamps.empty()) {
+                                        dense_timestamp.update(timestamps.next_sint64());
+                                    }
+                                    if (!uids.empty()) {
+                                        dense_uid.update(uids.next_sint32());
+                                    }
+                                    if (!visibles.empty()) {
+                                        visibles.next_int32();
+                                    }
+                                    if (!user_sids.empty()) {
+                                        dense_user_sid.update(user_sids.next_sint32());
+                                    }
+                                }
+                                continue;
+                            }
+                            if (m_read_which_fields & osmium::io::read_fields::tags) {
+                                tags = node_tags;
+                            }
                         }
 
                         {
@@ -840,7 +1138,7 @@ namespace osmium {
                             osmium::builder::NodeBuilder builder{m_buffer};
                             osmium::Node& node = builder.object();
 
-                            node.set_id(dense_id.update(ids.next_sint64()));
+                            node.set_id(m_dense_ids[i]);
 
                             if (has_info) {
                                 if (!versions.empty()) {
@@ -890,16 +1188,14 @@ namespace osmium {
 
                             // even if the node isn't visible, there's still a record
                             // of its lat/lon in the dense arrays.
-                            const auto lon = dense_longitude.update(lons.next_sint64());
-                            const auto lat = dense_latitude.update(lats.next_sint64());
                             if (visible) {
                                 builder.object().set_location(osmium::Location{
-                                        convert_pbf_lon(lon),
-                                        convert_pbf_lat(lat)
+                                        convert_pbf_lon(m_dense_lons[i]),
+                                        convert_pbf_lat(m_dense_lats[i])
                                 });
                             }
 
-                            if (!tags.empty()) {
+                            if ((m_read_which_fields & osmium::io::read_fields::tags) && !tags.empty()) {
                                 build_tag_list_from_dense_nodes(builder, tags);
                             }
                         }
@@ -909,10 +1205,36 @@ namespace osmium {
 
             public:
 
-                PBFPrimitiveBlockDecoder(const data_view& data, const osmium::osm_entity_bits::type read_types, const osmium::io::read_meta read_metadata) :
+                /**
+                 * Create decoder for a PrimitiveBlock.
+                 *
+                 * If a recycler is given, the buffer is taken from it and
+                 * grows as needed to fit all the data. Recycled buffers
+                 * will soon have the size needed for whole blocks, so no
+                 * more memory has to be allocated. Otherwise a small new
+                 * buffer is used which adds nested buffers when it is full.
+                 *
+                 * Only the parts of objects in read_which_fields and the
+                 * metadata fields in read_metadata_options are decoded.
+                 *
+                 * If a tags filter is given, only objects with at least one
+                 * tag matching the filter are decoded.
+                 */
+                PBFPrimitiveBlockDecoder(const data_view& data,
+                                         const osmium::osm_entity_bits::type read_types,
+                                         const osmium::io::read_meta read_metadata,
+                                         osmium::memory::detail::recycler_handle* recycler = nullptr,
+                                         const osmium::io::read_fields::type read_which_fields = osmium::io::read_fields::all,
+                                         const osmium::metadata_options& read_metadata_options = osmium::metadata_options{},
+                                         const osmium::TagsFilter* tags_filter = nullptr) :
                     m_data(data),
                     m_read_types(read_types),
-                    m_read_metadata(read_metadata) {
+                    m_buffer(recycler ? recycler->get(initial_buffer_size, osmium::memory::Buffer::auto_grow::yes)
+                                      : osmium::memory::Buffer{initial_buffer_size, osmium::memory::Buffer::auto_grow::internal}),
+                    m_read_metadata(read_metadata),
+                    m_read_which_fields(read_which_fields),
+                    m_read_metadata_options(read_metadata_options),
+                    m_tags_filter(tags_filter) {
                 }
 
                 PBFPrimitiveBlockDecoder(const PBFPrimitiveBlockDecoder&) = delete;
@@ -925,8 +1247,12 @@ namespace osmium {
 
                 osmium::memory::Buffer operator()() {
                     try {
-                        decode_primitive_block_metadata();
-                        decode_primitive_block_data();
+                        decode_primitive_block_metadata(m_data);
+                        // With a tags filter the whole block can be skipped
+                        // if no string in its string table can match.
+                        if (!m_tags_filter || prepare_tags_filter()) {
+                            decode_primitive_block_data();
+                        }
                     } catch (const std::out_of_range&) {
                         throw osmium::pbf_error{"string id out of range"};
                     }
@@ -936,7 +1262,165 @@ namespace osmium {
 
             }; // class PBFPrimitiveBlockDecoder
 
-            inline data_view decode_blob(const std::string& blob_data, std::string& output) {
+            inline uint32_t get_size_in_network_byte_order(const char* d) noexcept {
+                return (static_cast<uint32_t>(d[3])) |
+                       (static_cast<uint32_t>(d[2]) <<  8U) |
+                       (static_cast<uint32_t>(d[1]) << 16U) |
+                       (static_cast<uint32_t>(d[0]) << 24U);
+            }
+
+            /**
+             * The information libosmium stores in the BlobHeader.indexdata
+             * field about the contents of a blob.
+             */
+            struct pbf_index_data {
+
+                osmium::osm_entity_bits::type types = osmium::osm_entity_bits::nothing;
+                osmium::object_id_type min_id = std::numeric_limits<osmium::object_id_type>::max();
+                osmium::object_id_type max_id = std::numeric_limits<osmium::object_id_type>::min();
+
+                /// Bounding box of all objects in the blob (invalid if unknown).
+                osmium::Box bbox{};
+
+                /// Was there any (usable) index data?
+                bool valid() const noexcept {
+                    return types != osmium::osm_entity_bits::nothing &&
+                           min_id <= max_id;
+                }
+
+            }; // struct pbf_index_data
+
+            /**
+             * Decode the contents of the BlobHeader.indexdata field. The
+             * field is free-form, so anything without the libosmium marker
+             * in front or that can't be parsed is treated as if there was
+             * no index data. This never throws.
+             */
+            inline pbf_index_data decode_index_data(const data_view& data) noexcept {
+                if (data.size() < OSMIndexData::marker_size ||
+                    std::memcmp(data.data(), OSMIndexData::marker, OSMIndexData::marker_size) != 0) {
+                    return pbf_index_data{};
+                }
+
+                pbf_index_data index_data;
+                std::array<int32_t, 4> bbox{};
+                unsigned int bbox_fields = 0;
+
+                protozero::pbf_message<OSMIndexData::IndexData> message{data.data() + OSMIndexData::marker_size,
+                                                                       data.size() - OSMIndexData::marker_size};
+                try {
+                    while (message.next()) {
+                        switch (message.tag_and_type()) {
+                            case protozero::tag_and_type(OSMIndexData::IndexData::optional_uint32_types, protozero::pbf_wire_type::varint):
+                                index_data.types = static_cast<osmium::osm_entity_bits::type>(message.get_uint32() & osmium::osm_entity_bits::nwra);
+                                break;
+                            case protozero::tag_and_type(OSMIndexData::IndexData::optional_sint64_min_id, protozero::pbf_wire_type::varint):
+                                index_data.min_id = message.get_sint64();
+                                break;
+                            case protozero::tag_and_type(OSMIndexData::IndexData::optional_sint64_max_id, protozero::pbf_wire_type::varint):
+                                index_data.max_id = message.get_sint64();
+                                break;
+                            case protozero::tag_and_type(OSMIndexData::IndexData::optional_sint32_min_x, protozero::pbf_wire_type::varint):
+                                bbox[0] = message.get_sint32();
+                                bbox_fields |= 1U;
+                                break;
+                            case protozero::tag_and_type(OSMIndexData::IndexData::optional_sint32_min_y, protozero::pbf_wire_type::varint):
+                                bbox[1] = message.get_sint32();
+                                bbox_fields |= 2U;
+                                break;
+                            case protozero::tag_and_type(OSMIndexData::IndexData::optional_sint32_max_x, protozero::pbf_wire_type::varint):
+                                bbox[2] = message.get_sint32();
+                                bbox_fields |= 4U;
+                                break;
+                            case protozero::tag_and_type(OSMIndexData::IndexData::optional_sint32_max_y, protozero::pbf_wire_type::varint):
+                                bbox[3] = message.get_sint32();
+                                bbox_fields |= 8U;
+                                break;
+                            default:
+                                message.skip();
+                        }
+                    }
+                } catch (const protozero::exception&) {
+                    return pbf_index_data{};
+                }
+
+                if (bbox_fields == 0xfU && bbox[0] <= bbox[2] && bbox[1] <= bbox[3]) {
+                    index_data.bbox.extend(osmium::Location{bbox[0], bbox[1]});
+                    index_data.bbox.extend(osmium::Location{bbox[2], bbox[3]});
+                }
+
+                return index_data;
+            }
+
+            /**
+             * Decode the BlobHeader. Make sure it contains the expected
+             * type. Return the size of the following Blob. If index_data
+             * is not nullptr, the contents of the indexdata field will be
+             * decoded into it (if there is any).
+             */
+            inline std::size_t decode_blob_header(const data_view& data, const char* expected_type, pbf_index_data* index_data = nullptr) {
+                protozero::pbf_message<FileFormat::BlobHeader> pbf_blob_header{data};
+                data_view blob_header_type;
+                std::size_t blob_header_datasize = 0;
+
+                while (pbf_blob_header.next()) {
+                    switch (pbf_blob_header.tag_and_type()) {
+                        case protozero::tag_and_type(FileFormat::BlobHeader::required_string_type, protozero::pbf_wire_type::length_delimited):
+                            blob_header_type = pbf_blob_header.get_view();
+                            break;
+                        case protozero::tag_and_type(FileFormat::BlobHeader::optional_bytes_indexdata, protozero::pbf_wire_type::length_delimited):
+                            if (index_data) {
+                                *index_data = decode_index_data(pbf_blob_header.get_view());
+                            } else {
+                                pbf_blob_header.skip();
+                            }
+                            break;
+                        case protozero::tag_and_type(FileFormat::BlobHeader::required_int32_datasize, protozero::pbf_wire_type::varint):
+                            blob_header_datasize = pbf_blob_header.get_int32();
+                            break;
+                        default:
+                            pbf_blob_header.skip();
+                    }
+                }
+
+                if (blob_header_datasize == 0) {
+                    throw osmium::pbf_error{"PBF format error: BlobHeader.datasize missing or zero."};
+                }
+
+                if (std::strncmp(expected_type, blob_header_type.data(), blob_header_type.size()) != 0) {
+                    throw osmium::pbf_error{"blob does not have expected type (OSMHeader in first blob, OSMData in following blobs)"};
+                }
+
+                return blob_header_datasize;
+            }
+
+            /**
+             * Get the size of the uncompressed data in a blob without
+             * uncompressing it. If the blob doesn't say, the size of the
+             * blob itself is returned.
+             */
+            inline std::size_t blob_raw_size(const data_view& blob_data) {
+                protozero::pbf_message<FileFormat::Blob> pbf_blob{blob_data};
+                while (pbf_blob.next()) {
+                    switch (pbf_blob.tag_and_type()) {
+                        case protozero::tag_and_type(FileFormat::Blob::optional_bytes_raw, protozero::pbf_wire_type::length_delimited):
+                            return pbf_blob.get_view().size();
+                        case protozero::tag_and_type(FileFormat::Blob::optional_int32_raw_size, protozero::pbf_wire_type::varint):
+                            {
+                                const auto raw_size = pbf_blob.get_int32();
+                                if (raw_size > 0) {
+                                    return static_cast<std::size_t>(raw_size);
+                                }
+                            }
+                            break;
+                        default:
+                            pbf_blob.skip();
+                    }
+                }
+                return blob_data.size();
+            }
+
+            inline data_view decode_blob(const data_view& blob_data, std::string& output) {
                 int32_t raw_size = 0;
                 protozero::data_view compressed_data;
                 pbf_compression use_compression = pbf_compression::none;
@@ -973,7 +1457,13 @@ namespace osmium {
                             throw osmium::pbf_error{"lz4 blobs not supported"};
 #endif
                         case protozero::tag_and_type(FileFormat::Blob::optional_bytes_zstd_data, protozero::pbf_wire_type::length_delimited):
+#ifdef OSMIUM_WITH_ZSTD
+                            use_compression = pbf_compression::zstd;
+                            compressed_data = pbf_blob.get_view();
+                            break;
+#else
                             throw osmium::pbf_error{"zstd blobs not supported"};
+#endif
                         default:
                             pbf_blob.skip();
                     }
@@ -1007,6 +1497,17 @@ namespace osmium {
                         );
 #else
                         break;
+#endif
+                    case pbf_compression::zstd:
+#ifdef OSMIUM_WITH_ZSTD
+                        return osmium::io::detail::zstd_uncompress_string(
+                            compressed_data.data(),
+                            static_cast<unsigned long>(compressed_data.size()), // NOLINT(google-runtime-int)
+                            static_cast<unsigned long>(raw_size), // NOLINT(google-runtime-int)
+                            output
+                        );
+#else
+                        break;
 #endif
                 }
                 std::abort(); // should never be here
@@ -1117,7 +1618,7 @@ namespace osmium {
              * @returns Header object
              * @throws osmium::pbf_error If there was a parsing error
              */
-            inline osmium::io::Header decode_header(const std::string& header_block_data) {
+            inline osmium::io::Header decode_header(const data_view& header_block_data) {
                 std::string output;
 
                 return decode_header_block(decode_blob(header_block_data, output));
@@ -1125,26 +1626,247 @@ namespace osmium {
 
             class PBFDataBlobDecoder {
 
+                // Only one of these two is set. It keeps the memory the
+                // blob data is in alive.
                 std::shared_ptr<std::string> m_input_buffer;
+                std::shared_ptr<osmium::util::MemoryMapping> m_mapping;
+
+                data_view m_input_data;
                 osmium::osm_entity_bits::type m_read_types;
                 osmium::io::read_meta m_read_metadata;
+                std::shared_ptr<osmium::memory::detail::recycler_handle> m_recycler;
+                osmium::io::read_fields::type m_read_which_fields;
+                osmium::metadata_options m_read_metadata_options;
+
+                // Shared with the Reader, so that decoding tasks still
+                // queued in the pool can use it after the Reader is gone.
+                std::shared_ptr<const osmium::TagsFilter> m_tags_filter;
+
+                std::size_t m_sequence = 0;
+                std::shared_ptr<pipeline_counters> m_counters{};
 
             public:
 
-                PBFDataBlobDecoder(std::string&& input_buffer, const osmium::osm_entity_bits::type read_types, const osmium::io::read_meta read_metadata) :
+                PBFDataBlobDecoder(std::string&& input_buffer,
+                                   const osmium::osm_entity_bits::type read_types,
+                                   const osmium::io::read_meta read_metadata,
+                                   std::shared_ptr<osmium::memory::detail::recycler_handle> recycler = nullptr,
+                                   const osmium::io::read_fields::type read_which_fields = osmium::io::read_fields::all,
+                                   const osmium::metadata_options& read_metadata_options = osmium::metadata_options{},
+                                   std::shared_ptr<const osmium::TagsFilter> tags_filter = nullptr) :
                     m_input_buffer(std::make_shared<std::string>(std::move(input_buffer))),
+                    m_input_data(*m_input_buffer),
                     m_read_types(read_types),
-                    m_read_metadata(read_metadata) {
+                    m_read_metadata(read_metadata),
+                    m_recycler(std::move(recycler)),
+                    m_read_which_fields(read_which_fields),
+                    m_read_metadata_options(read_metadata_options),
+                    m_tags_filter(std::move(tags_filter)) {
+                }
+
+                /**
+                 * Create a decoder for blob data inside a memory mapping.
+                 * The data is not copied, the decoder keeps a reference to
+                 * the mapping instead.
+                 */
+                PBFDataBlobDecoder(std::shared_ptr<osmium::util::MemoryMapping> mapping,
+                                   const data_view& input_data,
+                                   const osmium::osm_entity_bits::type read_types,
+                                   const osmium::io::read_meta read_metadata,
+                                   std::shared_ptr<osmium::memory::detail::recycler_handle> recycler = nullptr,
+                                   const osmium::io::read_fields::type read_which_fields = osmium::io::read_fields::all,
+                                   const osmium::metadata_options& read_metadata_options = osmium::metadata_options{},
+                                   std::shared_ptr<const osmium::TagsFilter> tags_filter = nullptr) :
+                    m_mapping(std::move(mapping)),
+                    m_input_data(input_data),
+                    m_read_types(read_types),
+                    m_read_metadata(read_metadata),
+                    m_recycler(std::move(recycler)),
+                    m_read_which_fields(read_which_fields),
+                    m_read_metadata_options(read_metadata_options),
+                    m_tags_filter(std::move(tags_filter)) {
                 }
 
                 osmium::memory::Buffer operator()() {
-                    std::string output;
-                    PBFPrimitiveBlockDecoder decoder{decode_blob(*m_input_buffer, output), m_read_types, m_read_metadata};
-                    return decoder();
+                    // The uncompressed data is only needed while decoding,
+                    // so each thread keeps one scratch string around instead
+                    // of allocating a new one for every blob.
+                    thread_local std::string output;
+                    data_view data;
+                    {
+                        const stage_timer timer{m_counters.get(), pipeline_stage::decompress};
+                        data = decode_blob(m_input_data, output);
+                    }
+                    const stage_timer timer{m_counters.get(), pipeline_stage::parse};
+                    PBFPrimitiveBlockDecoder decoder{data, m_read_types, m_read_metadata, m_recycler.get(), m_read_which_fields, m_read_metadata_options, m_tags_filter.get()};
+                    osmium::memory::Buffer buffer{decoder()};
+                    buffer.set_sequence(m_sequence);
+                    return buffer;
+                }
+
+                /**
+                 * Size of the uncompressed blob data. This is used as an
+                 * estimate for the size of the decoded data before it is
+                 * available.
+                 */
+                std::size_t raw_size() const {
+                    return blob_raw_size(m_input_data);
+                }
+
+                /**
+                 * Set the sequence number the buffer returned by the decoder
+                 * will get.
+                 */
+                void set_sequence(std::size_t sequence) noexcept {
+                    m_sequence = sequence;
+                }
+
+                /**
+                 * Set the counters the time spent decompressing and
+                 * decoding the blob is added to.
+                 */
+                void set_counters(std::shared_ptr<pipeline_counters> counters) noexcept {
+                    m_counters = std::move(counters);
                 }
 
             }; // class PBFDataBlobDecoder
 
+            /**
+             * Decoder for a data blob that only extracts the ids and
+             * locations of the nodes in it. No osmium::Node objects are
+             * built, the string table, tags, and metadata are ignored, and
+             * groups with ways, relations, or areas are skipped.
+             */
+            class PBFNodeColumnsDecoder : public PBFPrimitiveBlockDecoderBase {
+
+                std::shared_ptr<std::string> m_input_buffer;
+
+                osmium::io::NodeColumns m_columns;
+
+                static bool decode_visible(const data_view& data) {
+                    protozero::pbf_message<OSMFormat::Info> pbf_info{data};
+                    if (pbf_info.next(OSMFormat::Info::optional_bool_visible, protozero::pbf_wire_type::varint)) {
+                        return pbf_info.get_bool();
+                    }
+                    return true;
+                }
+
+                void decode_node(const data_view& data) {
+                    osmium::object_id_type id = 0;
+                    bool visible = true;
+                    int64_t lon = std::numeric_limits<int64_t>::max();
+                    int64_t lat = std::numeric_limits<int64_t>::max();
+
+                    protozero::pbf_message<OSMFormat::Node> pbf_node{data};
+                    while (pbf_node.next()) {
+                        switch (pbf_node.tag_and_type()) {
+                            case protozero::tag_and_type(OSMFormat::Node::required_sint64_id, protozero::pbf_wire_type::varint):
+                                id = pbf_node.get_sint64();
+                                break;
+                            case protozero::tag_and_type(OSMFormat::Node::optional_Info_info, protozero::pbf_wire_type::length_delimited):
+                                visible = decode_visible(pbf_node.get_view());
+                                break;
+                            case protozero::tag_and_type(OSMFormat::Node::required_sint64_lat, protozero::pbf_wire_type::varint):
+                                lat = pbf_node.get_sint64();
+                                break;
+                            case protozero::tag_and_type(OSMFormat::Node::required_sint64_lon, protozero::pbf_wire_type::varint):
+                                lon = pbf_node.get_sint64();
+                                break;
+                            default:
+                                pbf_node.skip();
+                        }
+                    }
+
+                    if (!visible) {
+                        m_columns.add(id, osmium::Location{});
+                        return;
+                    }
+
+                    if (lon == std::numeric_limits<int64_t>::max() ||
+                        lat == std::numeric_limits<int64_t>::max()) {
+                        throw osmium::pbf_error{"illegal coordinate format"};
+                    }
+                    m_columns.add(id, osmium::Location{convert_pbf_lon(lon), convert_pbf_lat(lat)});
+                }
+
+                void decode_dense_nodes(const data_view& data) {
+                    data_view ids;
+                    data_view lats;
+                    data_view lons;
+                    varint_range visibles;
+
+                    protozero::pbf_message<OSMFormat::DenseNodes> pbf_dense_nodes{data};
+                    while (pbf_dense_nodes.next()) {
+                        switch (pbf_dense_nodes.tag_and_type()) {
+                            case protozero::tag_and_type(OSMFormat::DenseNodes::packed_sint64_id, protozero::pbf_wire_type::length_delimited):
+                                ids = pbf_dense_nodes.get_view();
+                                break;
+                            case protozero::tag_and_type(OSMFormat::DenseNodes::optional_DenseInfo_denseinfo, protozero::pbf_wire_type::length_delimited):
+                                {
+                                    protozero::pbf_message<OSMFormat::DenseInfo> pbf_dense_info{pbf_dense_nodes.get_message()};
+                                    while (pbf_dense_info.next(OSMFormat::DenseInfo::packed_bool_visible, protozero::pbf_wire_type::length_delimited)) {
+                                        visibles = varint_range{pbf_dense_info.get_view()};
+                                    }
+                                }
+                                break;
+                            case protozero::tag_and_type(OSMFormat::DenseNodes::packed_sint64_lat, protozero::pbf_wire_type::length_delimited):
+                                lats = pbf_dense_nodes.get_view();
+                                break;
+                            case protozero::tag_and_type(OSMFormat::DenseNodes::packed_sint64_lon, protozero::pbf_wire_type::length_delimited):
+                                lons = pbf_dense_nodes.get_view();
+                                break;
+                            default:
+                                pbf_dense_nodes.skip();
+                        }
+                    }
+
+                    decode_dense_node_columns(ids, lats, lons);
+
+                    m_columns.reserve(m_columns.size() + m_dense_ids.size());
+                    for (std::size_t i = 0; i < m_dense_ids.size(); ++i) {
+                        if (!visibles.empty() && visibles.next_int32() == 0) {
+                            m_columns.add(m_dense_ids[i], osmium::Location{});
+                        } else {
+                            m_columns.add(m_dense_ids[i], osmium::Location{convert_pbf_lon(m_dense_lons[i]), convert_pbf_lat(m_dense_lats[i])});
+                        }
+                    }
+                }
+
+                void decode_primitive_block_data(const data_view& data) {
+                    protozero::pbf_message<OSMFormat::PrimitiveBlock> pbf_primitive_block{data};
+                    while (pbf_primitive_block.next(OSMFormat::PrimitiveBlock::repeated_PrimitiveGroup_primitivegroup, protozero::pbf_wire_type::length_delimited)) {
+                        protozero::pbf_message<OSMFormat::PrimitiveGroup> pbf_primitive_group = pbf_primitive_block.get_message();
+                        while (pbf_primitive_group.next()) {
+                            switch (pbf_primitive_group.tag_and_type()) {
+                                case protozero::tag_and_type(OSMFormat::PrimitiveGroup::repeated_Node_nodes, protozero::pbf_wire_type::length_delimited):
+                                    decode_node(pbf_primitive_group.get_view());
+                                    break;
+                                case protozero::tag_and_type(OSMFormat::PrimitiveGroup::optional_DenseNodes_dense, protozero::pbf_wire_type::length_delimited):
+                                    decode_dense_nodes(pbf_primitive_group.get_view());
+                                    break;
+                                default:
+                                    pbf_primitive_group.skip();
+                            }
+                        }
+                    }
+                }
+
+            public:
+
+                explicit PBFNodeColumnsDecoder(std::string&& input_buffer) :
+                    m_input_buffer(std::make_shared<std::string>(std::move(input_buffer))) {
+                }
+
+                osmium::io::NodeColumns operator()() {
+                    thread_local std::string output;
+                    const auto data = decode_blob(data_view{*m_input_buffer}, output);
+                    decode_primitive_block_metadata(data, false);
+                    decode_primitive_block_data(data);
+                    return std::move(m_columns);
+                }
+
+            }; // class PBFNodeColumnsDecoder
+
         } // namespace detail
 
     } // namespace io
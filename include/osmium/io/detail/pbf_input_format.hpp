@@ -33,29 +33,46 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/geom/relations.hpp>
 #include <osmium/io/detail/input_format.hpp>
 #include <osmium/io/detail/pbf.hpp> // IWYU pragma: export
 #include <osmium/io/detail/pbf_decoder.hpp>
 #include <osmium/io/detail/protobuf_tags.hpp>
+#include <osmium/io/detail/read_ahead.hpp>
 #include <osmium/io/detail/read_write.hpp>
 #include <osmium/io/file_format.hpp>
 #include <osmium/io/header.hpp>
+#include <osmium/osm/box.hpp>
 #include <osmium/osm/entity_bits.hpp>
 #include <osmium/thread/pool.hpp>
 #include <osmium/thread/util.hpp>
 #include <osmium/util/config.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/memory_mapping.hpp>
 
 #include <protozero/pbf_message.hpp>
 #include <protozero/types.hpp>
 
+#ifdef _MSC_VER
+# include <io.h>
+#else
+# include <sys/types.h>
+# include <unistd.h>
+#endif
+
+#include <algorithm>
 #include <cassert>
+#include <condition_variable>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <future>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 namespace osmium {
 
@@ -63,12 +80,207 @@ namespace osmium {
 
         namespace detail {
 
+            /**
+             * The result of decoding a blob when reading with
+             * read_order::any together with its size in bytes (an
+             * estimate for the output queue).
+             */
+            struct decoded_blob {
+                std::future<osmium::memory::Buffer> result;
+                std::size_t size;
+            }; // struct decoded_blob
+
+            /**
+             * Keeps track of the blobs given to the thread pool when
+             * reading with read_order::any. The decoder tasks put their
+             * results in here, which never blocks, and the parser thread
+             * moves them to the output queue. So no task in the pool ever
+             * waits on the output queue, which could block all pool
+             * threads while other work (like that of a Writer) is waiting
+             * for them.
+             *
+             * A blob is pending from the time it is given to the pool until
+             * the parser thread has taken its result. This limits the
+             * number of decoded buffers waiting in memory.
+             */
+            class pending_blobs {
+
+                std::mutex m_mutex;
+                std::condition_variable m_changed;
+                std::vector<decoded_blob> m_finished;
+                std::size_t m_count = 0;
+
+            public:
+
+                void add() {
+                    const std::lock_guard<std::mutex> lock{m_mutex};
+                    ++m_count;
+                }
+
+                /// Called by the decoder tasks when they are done.
+                void finished(decoded_blob&& blob) {
+                    const std::lock_guard<std::mutex> lock{m_mutex};
+                    m_finished.push_back(std::move(blob));
+                    m_changed.notify_all();
+                }
+
+                /**
+                 * Wait until less than max_count blobs are pending or
+                 * until at least one blob is finished. Then return the
+                 * results of all finished blobs, they are not pending any
+                 * more after that.
+                 */
+                std::vector<decoded_blob> take_finished(std::size_t max_count) {
+                    std::vector<decoded_blob> blobs;
+                    std::unique_lock<std::mutex> lock{m_mutex};
+                    m_changed.wait(lock, [this, max_count] {
+                        return m_count < max_count || !m_finished.empty();
+                    });
+                    m_count -= m_finished.size();
+                    std::swap(blobs, m_finished);
+                    return blobs;
+                }
+
+                bool empty() {
+                    const std::lock_guard<std::mutex> lock{m_mutex};
+                    return m_count == 0;
+                }
+
+                /**
+                 * Wait until all decoder tasks are done and throw away
+                 * their results. Used when there was an error.
+                 */
+                void discard_all() {
+                    std::unique_lock<std::mutex> lock{m_mutex};
+                    m_changed.wait(lock, [this] {
+                        return m_finished.size() == m_count;
+                    });
+                    m_finished.clear();
+                    m_count = 0;
+                }
+
+            }; // class pending_blobs
+
+            /**
+             * Used instead of a plain PBFDataBlobDecoder when reading with
+             * read_order::any. The decoded buffer is handed to the
+             * pending_blobs as soon as it is ready instead of being
+             * returned through the future from the thread pool.
+             */
+            class PBFUnorderedDataBlobDecoder {
+
+                PBFDataBlobDecoder m_decoder;
+                pending_blobs* m_pending;
+
+            public:
+
+                PBFUnorderedDataBlobDecoder(PBFDataBlobDecoder&& decoder, pending_blobs& pending) :
+                    m_decoder(std::move(decoder)),
+                    m_pending(&pending) {
+                }
+
+                void operator()() {
+                    std::promise<osmium::memory::Buffer> promise;
+                    decoded_blob blob{promise.get_future(), 0};
+                    try {
+                        osmium::memory::Buffer buffer{m_decoder()};
+                        blob.size = payload_size(buffer);
+                        promise.set_value(std::move(buffer));
+                    } catch (...) {
+                        promise.set_exception(std::current_exception());
+                    }
+                    m_pending->finished(std::move(blob));
+                }
+
+            }; // class PBFUnorderedDataBlobDecoder
+
             class PBFParser final : public Parser {
 
                 std::string m_input_buffer{};
                 std::atomic<std::size_t>* m_offset_ptr;
                 int m_fd;
                 bool m_want_buffered_pages_removed;
+                osmium::io::read_mmap m_use_mmap;
+
+                // Only used if the input file is memory mapped. The mapping
+                // is shared with the decoder tasks which are still using it.
+                std::shared_ptr<osmium::util::MemoryMapping> m_mapping{};
+                std::size_t m_mapping_offset = 0;
+
+                // Asks the kernel to read the input file ahead of us (if it
+                // is a regular file and we read it ourselves).
+                read_ahead m_read_ahead{};
+
+                // Range of blobs (as byte offsets) we are interested in and
+                // the offset of the next byte we will read from the input.
+                osmium::io::blob_range m_range;
+                std::size_t m_input_offset = 0;
+
+                // Only blobs overlapping this box are read (if it is valid)
+                osmium::Box m_bbox;
+
+                // Output buffers are taken from here (if set)
+                std::shared_ptr<osmium::memory::detail::recycler_handle> m_recycler;
+                std::shared_ptr<const osmium::TagsFilter> m_tags_filter;
+
+                // Contents of the indexdata field of the last BlobHeader read
+                pbf_index_data m_index_data{};
+
+                // Number of data blobs seen so far (including skipped ones)
+                std::size_t m_blob_count = 0;
+
+                osmium::io::read_order m_order;
+
+                // Only used with read_order::any
+                pending_blobs m_pending{};
+
+                /**
+                 * Memory map the input file if this was asked for and the
+                 * input is a regular file. Otherwise the normal code path
+                 * reading the data will be used.
+                 */
+                void init_mapping() {
+                    if (m_use_mmap == osmium::io::read_mmap::no || m_fd == -1) {
+                        return;
+                    }
+
+                    const auto size = osmium::file_size(m_fd);
+                    if (size == 0) { // not a regular file (or empty)
+                        return;
+                    }
+
+                    m_mapping_offset = osmium::file_offset(m_fd);
+                    m_mapping = std::make_shared<osmium::util::MemoryMapping>(size, osmium::util::MemoryMapping::mapping_mode::readonly, m_fd);
+#ifndef _WIN32
+                    // Tell the kernel we are going to read the mapping sequentially
+                    ::madvise(m_mapping->get_addr(), m_mapping->size(), MADV_SEQUENTIAL);
+#endif
+                }
+
+                /**
+                 * Return a view of the next size bytes of the mapped input
+                 * file and move forward in the file.
+                 *
+                 * @returns view of the data or an empty view if EOF was
+                 *          encountered.
+                 */
+                data_view read_from_mapping(std::size_t size) {
+                    assert(m_mapping);
+                    if (m_mapping->size() - m_mapping_offset < size) {
+                        return data_view{};
+                    }
+
+                    const data_view data{m_mapping->get_addr<char>() + m_mapping_offset, size};
+                    m_mapping_offset += size;
+                    m_input_offset += size;
+                    m_read_ahead.advance(size);
+                    *m_offset_ptr += size;
+                    if (counters()) {
+                        counters()->add_bytes(size);
+                    }
+
+                    return data;
+                }
 
                 /**
                  * Make sure the input data contains at least the specified
@@ -98,13 +310,7 @@ namespace osmium {
                 void pop_from_input_queue(size_t size) {
                     assert(m_fd == -1);
                     m_input_buffer.erase(0, size);
-                }
-
-                static uint32_t get_size_in_network_byte_order(const char* d) noexcept {
-                    return (static_cast<uint32_t>(d[3])) |
-                           (static_cast<uint32_t>(d[2]) <<  8U) |
-                           (static_cast<uint32_t>(d[1]) << 16U) |
-                           (static_cast<uint32_t>(d[0]) << 24U);
+                    m_input_offset += size;
                 }
 
                 static uint32_t check_size(uint32_t size) {
@@ -124,24 +330,99 @@ namespace osmium {
                 bool read_exactly(char* buffer, std::size_t size) {
                     std::size_t to_read = size;
 
-                    while (to_read > 0) {
-                        auto const read_size = osmium::io::detail::reliable_read(m_fd, buffer + (size - to_read), static_cast<unsigned int>(to_read));
-                        if (read_size == 0) { // EOF
-                            return false;
+                    {
+                        const stage_timer timer{counters().get(), pipeline_stage::read};
+                        while (to_read > 0) {
+                            auto const read_size = osmium::io::detail::reliable_read(m_fd, buffer + (size - to_read), static_cast<unsigned int>(to_read));
+                            if (read_size == 0) { // EOF
+                                return false;
+                            }
+                            to_read -= read_size;
                         }
-                        to_read -= read_size;
                     }
 
+                    m_input_offset += size;
                     *m_offset_ptr += size;
+                    m_read_ahead.advance(size);
+                    if (counters()) {
+                        counters()->add_bytes(size);
+                    }
 
                     return true;
                 }
 
+                /**
+                 * Skip forward in the input until the specified offset is
+                 * reached or the input ends. Uses lseek() if possible,
+                 * otherwise the data is read and thrown away.
+                 */
+                void skip_input_to(std::size_t offset) {
+                    if (offset <= m_input_offset) {
+                        return;
+                    }
+                    std::size_t to_skip = offset - m_input_offset;
+
+                    if (m_mapping) {
+                        to_skip = std::min(to_skip, m_mapping->size() - m_mapping_offset);
+                        m_mapping_offset += to_skip;
+                        m_input_offset += to_skip;
+                        *m_offset_ptr += to_skip;
+                        m_read_ahead.advance(to_skip);
+                        return;
+                    }
+
+                    if (m_fd != -1) {
+#ifdef _MSC_VER
+                        osmium::detail::disable_invalid_parameter_handler diph;
+                        const auto result = _lseeki64(m_fd, static_cast<__int64>(to_skip), SEEK_CUR);
+#else
+                        const auto result = ::lseek(m_fd, static_cast<off_t>(to_skip), SEEK_CUR);
+#endif
+                        if (result != -1) {
+                            m_input_offset += to_skip;
+                            *m_offset_ptr += to_skip;
+                            m_read_ahead.advance(to_skip);
+                            return;
+                        }
+
+                        // Not seekable (pipe etc.), read and throw away data
+                        std::string buffer(std::min(to_skip, std::size_t{1024UL * 1024UL}), '\0');
+                        while (to_skip > 0) {
+                            const auto chunk = std::min(to_skip, buffer.size());
+                            if (!read_exactly(&*buffer.begin(), chunk)) {
+                                return; // EOF
+                            }
+                            to_skip -= chunk;
+                        }
+                        return;
+                    }
+
+                    while (to_skip > 0) {
+                        if (m_input_buffer.empty()) {
+                            m_input_buffer = get_input();
+                            if (input_done()) {
+                                return; // EOF
+                            }
+                        }
+                        const auto chunk = std::min(to_skip, m_input_buffer.size());
+                        pop_from_input_queue(chunk);
+                        to_skip -= chunk;
+                    }
+                }
+
                 /**
                  * Read 4 bytes in network byte order from file. They contain
                  * the length of the following BlobHeader.
                  */
                 uint32_t read_blob_header_size_from_file() {
+                    if (m_mapping) {
+                        const auto data = read_from_mapping(sizeof(uint32_t));
+                        if (data.empty()) {
+                            return 0; // EOF
+                        }
+                        return check_size(get_size_in_network_byte_order(data.data()));
+                    }
+
                     if (m_fd != -1) {
                         std::array<char, sizeof(uint32_t)> buffer{};
                         if (!read_exactly(buffer.data(), buffer.size())) {
@@ -167,64 +448,55 @@ namespace osmium {
                     return size;
                 }
 
-                /**
-                 * Decode the BlobHeader. Make sure it contains the expected
-                 * type. Return the size of the following Blob.
-                 */
-                static size_t decode_blob_header(const protozero::data_view& data, const char* expected_type) {
-                    protozero::pbf_message<FileFormat::BlobHeader> pbf_blob_header{data};
-                    protozero::data_view blob_header_type;
-                    size_t blob_header_datasize = 0;
-
-                    while (pbf_blob_header.next()) {
-                        switch (pbf_blob_header.tag_and_type()) {
-                            case protozero::tag_and_type(FileFormat::BlobHeader::required_string_type, protozero::pbf_wire_type::length_delimited):
-                                blob_header_type = pbf_blob_header.get_view();
-                                break;
-                            case protozero::tag_and_type(FileFormat::BlobHeader::required_int32_datasize, protozero::pbf_wire_type::varint):
-                                blob_header_datasize = pbf_blob_header.get_int32();
-                                break;
-                            default:
-                                pbf_blob_header.skip();
-                        }
-                    }
-
-                    if (blob_header_datasize == 0) {
-                        throw osmium::pbf_error{"PBF format error: BlobHeader.datasize missing or zero."};
-                    }
-
-                    if (std::strncmp(expected_type, blob_header_type.data(), blob_header_type.size()) != 0) {
-                        throw osmium::pbf_error{"blob does not have expected type (OSMHeader in first blob, OSMData in following blobs)"};
-                    }
-
-                    return blob_header_datasize;
-                }
-
                 size_t check_type_and_get_blob_size(const char* expected_type) {
                     assert(expected_type);
 
+                    m_index_data = pbf_index_data{};
                     const auto size = read_blob_header_size_from_file();
                     if (size == 0) { // EOF
                         return 0;
                     }
 
+                    if (m_mapping) {
+                        const auto data = read_from_mapping(size);
+                        if (data.empty()) {
+                            throw osmium::pbf_error{"unexpected EOF"};
+                        }
+                        return decode_blob_header(data, expected_type, &m_index_data);
+                    }
+
                     if (m_fd != -1) {
                         auto const buffer = read_from_input_queue_with_check(size);
-                        const auto blob_size = decode_blob_header(protozero::data_view{buffer.data(), size}, expected_type);
+                        const auto blob_size = decode_blob_header(protozero::data_view{buffer.data(), size}, expected_type, &m_index_data);
                         return blob_size;
                     }
 
                     ensure_available_in_input_queue(size);
-                    const auto blob_size = decode_blob_header(protozero::data_view{m_input_buffer.data(), size}, expected_type);
+                    const auto blob_size = decode_blob_header(protozero::data_view{m_input_buffer.data(), size}, expected_type, &m_index_data);
                     pop_from_input_queue(size);
                     return blob_size;
                 }
 
-                std::string read_from_input_queue_with_check(size_t size) {
+                static void check_blob_size(size_t size) {
                     if (size > max_uncompressed_blob_size) {
                         throw osmium::pbf_error{std::string{"invalid blob size: "} +
                                                 std::to_string(size)};
                     }
+                }
+
+                data_view read_from_mapping_with_check(size_t size) {
+                    check_blob_size(size);
+
+                    const auto data = read_from_mapping(size);
+                    if (data.empty()) {
+                        throw osmium::pbf_error{"unexpected EOF"};
+                    }
+
+                    return data;
+                }
+
+                std::string read_from_input_queue_with_check(size_t size) {
+                    check_blob_size(size);
 
                     std::string buffer;
                     if (m_fd != -1) {
@@ -245,19 +517,84 @@ namespace osmium {
                 // Parse the header in the PBF OSMHeader blob.
                 void parse_header_blob() {
                     const auto size = check_type_and_get_blob_size("OSMHeader");
+                    if (m_mapping) {
+                        set_header_value(decode_header(read_from_mapping_with_check(size)));
+                        return;
+                    }
                     const osmium::io::Header header{decode_header(read_from_input_queue_with_check(size))};
                     set_header_value(header);
                 }
 
-                void parse_data_blobs() {
-                    const bool use_pool = osmium::config::use_pool_threads_for_pbf_parsing();
-                    while (const auto size = check_type_and_get_blob_size("OSMData")) {
-                        std::string input_buffer{read_from_input_queue_with_check(size)};
+                PBFDataBlobDecoder make_data_blob_decoder(size_t size) {
+                    if (m_mapping) {
+                        return PBFDataBlobDecoder{m_mapping, read_from_mapping_with_check(size), read_types(), read_metadata(), m_recycler, read_which_fields(), read_metadata_options(), m_tags_filter};
+                    }
+                    return PBFDataBlobDecoder{read_from_input_queue_with_check(size), read_types(), read_metadata(), m_recycler, read_which_fields(), read_metadata_options(), m_tags_filter};
+                }
+
+                /**
+                 * Can the blob, whose BlobHeader we just read, be skipped,
+                 * because it doesn't contain any entities of the types we
+                 * want or because it is outside the bounding box we want?
+                 */
+                bool want_to_skip_blob() const noexcept {
+                    if (!m_index_data.valid()) {
+                        return false;
+                    }
+
+                    if ((m_index_data.types & read_types()) == osmium::osm_entity_bits::nothing) {
+                        return true;
+                    }
+
+                    return m_bbox.valid() &&
+                           m_index_data.bbox.valid() &&
+                           !osmium::geom::overlaps(m_index_data.bbox, m_bbox);
+                }
 
-                        PBFDataBlobDecoder data_blob_parser{std::move(input_buffer), read_types(), read_metadata()};
+                /**
+                 * Move the results of all finished decoder tasks to the
+                 * output queue (only used with read_order::any). Waits
+                 * for a task to finish first if max_count or more blobs
+                 * are pending.
+                 */
+                void send_finished_blobs(std::size_t max_count) {
+                    for (auto& blob : m_pending.take_finished(max_count)) {
+                        send_to_output_queue(std::move(blob.result), blob.size);
+                    }
+                }
 
-                        if (use_pool) {
-                            send_to_output_queue(get_pool().submit(std::move(data_blob_parser)));
+                void parse_data_blobs() {
+                    const bool use_pool = osmium::config::use_pool_threads_for_pbf_parsing();
+                    const bool unordered = use_pool && m_order == osmium::io::read_order::any;
+                    const std::size_t max_pending = osmium::config::get_max_queue_size("OSMDATA", 20);
+                    skip_input_to(m_range.begin);
+
+                    while (m_input_offset < m_range.end) {
+                        const auto size = check_type_and_get_blob_size("OSMData");
+                        if (size == 0) { // EOF
+                            break;
+                        }
+                        ++m_blob_count;
+
+                        // If the BlobHeader tells us this blob doesn't
+                        // contain anything we want, skip it without reading
+                        // or decompressing it.
+                        if (want_to_skip_blob()) {
+                            check_blob_size(size);
+                            skip_input_to(m_input_offset + size);
+                            continue;
+                        }
+                        PBFDataBlobDecoder data_blob_parser{make_data_blob_decoder(size)};
+                        data_blob_parser.set_sequence(m_blob_count);
+                        data_blob_parser.set_counters(counters());
+
+                        if (unordered) {
+                            send_finished_blobs(max_pending);
+                            m_pending.add();
+                            get_pool().submit(PBFUnorderedDataBlobDecoder{std::move(data_blob_parser), m_pending});
+                        } else if (use_pool) {
+                            const auto raw_size = data_blob_parser.raw_size();
+                            send_to_output_queue(get_pool().submit(std::move(data_blob_parser)), raw_size);
                         } else {
                             send_to_output_queue(data_blob_parser());
                         }
@@ -274,7 +611,16 @@ namespace osmium {
                     Parser(args),
                     m_offset_ptr(args.offset_ptr),
                     m_fd(args.fd),
-                    m_want_buffered_pages_removed(args.want_buffered_pages_removed) {
+                    m_want_buffered_pages_removed(args.want_buffered_pages_removed),
+                    m_use_mmap(args.use_mmap),
+                    m_range(args.range),
+                    m_bbox(args.bbox),
+                    m_recycler(args.recycler),
+                    m_tags_filter(args.tags_filter),
+                    m_order(args.order) {
+                    // The decoders add their time to the decompress and
+                    // parse stages themselves.
+                    disable_parse_timer();
                 }
 
                 PBFParser(const PBFParser&) = delete;
@@ -288,10 +634,29 @@ namespace osmium {
                 void run() override {
                     osmium::thread::set_thread_name("_osmium_pbf_in");
 
+                    init_mapping();
+
+                    if (m_fd != -1) {
+                        m_read_ahead = read_ahead{m_fd, osmium::config::get_read_ahead_bytes()};
+                    }
+
                     parse_header_blob();
 
                     if (read_types() != osmium::osm_entity_bits::nothing) {
-                        parse_data_blobs();
+                        // When reading with read_order::any the results of
+                        // the decoder tasks still running have to be sent
+                        // before the end of the data is signaled. If there
+                        // was an error, we still have to wait for the tasks,
+                        // because they use m_pending.
+                        try {
+                            parse_data_blobs();
+                            while (!m_pending.empty()) {
+                                send_finished_blobs(1);
+                            }
+                        } catch (...) {
+                            m_pending.discard_all();
+                            throw;
+                        }
                     }
 
                     osmium::io::detail::reliable_close(m_fd);
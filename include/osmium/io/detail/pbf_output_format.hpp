@@ -33,10 +33,16 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <cmath>
+#include <cstddef>
 #include <cstdint>
 #include <cstdlib>
+#include <iterator>
+#include <limits>
 #include <memory>
 #include <string>
 #include <utility>
@@ -52,9 +58,11 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/io/file.hpp>
 #include <osmium/io/file_format.hpp>
 #include <osmium/io/header.hpp>
+#include <osmium/io/pipeline_stats.hpp>
 #include <osmium/memory/buffer.hpp>
 #include <osmium/memory/item_iterator.hpp>
 #include <osmium/osm/box.hpp>
+#include <osmium/osm/entity_bits.hpp>
 #include <osmium/osm/item_type.hpp>
 #include <osmium/osm/location.hpp>
 #include <osmium/osm/metadata_options.hpp>
@@ -75,6 +83,10 @@ DEALINGS IN THE SOFTWARE.
 # include <osmium/io/detail/lz4.hpp>
 #endif
 
+#ifdef OSMIUM_WITH_ZSTD
+# include <osmium/io/detail/zstd.hpp>
+#endif
+
 #include <protozero/pbf_builder.hpp>
 #include <protozero/pbf_writer.hpp>
 #include <protozero/types.hpp>
@@ -111,6 +123,18 @@ namespace osmium {
                 /// Should node locations be added to ways?
                 bool locations_on_ways = false;
 
+                /**
+                 * Should information about the contents of each blob be
+                 * added to the BlobHeader.indexdata field?
+                 */
+                bool add_index_data = false;
+
+                /**
+                 * Should the string table be sorted so that the most used
+                 * strings get the smallest indexes?
+                 */
+                bool sort_stringtable = false;
+
             }; // struct pbf_output_options
 
             /**
@@ -273,23 +297,61 @@ namespace osmium {
 
                 std::string m_pbf_primitive_group_data;
                 protozero::pbf_builder<OSMFormat::PrimitiveGroup> m_pbf_primitive_group;
-                StringTable m_stringtable;
+                StringTable& m_stringtable;
                 pbf_output_options m_options;
                 std::unique_ptr<DenseNodes> m_dense_nodes{};
                 OSMFormat::PrimitiveGroup m_type;
                 int m_count = 0;
+                osmium::object_id_type m_min_id = std::numeric_limits<osmium::object_id_type>::max();
+                osmium::object_id_type m_max_id = std::numeric_limits<osmium::object_id_type>::min();
+
+                // Bounding box of all objects in this block. Only usable if
+                // all objects have valid locations.
+                osmium::Box m_bbox{};
+                bool m_bbox_usable = true;
+
+                void add_id(osmium::object_id_type id) noexcept {
+                    if (id < m_min_id) {
+                        m_min_id = id;
+                    }
+                    if (id > m_max_id) {
+                        m_max_id = id;
+                    }
+                }
+
+                osmium::osm_entity_bits::type entity_type() const noexcept {
+                    switch (m_type) {
+                        case OSMFormat::PrimitiveGroup::repeated_Node_nodes:
+                        case OSMFormat::PrimitiveGroup::optional_DenseNodes_dense:
+                            return osmium::osm_entity_bits::node;
+                        case OSMFormat::PrimitiveGroup::repeated_Way_ways:
+                            return osmium::osm_entity_bits::way;
+                        case OSMFormat::PrimitiveGroup::repeated_Relation_relations:
+                            return osmium::osm_entity_bits::relation;
+                        case OSMFormat::PrimitiveGroup::repeated_Area_areas:
+                            return osmium::osm_entity_bits::area;
+                        default:
+                            break;
+                    }
+                    return osmium::osm_entity_bits::nothing;
+                }
 
             public:
 
-                explicit PrimitiveBlock(const pbf_output_options& options, OSMFormat::PrimitiveGroup type, size_t bucket_count) :
+                /**
+                 * Create a new block. The string table is cleared and must
+                 * not be used for anything else while this block is used.
+                 */
+                PrimitiveBlock(const pbf_output_options& options, OSMFormat::PrimitiveGroup type, StringTable& stringtable) :
                     m_pbf_primitive_group(m_pbf_primitive_group_data),
-                    m_stringtable(StringTable::default_stringtable_chunk_size, bucket_count),
+                    m_stringtable(stringtable),
                     m_options(options),
                     m_type(type) {
+                    m_stringtable.clear();
                 }
 
-                std::size_t get_bucket_count() const noexcept {
-                    return m_stringtable.get_bucket_count();
+                StringTable& stringtable() noexcept {
+                    return m_stringtable;
                 }
 
                 const std::string& group_data() {
@@ -305,8 +367,9 @@ namespace osmium {
                     }
                 }
 
-                protozero::pbf_builder<OSMFormat::PrimitiveGroup>& group() noexcept {
+                protozero::pbf_builder<OSMFormat::PrimitiveGroup>& group(osmium::object_id_type id) noexcept {
                     ++m_count;
+                    add_id(id);
                     return m_pbf_primitive_group;
                 }
 
@@ -316,6 +379,56 @@ namespace osmium {
                     }
                     m_dense_nodes->add_node(node);
                     ++m_count;
+                    add_id(node.id());
+                    add_location(node.location());
+                }
+
+                /**
+                 * Extend the bounding box of this block by the location.
+                 * If the location is invalid, the extent of the block is
+                 * unknown and no bounding box will be written.
+                 */
+                void add_location(const osmium::Location& location) noexcept {
+                    if (location.valid()) {
+                        m_bbox.extend(location);
+                    } else {
+                        m_bbox_usable = false;
+                    }
+                }
+
+                /**
+                 * Mark this block as containing an object without known
+                 * extent. No bounding box will be written.
+                 */
+                void add_unknown_location() noexcept {
+                    m_bbox_usable = false;
+                }
+
+                /**
+                 * Return the contents for the BlobHeader.indexdata field
+                 * describing this block or an empty string if no index
+                 * data should be written.
+                 */
+                std::string index_data() const {
+                    std::string data;
+                    if (!m_options.add_index_data || m_count == 0) {
+                        return data;
+                    }
+
+                    data.append(OSMIndexData::marker, OSMIndexData::marker_size);
+                    protozero::pbf_builder<OSMIndexData::IndexData> pbf_index_data{data};
+                    pbf_index_data.add_uint32(OSMIndexData::IndexData::optional_uint32_types, static_cast<uint32_t>(entity_type()));
+                    pbf_index_data.add_sint64(OSMIndexData::IndexData::optional_sint64_min_id, m_min_id);
+                    pbf_index_data.add_sint64(OSMIndexData::IndexData::optional_sint64_max_id, m_max_id);
+
+                    if (m_bbox_usable && m_bbox.valid()) {
+                        pbf_index_data.add_sint32(OSMIndexData::IndexData::optional_sint32_min_x, m_bbox.bottom_left().x());
+                        pbf_index_data.add_sint32(OSMIndexData::IndexData::optional_sint32_min_y, m_bbox.bottom_left().y());
+                        pbf_index_data.add_sint32(OSMIndexData::IndexData::optional_sint32_max_x, m_bbox.top_right().x());
+                        pbf_index_data.add_sint32(OSMIndexData::IndexData::optional_sint32_max_y, m_bbox.top_right().y());
+                    }
+
+                    return data;
                 }
 
                 // There are two functions store_in_stringtable(_unsigned)
@@ -364,6 +477,13 @@ namespace osmium {
 
             }; // class PrimitiveBlock
 
+            // Serializing a blob is mostly compressing it, unless
+            // compression is disabled.
+            inline pipeline_stage serialize_stage(pbf_compression use_compression) noexcept {
+                return use_compression == pbf_compression::none ? pipeline_stage::encode
+                                                                : pipeline_stage::compress;
+            }
+
             class SerializeBlob {
 
                 std::shared_ptr<PrimitiveBlock> m_block{};
@@ -445,6 +565,14 @@ namespace osmium {
                             break;
 #else
                             throw osmium::pbf_error{"lz4 blobs not supported"};
+#endif
+                        case pbf_compression::zstd:
+#ifdef OSMIUM_WITH_ZSTD
+                            pbf_blob.add_int32(FileFormat::Blob::optional_int32_raw_size, int32_t(m_msg.size()));
+                            pbf_blob.add_bytes(FileFormat::Blob::optional_bytes_zstd_data, osmium::io::detail::zstd_compress(m_msg, m_compression_level));
+                            break;
+#else
+                            throw osmium::pbf_error{"zstd blobs not supported"};
 #endif
                     }
 
@@ -453,6 +581,13 @@ namespace osmium {
 
                     pbf_blob_header.add_string(FileFormat::BlobHeader::required_string_type, m_blob_type == pbf_blob_type::data ? "OSMData" : "OSMHeader");
 
+                    if (m_block) {
+                        const auto index_data = m_block->index_data();
+                        if (!index_data.empty()) {
+                            pbf_blob_header.add_bytes(FileFormat::BlobHeader::optional_bytes_indexdata, index_data);
+                        }
+                    }
+
                     // The static_cast is okay, because the size can never
                     // be much larger than max_uncompressed_blob_size. This
                     // is due to the assert above and the fact that the zlib
@@ -478,34 +613,172 @@ namespace osmium {
 
             }; // class SerializeBlob
 
-            class PBFOutputFormat : public osmium::io::detail::OutputFormat, public osmium::handler::Handler {
+            /**
+             * Chooses the compression level for each blob if the option
+             * "pbf_compression_level" is set to "auto".
+             *
+             * The level is lowered if the output queue fills up or if the
+             * blocks take longer to encode and compress than the thread
+             * pool can sustain at the rate the blocks come in. It is
+             * raised if the queue is mostly empty and the pool has time to
+             * spare. The level is changed by one step at a time and only
+             * after some blocks were encoded at the current level.
+             */
+            class pbf_compression_level_controller {
+
+                int m_min_level;
+                int m_max_level;
+                std::atomic<int> m_level;
+
+                // Moving average of the time it takes to encode and
+                // compress a block in nanoseconds. Updated from the pool
+                // threads, 0 if no blocks were encoded at this level yet.
+                std::atomic<int64_t> m_latency{0};
+
+                // These are only used from the thread writing the data.
+                // Blocks are submitted in bursts, one burst per buffer, so
+                // the rate is measured over all blocks since the level was
+                // changed.
+                std::chrono::steady_clock::time_point m_level_start{};
+                int m_blocks_at_level = 0;
+
+                static int64_t moving_average(int64_t average, int64_t value) noexcept {
+                    return average == 0 ? value : average + (value - average) / 4;
+                }
+
+            public:
+
+                enum {
+                    min_blocks_at_level = 4
+                };
+
+                pbf_compression_level_controller(int min_level, int max_level, int level) noexcept :
+                    m_min_level(min_level),
+                    m_max_level(max_level),
+                    m_level(level) {
+                }
+
+                int level() const noexcept {
+                    return m_level.load(std::memory_order_relaxed);
+                }
+
+                /**
+                 * Record the time it took to encode and compress a block.
+                 * Called from the pool threads. Concurrent updates might
+                 * get lost, which doesn't matter for an average.
+                 */
+                void add_latency(std::chrono::steady_clock::duration duration) noexcept {
+                    const auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+                    m_latency.store(moving_average(m_latency.load(std::memory_order_relaxed), latency), std::memory_order_relaxed);
+                }
+
+                /**
+                 * Called every time a block is handed to the thread pool.
+                 *
+                 * @param queue_fill How full the output queue is, between
+                 *                   0 (empty) and 1 (full).
+                 * @param num_threads Number of threads in the pool.
+                 */
+                void block_submitted(double queue_fill, int num_threads) noexcept {
+                    const auto now = std::chrono::steady_clock::now();
+                    if (m_blocks_at_level == 0) {
+                        m_level_start = now;
+                    }
+
+                    if (++m_blocks_at_level <= min_blocks_at_level) {
+                        return;
+                    }
+
+                    const auto latency = m_latency.load(std::memory_order_relaxed);
+
+                    // Time the pool has for encoding and compressing one
+                    // block if all threads work on blocks.
+                    const auto interval = std::chrono::duration_cast<std::chrono::nanoseconds>(now - m_level_start).count() / (m_blocks_at_level - 1);
+                    const auto budget = interval * num_threads;
+
+                    int level = m_level.load(std::memory_order_relaxed);
+                    if (queue_fill > 0.75 || latency > budget - budget / 10) {
+                        if (level <= m_min_level) {
+                            return;
+                        }
+                        --level;
+                    } else if (queue_fill < 0.25 && latency > 0 && latency < budget / 2) {
+                        if (level >= m_max_level) {
+                            return;
+                        }
+                        ++level;
+                    } else {
+                        return;
+                    }
+
+                    m_level.store(level, std::memory_order_relaxed);
+                    m_latency.store(0, std::memory_order_relaxed);
+                    m_blocks_at_level = 0;
+                }
+
+            }; // class pbf_compression_level_controller
+
+            /**
+             * Encodes a run of OSM objects into PrimitiveBlocks and
+             * serializes them into blobs, string tables included. This runs
+             * on the thread pool. The objects are referenced through
+             * pointers into the buffers they are in, which are kept alive
+             * by this object.
+             *
+             * Usually all objects fit into one block. If they don't,
+             * because the encoded data gets too large, several blobs are
+             * created one after the other.
+             */
+            class PBFOutputBlock : public osmium::handler::Handler {
+
+                std::vector<std::shared_ptr<osmium::memory::Buffer>> m_buffers{};
+
+                std::vector<const osmium::OSMObject*> m_objects{};
+
+                // Index of the object in m_objects currently encoded.
+                std::size_t m_pos = 0;
 
                 pbf_output_options m_options;
 
+                OSMFormat::PrimitiveGroup m_type;
+
+                // Sum of the sizes of the objects in their buffers. Used as
+                // an estimate of the size of the encoded data.
+                std::size_t m_bytes = 0;
+
+                std::shared_ptr<pipeline_counters> m_counters;
+
+                // Only set if the compression level is chosen automatically.
+                std::shared_ptr<pbf_compression_level_controller> m_level_controller;
+
                 std::shared_ptr<PrimitiveBlock> m_primitive_block{};
 
-                std::size_t m_bucket_count = StringTable::min_bucket_count;
+                // Number of blobs created by this task.
+                int m_blob_count = 0;
+
+                std::string m_output{};
 
                 void store_primitive_block() {
                     if (!m_primitive_block || m_primitive_block->count() == 0) {
                         return;
                     }
 
-                    // Remember the bucket_count of the hash in the string
-                    // table. It will be used when initializing the string
-                    // table for the next block.
-                    //
-                    // Some versions of the std library will set the bucket
-                    // count always larger then what we set it to. We decrease
-                    // the bucket count by one, this way the bucket will not
-                    // grow too much.
-                    m_bucket_count = m_primitive_block->get_bucket_count() - 1;
+                    const auto start = std::chrono::steady_clock::now();
+                    {
+                        const stage_timer timer{m_counters.get(), serialize_stage(m_options.use_compression)};
+                        m_output.append(SerializeBlob{std::move(m_primitive_block),
+                                                      pbf_blob_type::data,
+                                                      m_options.use_compression,
+                                                      m_level_controller ? m_level_controller->level()
+                                                                         : m_options.compression_level}());
+                    }
+                    ++m_blob_count;
 
-                    m_output_queue.push(m_pool.submit(
-                        SerializeBlob{std::move(m_primitive_block),
-                                      pbf_blob_type::data,
-                                      m_options.use_compression,
-                                      m_options.compression_level}));
+                    // The serialization time was added to its own stage,
+                    // take it out of the encode stage again.
+                    if (m_counters) {
+                        m_counters->add_time(pipeline_stage::encode, start - std::chrono::steady_clock::now());
+                    }
                 }
 
                 template <typename T>
@@ -550,128 +823,116 @@ namespace osmium {
                     }
                 }
 
-                void switch_primitive_block_type(OSMFormat::PrimitiveGroup type) {
-                    if (!m_primitive_block || !m_primitive_block->can_add(type)) {
-                        store_primitive_block();
-                        m_primitive_block.reset(new PrimitiveBlock{m_options, type, m_bucket_count});
-                    }
+                // The string table is reused for all blocks created in a
+                // thread, so its memory doesn't have to be allocated again.
+                static StringTable& thread_stringtable() {
+                    thread_local StringTable stringtable;
+                    return stringtable;
                 }
 
-            public:
-
-                PBFOutputFormat(osmium::thread::Pool& pool, const osmium::io::File& file, future_string_queue_type& output_queue) :
-                    OutputFormat(pool, output_queue) {
-
-                    if (!file.get("pbf_add_metadata").empty()) {
-                        throw std::invalid_argument{"The 'pbf_add_metadata' option is deprecated. Please use 'add_metadata' instead."};
-                    }
-
-                    m_options.use_dense_nodes = file.is_not_false("pbf_dense_nodes");
-                    m_options.use_compression = get_compression_type(file.get("pbf_compression"));
-                    m_options.add_metadata = osmium::metadata_options{file.get("add_metadata")};
-                    m_options.add_historical_information_flag = file.has_multiple_object_versions();
-                    m_options.add_visible_flag = file.has_multiple_object_versions();
-                    m_options.locations_on_ways = file.is_true("locations_on_ways");
-
-                    const auto pbl = file.get("pbf_compression_level");
-                    if (pbl.empty()) {
-                        switch (m_options.use_compression) {
-                            case pbf_compression::none:
-                                break;
-                            case pbf_compression::zlib:
-                                m_options.compression_level = osmium::io::detail::zlib_default_compression_level();
-                                break;
-                            case pbf_compression::lz4:
-#ifdef OSMIUM_WITH_LZ4
-                                m_options.compression_level = osmium::io::detail::lz4_default_compression_level();
-#endif
-                                break;
+                /**
+                 * Add the strings of all objects from the current one to the
+                 * end to the string table and sort it so that the most used
+                 * strings get the smallest indexes which are encoded in the
+                 * fewest bytes. If not all objects end up in this block
+                 * because it gets too large, the string table contains some
+                 * strings which are not used. That is wasteful, but valid.
+                 */
+                void prepare_stringtable() {
+                    auto& stringtable = m_primitive_block->stringtable();
+                    for (auto it = std::next(m_objects.cbegin(), static_cast<std::ptrdiff_t>(m_pos)); it != m_objects.cend(); ++it) {
+                        const osmium::OSMObject& object = **it;
+                        for (const auto& tag : object.tags()) {
+                            stringtable.add(tag.key());
+                            stringtable.add(tag.value());
                         }
-                    } else {
-                        char* end_ptr = nullptr;
-                        const auto val = std::strtol(pbl.c_str(), &end_ptr, 10);
-                        if (*end_ptr != '\0') {
-                            throw std::invalid_argument{"The 'pbf_compression_level' option must be an integer."};
+                        if (m_options.add_metadata.user()) {
+                            stringtable.add(object.user());
                         }
-                        switch (m_options.use_compression) {
-                            case pbf_compression::none:
-                                throw std::invalid_argument{"The 'pbf_compression_level' option doesn't make sense without 'pbf_compression' set."};
-                            case pbf_compression::zlib:
-                                osmium::io::detail::zlib_check_compression_level(val);
-                                break;
-                            case pbf_compression::lz4:
-#ifdef OSMIUM_WITH_LZ4
-                                osmium::io::detail::lz4_check_compression_level(val);
-#endif
-                                break;
+                        if (object.type() == osmium::item_type::relation) {
+                            for (const auto& member : static_cast<const osmium::Relation&>(object).members()) {
+                                stringtable.add(member.role());
+                            }
                         }
-                        m_options.compression_level = static_cast<int>(val);
                     }
+                    stringtable.sort_by_frequency();
                 }
 
-                void write_header(const osmium::io::Header& header) final {
-                    std::string data;
-                    protozero::pbf_builder<OSMFormat::HeaderBlock> pbf_header_block{data};
-
-                    if (!header.boxes().empty()) {
-                        protozero::pbf_builder<OSMFormat::HeaderBBox> pbf_header_bbox{pbf_header_block, OSMFormat::HeaderBlock::optional_HeaderBBox_bbox};
-
-                        osmium::Box box = header.joined_boxes();
-                        pbf_header_bbox.add_sint64(OSMFormat::HeaderBBox::required_sint64_left,   int64_t(box.bottom_left().lon() * lonlat_resolution));
-                        pbf_header_bbox.add_sint64(OSMFormat::HeaderBBox::required_sint64_right,  int64_t(box.top_right().lon()   * lonlat_resolution));
-                        pbf_header_bbox.add_sint64(OSMFormat::HeaderBBox::required_sint64_top,    int64_t(box.top_right().lat()   * lonlat_resolution));
-                        pbf_header_bbox.add_sint64(OSMFormat::HeaderBBox::required_sint64_bottom, int64_t(box.bottom_left().lat() * lonlat_resolution));
+                void switch_primitive_block_type(OSMFormat::PrimitiveGroup type) {
+                    if (!m_primitive_block || !m_primitive_block->can_add(type)) {
+                        store_primitive_block();
+                        m_primitive_block.reset(new PrimitiveBlock{m_options, type, thread_stringtable()});
+                        if (m_options.sort_stringtable) {
+                            prepare_stringtable();
+                        }
                     }
+                }
 
-                    pbf_header_block.add_string(OSMFormat::HeaderBlock::repeated_string_required_features, "OsmSchema-V0.6");
+            public:
 
-                    if (m_options.use_dense_nodes) {
-                        pbf_header_block.add_string(OSMFormat::HeaderBlock::repeated_string_required_features, "DenseNodes");
-                    }
+                PBFOutputBlock(const pbf_output_options& options,
+                               OSMFormat::PrimitiveGroup type,
+                               std::shared_ptr<pipeline_counters> counters,
+                               std::shared_ptr<pbf_compression_level_controller> level_controller) :
+                    m_options(options),
+                    m_type(type),
+                    m_counters(std::move(counters)),
+                    m_level_controller(std::move(level_controller)) {
+                    m_objects.reserve(max_entities_per_block);
+                }
 
-                    if (m_options.add_historical_information_flag) {
-                        pbf_header_block.add_string(OSMFormat::HeaderBlock::repeated_string_required_features, "HistoricalInformation");
-                    }
+                std::size_t count() const noexcept {
+                    return m_objects.size();
+                }
 
-                    if (m_options.locations_on_ways) {
-                        pbf_header_block.add_string(OSMFormat::HeaderBlock::repeated_string_optional_features, "LocationsOnWays");
-                    }
+                /// Estimated size of the encoded data.
+                std::size_t size() const noexcept {
+                    return m_bytes;
+                }
 
-                    if (header.get("sorting") == "Type_then_ID") {
-                        pbf_header_block.add_string(OSMFormat::HeaderBlock::repeated_string_optional_features, "Sort.Type_then_ID");
+                /**
+                 * Can an object of the given type and size be added to
+                 * this block?
+                 */
+                bool can_add(OSMFormat::PrimitiveGroup type, std::size_t bytes) const noexcept {
+                    if (m_objects.empty()) {
+                        return true;
                     }
+                    return type == m_type &&
+                           m_objects.size() < max_entities_per_block &&
+                           m_bytes + bytes < PrimitiveBlock::max_used_blob_size;
+                }
 
-                    pbf_header_block.add_string(OSMFormat::HeaderBlock::optional_string_writingprogram, header.get("generator"));
-
-                    const std::string osmosis_replication_timestamp{header.get("osmosis_replication_timestamp")};
-                    if (!osmosis_replication_timestamp.empty()) {
-                        const osmium::Timestamp ts{osmosis_replication_timestamp.c_str()};
-                        pbf_header_block.add_int64(OSMFormat::HeaderBlock::optional_int64_osmosis_replication_timestamp, uint32_t(ts));
+                /**
+                 * Add an object to this block. The buffer must contain the
+                 * object, it is kept alive until the block is encoded.
+                 */
+                void add(const std::shared_ptr<osmium::memory::Buffer>& buffer, const osmium::OSMObject& object) {
+                    if (m_buffers.empty() || m_buffers.back() != buffer) {
+                        m_buffers.push_back(buffer);
                     }
+                    m_objects.push_back(&object);
+                    m_bytes += object.byte_size();
+                }
 
-                    const std::string osmosis_replication_sequence_number{header.get("osmosis_replication_sequence_number")};
-                    if (!osmosis_replication_sequence_number.empty()) {
-                        pbf_header_block.add_int64(OSMFormat::HeaderBlock::optional_int64_osmosis_replication_sequence_number, osmium::detail::str_to_int<int64_t>(osmosis_replication_sequence_number.c_str()));
+                std::string operator()() {
+                    const auto start = std::chrono::steady_clock::now();
+                    {
+                        const stage_timer timer{m_counters.get(), pipeline_stage::encode};
+                        for (m_pos = 0; m_pos < m_objects.size(); ++m_pos) {
+                            osmium::apply_item(*m_objects[m_pos], *this);
+                        }
+                        store_primitive_block();
                     }
 
-                    const std::string osmosis_replication_base_url{header.get("osmosis_replication_base_url")};
-                    if (!osmosis_replication_base_url.empty()) {
-                        pbf_header_block.add_string(OSMFormat::HeaderBlock::optional_string_osmosis_replication_base_url, osmosis_replication_base_url);
+                    if (m_level_controller && m_blob_count > 0) {
+                        m_level_controller->add_latency((std::chrono::steady_clock::now() - start) / m_blob_count);
                     }
 
-                    m_output_queue.push(m_pool.submit(
-                        SerializeBlob{std::move(data),
-                                      pbf_blob_type::header,
-                                      m_options.use_compression,
-                                      m_options.compression_level}));
-                }
-
-                void write_buffer(osmium::memory::Buffer&& buffer) final {
-                    osmium::apply(buffer.cbegin(), buffer.cend(), *this);
-                }
+                    m_buffers.clear();
+                    m_objects.clear();
 
-                void write_end() final {
-                    store_primitive_block();
+                    return std::move(m_output);
                 }
 
                 void node(const osmium::Node& node) {
@@ -682,9 +943,10 @@ namespace osmium {
                     }
 
                     switch_primitive_block_type(OSMFormat::PrimitiveGroup::repeated_Node_nodes);
-                    protozero::pbf_builder<OSMFormat::Node> pbf_node{m_primitive_block->group(), OSMFormat::PrimitiveGroup::repeated_Node_nodes};
+                    protozero::pbf_builder<OSMFormat::Node> pbf_node{m_primitive_block->group(node.id()), OSMFormat::PrimitiveGroup::repeated_Node_nodes};
 
                     pbf_node.add_sint64(OSMFormat::Node::required_sint64_id, node.id());
+                    m_primitive_block->add_location(node.location());
                     add_meta(node, pbf_node);
 
                     pbf_node.add_sint64(OSMFormat::Node::required_sint64_lat, node.location().y());
@@ -693,7 +955,7 @@ namespace osmium {
 
                 void way(const osmium::Way& way) {
                     switch_primitive_block_type(OSMFormat::PrimitiveGroup::repeated_Way_ways);
-                    protozero::pbf_builder<OSMFormat::Way> pbf_way{m_primitive_block->group(), OSMFormat::PrimitiveGroup::repeated_Way_ways};
+                    protozero::pbf_builder<OSMFormat::Way> pbf_way{m_primitive_block->group(way.id()), OSMFormat::PrimitiveGroup::repeated_Way_ways};
 
                     pbf_way.add_int64(OSMFormat::Way::required_int64_id, way.id());
                     add_meta(way, pbf_way);
@@ -707,6 +969,9 @@ namespace osmium {
                     }
 
                     if (m_options.locations_on_ways) {
+                        for (const auto& node_ref : way.nodes()) {
+                            m_primitive_block->add_location(node_ref.location());
+                        }
                         {
                             osmium::DeltaEncode<int64_t, int64_t> delta;
                             protozero::packed_field_sint64 field{pbf_way, protozero::pbf_tag_type(OSMFormat::Way::packed_sint64_lon)};
@@ -721,14 +986,17 @@ namespace osmium {
                                 field.add_element(delta.update(node_ref.location().y()));
                             }
                         }
+                    } else {
+                        m_primitive_block->add_unknown_location();
                     }
                 }
 
                 void relation(const osmium::Relation& relation) {
                     switch_primitive_block_type(OSMFormat::PrimitiveGroup::repeated_Relation_relations);
-                    protozero::pbf_builder<OSMFormat::Relation> pbf_relation{m_primitive_block->group(), OSMFormat::PrimitiveGroup::repeated_Relation_relations};
+                    protozero::pbf_builder<OSMFormat::Relation> pbf_relation{m_primitive_block->group(relation.id()), OSMFormat::PrimitiveGroup::repeated_Relation_relations};
 
                     pbf_relation.add_int64(OSMFormat::Relation::required_int64_id, relation.id());
+                    m_primitive_block->add_unknown_location();
                     add_meta(relation, pbf_relation);
 
                     {
@@ -757,13 +1025,16 @@ namespace osmium {
                 void area(const osmium::Area& area)
                 {
                     switch_primitive_block_type(OSMFormat::PrimitiveGroup::repeated_Area_areas);
-                    protozero::pbf_builder<OSMFormat::Area> pbf_area{ m_primitive_block->group(), OSMFormat::PrimitiveGroup::repeated_Area_areas };
+                    protozero::pbf_builder<OSMFormat::Area> pbf_area{ m_primitive_block->group(area.id()), OSMFormat::PrimitiveGroup::repeated_Area_areas };
 
                     pbf_area.add_int64(OSMFormat::Area::required_int64_id, area.id());
                     add_meta(area, pbf_area);
 
                     for (const auto& oring : area.outer_rings())
                     {
+                        for (const auto& node_ref : oring) {
+                            m_primitive_block->add_location(node_ref.location());
+                        }
                         outer_ring(area, oring, pbf_area);
                     }
                 }
@@ -838,6 +1109,224 @@ namespace osmium {
                     }
                 }
 
+            }; // class PBFOutputBlock
+
+            class PBFOutputFormat : public osmium::io::detail::OutputFormat {
+
+                pbf_output_options m_options;
+
+                // Objects collected for the next block, possibly from
+                // several buffers.
+                std::unique_ptr<PBFOutputBlock> m_block{};
+
+                std::shared_ptr<pbf_compression_level_controller> m_level_controller{};
+
+                OSMFormat::PrimitiveGroup group_type(const osmium::OSMObject& object) const noexcept {
+                    switch (object.type()) {
+                        case osmium::item_type::node:
+                            return m_options.use_dense_nodes ? OSMFormat::PrimitiveGroup::optional_DenseNodes_dense
+                                                             : OSMFormat::PrimitiveGroup::repeated_Node_nodes;
+                        case osmium::item_type::way:
+                            return OSMFormat::PrimitiveGroup::repeated_Way_ways;
+                        case osmium::item_type::relation:
+                            return OSMFormat::PrimitiveGroup::repeated_Relation_relations;
+                        default: // osmium::item_type::area
+                            break;
+                    }
+                    return OSMFormat::PrimitiveGroup::repeated_Area_areas;
+                }
+
+                // Hand the collected objects over to the thread pool. The
+                // blocks are encoded in parallel, the order of the output
+                // is kept by the output queue.
+                void store_block() {
+                    if (!m_block || m_block->count() == 0) {
+                        return;
+                    }
+
+                    const auto size = m_block->size();
+                    push_to_output_queue([&]() {
+                        m_output_queue.push(m_pool.submit(std::move(*m_block)), size);
+                    });
+                    m_block.reset();
+
+                    if (m_level_controller) {
+                        m_level_controller->block_submitted(output_queue_fill(), m_pool.num_threads());
+                    }
+                }
+
+                // How full the output queue is, 0 is empty, 1 is full.
+                double output_queue_fill() const noexcept {
+                    double fill = static_cast<double>(m_output_queue.size()) / static_cast<double>(m_output_queue.max_size());
+                    if (m_output_queue.max_bytes() > 0) {
+                        fill = std::max(fill, static_cast<double>(m_output_queue.bytes()) / static_cast<double>(m_output_queue.max_bytes()));
+                    }
+                    return fill;
+                }
+
+            public:
+
+                PBFOutputFormat(osmium::thread::Pool& pool, const osmium::io::File& file, future_string_queue_type& output_queue) :
+                    OutputFormat(pool, output_queue) {
+
+                    if (!file.get("pbf_add_metadata").empty()) {
+                        throw std::invalid_argument{"The 'pbf_add_metadata' option is deprecated. Please use 'add_metadata' instead."};
+                    }
+
+                    m_options.use_dense_nodes = file.is_not_false("pbf_dense_nodes");
+                    m_options.use_compression = get_compression_type(file.get("pbf_compression"));
+                    m_options.add_metadata = osmium::metadata_options{file.get("add_metadata")};
+                    m_options.add_historical_information_flag = file.has_multiple_object_versions();
+                    m_options.add_visible_flag = file.has_multiple_object_versions();
+                    m_options.locations_on_ways = file.is_true("locations_on_ways");
+                    m_options.add_index_data = file.is_true("pbf_index_data");
+                    m_options.sort_stringtable = file.is_true("pbf_sort_stringtable");
+
+                    const auto pbl = file.get("pbf_compression_level");
+                    if (pbl == "auto") {
+                        switch (m_options.use_compression) {
+                            case pbf_compression::none:
+                                throw std::invalid_argument{"The 'pbf_compression_level' option doesn't make sense without 'pbf_compression' set."};
+                            case pbf_compression::zlib:
+                                m_level_controller = std::make_shared<pbf_compression_level_controller>(1, 9, 6);
+                                break;
+                            case pbf_compression::lz4:
+                                throw std::invalid_argument{"The 'pbf_compression_level' option can not be 'auto' for lz4 compression."};
+                            case pbf_compression::zstd:
+#ifdef OSMIUM_WITH_ZSTD
+                                m_level_controller = std::make_shared<pbf_compression_level_controller>(1, 19, osmium::io::detail::zstd_default_compression_level());
+#endif
+                                break;
+                        }
+                        if (m_level_controller) {
+                            m_options.compression_level = m_level_controller->level();
+                        }
+                    } else if (pbl.empty()) {
+                        switch (m_options.use_compression) {
+                            case pbf_compression::none:
+                                break;
+                            case pbf_compression::zlib:
+                                m_options.compression_level = osmium::io::detail::zlib_default_compression_level();
+                                break;
+                            case pbf_compression::lz4:
+#ifdef OSMIUM_WITH_LZ4
+                                m_options.compression_level = osmium::io::detail::lz4_default_compression_level();
+#endif
+                                break;
+                            case pbf_compression::zstd:
+#ifdef OSMIUM_WITH_ZSTD
+                                m_options.compression_level = osmium::io::detail::zstd_default_compression_level();
+#endif
+                                break;
+                        }
+                    } else {
+                        char* end_ptr = nullptr;
+                        const auto val = std::strtol(pbl.c_str(), &end_ptr, 10);
+                        if (*end_ptr != '\0') {
+                            throw std::invalid_argument{"The 'pbf_compression_level' option must be an integer."};
+                        }
+                        switch (m_options.use_compression) {
+                            case pbf_compression::none:
+                                throw std::invalid_argument{"The 'pbf_compression_level' option doesn't make sense without 'pbf_compression' set."};
+                            case pbf_compression::zlib:
+                                osmium::io::detail::zlib_check_compression_level(val);
+                                break;
+                            case pbf_compression::lz4:
+#ifdef OSMIUM_WITH_LZ4
+                                osmium::io::detail::lz4_check_compression_level(val);
+#endif
+                                break;
+                            case pbf_compression::zstd:
+#ifdef OSMIUM_WITH_ZSTD
+                                osmium::io::detail::zstd_check_compression_level(val);
+#endif
+                                break;
+                        }
+                        m_options.compression_level = static_cast<int>(val);
+                    }
+                }
+
+                void write_header(const osmium::io::Header& header) final {
+                    std::string data;
+                    protozero::pbf_builder<OSMFormat::HeaderBlock> pbf_header_block{data};
+
+                    if (!header.boxes().empty()) {
+                        protozero::pbf_builder<OSMFormat::HeaderBBox> pbf_header_bbox{pbf_header_block, OSMFormat::HeaderBlock::optional_HeaderBBox_bbox};
+
+                        osmium::Box box = header.joined_boxes();
+                        pbf_header_bbox.add_sint64(OSMFormat::HeaderBBox::required_sint64_left,   int64_t(box.bottom_left().lon() * lonlat_resolution));
+                        pbf_header_bbox.add_sint64(OSMFormat::HeaderBBox::required_sint64_right,  int64_t(box.top_right().lon()   * lonlat_resolution));
+                        pbf_header_bbox.add_sint64(OSMFormat::HeaderBBox::required_sint64_top,    int64_t(box.top_right().lat()   * lonlat_resolution));
+                        pbf_header_bbox.add_sint64(OSMFormat::HeaderBBox::required_sint64_bottom, int64_t(box.bottom_left().lat() * lonlat_resolution));
+                    }
+
+                    pbf_header_block.add_string(OSMFormat::HeaderBlock::repeated_string_required_features, "OsmSchema-V0.6");
+
+                    if (m_options.use_dense_nodes) {
+                        pbf_header_block.add_string(OSMFormat::HeaderBlock::repeated_string_required_features, "DenseNodes");
+                    }
+
+                    if (m_options.add_historical_information_flag) {
+                        pbf_header_block.add_string(OSMFormat::HeaderBlock::repeated_string_required_features, "HistoricalInformation");
+                    }
+
+                    if (m_options.locations_on_ways) {
+                        pbf_header_block.add_string(OSMFormat::HeaderBlock::repeated_string_optional_features, "LocationsOnWays");
+                    }
+
+                    if (header.get("sorting") == "Type_then_ID") {
+                        pbf_header_block.add_string(OSMFormat::HeaderBlock::repeated_string_optional_features, "Sort.Type_then_ID");
+                    }
+
+                    pbf_header_block.add_string(OSMFormat::HeaderBlock::optional_string_writingprogram, header.get("generator"));
+
+                    const std::string osmosis_replication_timestamp{header.get("osmosis_replication_timestamp")};
+                    if (!osmosis_replication_timestamp.empty()) {
+                        const osmium::Timestamp ts{osmosis_replication_timestamp.c_str()};
+                        pbf_header_block.add_int64(OSMFormat::HeaderBlock::optional_int64_osmosis_replication_timestamp, uint32_t(ts));
+                    }
+
+                    const std::string osmosis_replication_sequence_number{header.get("osmosis_replication_sequence_number")};
+                    if (!osmosis_replication_sequence_number.empty()) {
+                        pbf_header_block.add_int64(OSMFormat::HeaderBlock::optional_int64_osmosis_replication_sequence_number, osmium::detail::str_to_int<int64_t>(osmosis_replication_sequence_number.c_str()));
+                    }
+
+                    const std::string osmosis_replication_base_url{header.get("osmosis_replication_base_url")};
+                    if (!osmosis_replication_base_url.empty()) {
+                        pbf_header_block.add_string(OSMFormat::HeaderBlock::optional_string_osmosis_replication_base_url, osmosis_replication_base_url);
+                    }
+
+                    const auto size = data.size();
+                    send_to_output_queue(submit(
+                        SerializeBlob{std::move(data),
+                                      pbf_blob_type::header,
+                                      m_options.use_compression,
+                                      m_options.compression_level}, serialize_stage(m_options.use_compression)), size);
+                }
+
+                /**
+                 * Split the objects in the buffer into blocks. Objects are
+                 * only looked at here to find out their type and size, all
+                 * the encoding work is done on the thread pool.
+                 */
+                void write_buffer(osmium::memory::Buffer&& buffer) final {
+                    const auto shared_buffer = std::make_shared<osmium::memory::Buffer>(std::move(buffer));
+                    for (const auto& object : shared_buffer->select<osmium::OSMObject>()) {
+                        const auto type = group_type(object);
+                        if (m_block && !m_block->can_add(type, object.byte_size())) {
+                            store_block();
+                        }
+                        if (!m_block) {
+                            m_block.reset(new PBFOutputBlock{m_options, type, m_counters, m_level_controller});
+                        }
+                        m_block->add(shared_buffer, object);
+                    }
+                }
+
+                void write_end() final {
+                    store_block();
+                }
+
             }; // class PBFOutputFormat
 
             // we want the register_output_format() function to run, setting
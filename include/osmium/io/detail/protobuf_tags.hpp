@@ -33,6 +33,8 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <cstddef>
+
 #include <protozero/types.hpp>
 
 namespace osmium {
@@ -187,6 +189,29 @@ namespace osmium {
 
             } // namespace OSMFormat
 
+            // Contents of the optional BlobHeader.indexdata field as written
+            // by libosmium. The format leaves this field to the
+            // implementation, other readers will ignore it. The protobuf
+            // message is prefixed with a marker so that data written by
+            // other programs into this field is not misinterpreted.
+
+            namespace OSMIndexData {
+
+                constexpr const char marker[] = "OSMIndexData-1";
+                constexpr const std::size_t marker_size = sizeof(marker) - 1;
+
+                enum class IndexData : protozero::pbf_tag_type {
+                    optional_uint32_types  = 1,
+                    optional_sint64_min_id = 2,
+                    optional_sint64_max_id = 3,
+                    optional_sint32_min_x  = 4,
+                    optional_sint32_min_y  = 5,
+                    optional_sint32_max_x  = 6,
+                    optional_sint32_max_y  = 7
+                };
+
+            } // namespace OSMIndexData
+
         } // namespace detail
 
     } // namespace io
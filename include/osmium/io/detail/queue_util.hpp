@@ -35,8 +35,10 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/memory/buffer.hpp>
 #include <osmium/thread/queue.hpp>
+#include <osmium/thread/spsc_queue.hpp>
 
 #include <cassert>
+#include <cstddef>
 #include <exception>
 #include <future>
 #include <string>
@@ -51,6 +53,13 @@ namespace osmium {
             template <typename T>
             using future_queue_type = osmium::thread::Queue<std::future<T>>;
 
+            /**
+             * Like future_queue_type, but for queues with only one thread
+             * pushing and one thread popping.
+             */
+            template <typename T>
+            using future_spsc_queue_type = osmium::thread::SPSCQueue<std::future<T>>;
+
             /**
              * This type of queue contains buffers with OSM data in them.
              * The "end of file" is marked by an invalid Buffer.
@@ -66,26 +75,39 @@ namespace osmium {
              * The "end of file" is marked by an empty string.
              * The strings are wrapped in a std::future so that they can also
              * transport exceptions. The future also helps with keeping the
-             * data in order.
+             * data in order. There is always only one thread writing to and
+             * one thread reading from this queue.
              */
-            using future_string_queue_type = future_queue_type<std::string>;
+            using future_string_queue_type = future_spsc_queue_type<std::string>;
 
-            template <typename T>
-            inline void add_to_queue(future_queue_type<T>& queue, T&& data) {
+            /**
+             * Size of the data in bytes. Used for limiting the memory
+             * used by the queues.
+             */
+            inline std::size_t payload_size(const std::string& data) noexcept {
+                return data.size();
+            }
+
+            inline std::size_t payload_size(const osmium::memory::Buffer& buffer) noexcept {
+                return buffer ? buffer.committed() : 0;
+            }
+
+            template <typename T, template <typename> class TQueue>
+            inline void add_to_queue(TQueue<std::future<T>>& queue, T&& data) {
                 std::promise<T> promise;
-                queue.push(promise.get_future());
+                queue.push(promise.get_future(), payload_size(data));
                 promise.set_value(std::forward<T>(data));
             }
 
-            template <typename T>
-            inline void add_to_queue(future_queue_type<T>& queue, std::exception_ptr&& exception) {
+            template <typename T, template <typename> class TQueue>
+            inline void add_to_queue(TQueue<std::future<T>>& queue, std::exception_ptr&& exception) {
                 std::promise<T> promise;
                 queue.push(promise.get_future());
                 promise.set_exception(std::move(exception));
             }
 
-            template <typename T>
-            inline void add_end_of_data_to_queue(future_queue_type<T>& queue) {
+            template <typename T, template <typename> class TQueue>
+            inline void add_end_of_data_to_queue(TQueue<std::future<T>>& queue) {
                 add_to_queue<T>(queue, T{});
             }
 
@@ -97,14 +119,14 @@ namespace osmium {
                 return !buffer;
             }
 
-            template <typename T>
+            template <typename T, typename TQueue = future_queue_type<T>>
             class queue_wrapper {
 
-                future_queue_type<T>& m_queue;
+                TQueue& m_queue;
 
             public:
 
-                explicit queue_wrapper(future_queue_type<T>& queue) :
+                explicit queue_wrapper(TQueue& queue) :
                     m_queue(queue) {
                 }
 
@@ -0,0 +1,149 @@
+#ifndef OSMIUM_IO_DETAIL_READ_AHEAD_HPP
+#define OSMIUM_IO_DETAIL_READ_AHEAD_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2023 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <algorithm>
+#include <cstddef>
+#include <fcntl.h>
+
+#if defined(__linux__) || defined(__FreeBSD__)
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            /**
+             * Tells the kernel to read a file ahead of the current position
+             * in chunks of a few megabytes, so that several large reads are
+             * in flight on the device while the data read before is being
+             * processed. The kernel's own readahead window is far too small
+             * to keep a fast SSD busy.
+             *
+             * Only regular files are read ahead. Removing pages from the
+             * buffer cache behind the current position (see
+             * remove_buffered_pages()) works together with this, so the
+             * data only stays in the cache for the time it is needed.
+             */
+            class read_ahead {
+
+                enum : std::size_t {
+                    chunk_size = 4UL * 1024UL * 1024UL
+                };
+
+                int m_fd = -1;
+
+                // How far ahead of the current position should we read?
+                std::size_t m_window = 0;
+
+                std::size_t m_file_size = 0;
+
+                // Current position in the file.
+                std::size_t m_offset = 0;
+
+                // Read ahead has been requested up to this offset.
+                std::size_t m_requested = 0;
+
+            public:
+
+                read_ahead() noexcept = default;
+
+                /**
+                 * Start reading ahead the given number of bytes from the
+                 * current position of fd. Does nothing if window is 0 or
+                 * fd is not a regular file.
+                 */
+                read_ahead(const int fd, const std::size_t window) noexcept {
+#if defined(__linux__) || defined(__FreeBSD__)
+                    struct stat s; // NOLINT(cppcoreguidelines-pro-type-member-init,hicpp-member-init)
+                    if (window == 0 || fd < 0 || ::fstat(fd, &s) != 0 || !S_ISREG(s.st_mode)) { // NOLINT(hicpp-signed-bitwise)
+                        return;
+                    }
+                    const auto offset = ::lseek(fd, 0, SEEK_CUR);
+                    if (offset < 0) {
+                        return;
+                    }
+                    m_fd = fd;
+                    m_window = window;
+                    m_file_size = static_cast<std::size_t>(s.st_size);
+                    m_offset = static_cast<std::size_t>(offset);
+                    m_requested = m_offset;
+                    advance(0);
+#else
+                    (void)fd;
+                    (void)window;
+#endif
+                }
+
+                /**
+                 * Tell the read ahead that the current position in the file
+                 * moved forward by the given number of bytes (because they
+                 * were read or skipped). Whenever there is room for another
+                 * chunk in the window, it is requested from the kernel.
+                 */
+                void advance(const std::size_t bytes) noexcept {
+                    if (m_fd < 0) {
+                        return;
+                    }
+                    m_offset += bytes;
+                    m_requested = std::max(m_requested, m_offset);
+
+                    const auto end = std::min(m_offset + m_window, m_file_size);
+                    while (m_requested < end && (end - m_requested >= chunk_size || end == m_file_size)) {
+                        const auto size = std::min(std::size_t{chunk_size}, end - m_requested);
+#if defined(__linux__) || defined(__FreeBSD__)
+                        ::posix_fadvise(m_fd, static_cast<off_t>(m_requested), static_cast<off_t>(size), POSIX_FADV_WILLNEED);
+#endif
+                        m_requested += size;
+                    }
+                }
+
+                /// Offset up to which read ahead has been requested.
+                std::size_t requested() const noexcept {
+                    return m_requested;
+                }
+
+            }; // class read_ahead
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_READ_AHEAD_HPP
@@ -35,6 +35,7 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/io/compression.hpp>
 #include <osmium/io/detail/queue_util.hpp>
+#include <osmium/io/pipeline_stats.hpp>
 #include <osmium/thread/util.hpp>
 
 #include <atomic>
@@ -60,6 +61,8 @@ namespace osmium {
                 // only used in the sub-thread
                 osmium::io::Decompressor& m_decompressor;
                 future_string_queue_type& m_queue;
+                pipeline_counters* m_counters;
+                pipeline_stage m_stage;
 
                 // used in both threads
                 std::atomic<bool> m_done;
@@ -72,7 +75,11 @@ namespace osmium {
 
                     try {
                         while (!m_done) {
-                            std::string data{m_decompressor.read()};
+                            std::string data;
+                            {
+                                const stage_timer timer{m_counters, m_stage};
+                                data = m_decompressor.read();
+                            }
                             if (at_end_of_data(data)) {
                                 break;
                             }
@@ -89,10 +96,18 @@ namespace osmium {
 
             public:
 
+                /**
+                 * The time spent in Decompressor::read() is added to the
+                 * given stage of the counters (if they are not nullptr).
+                 */
                 ReadThreadManager(osmium::io::Decompressor& decompressor,
-                                  future_string_queue_type& queue) :
+                                  future_string_queue_type& queue,
+                                  pipeline_counters* counters = nullptr,
+                                  pipeline_stage stage = pipeline_stage::read) :
                     m_decompressor(decompressor),
                     m_queue(queue),
+                    m_counters(counters),
+                    m_stage(stage),
                     m_done(false),
                     m_thread(std::thread(&ReadThreadManager::run_in_thread, this)) {
                 }
@@ -231,6 +231,47 @@ namespace osmium {
                 }
             }
 
+            /**
+             * Closes a file descriptor when it goes out of scope unless
+             * release() was called. Used to make sure a file is closed even
+             * if writing the last data or syncing it fails. Errors from
+             * close are ignored in that case.
+             */
+            class fd_close_guard {
+
+                int m_fd;
+
+            public:
+
+                explicit fd_close_guard(const int fd) noexcept :
+                    m_fd(fd) {
+                }
+
+                fd_close_guard(const fd_close_guard&) = delete;
+                fd_close_guard& operator=(const fd_close_guard&) = delete;
+
+                fd_close_guard(fd_close_guard&&) = delete;
+                fd_close_guard& operator=(fd_close_guard&&) = delete;
+
+                ~fd_close_guard() noexcept {
+                    if (m_fd >= 0) {
+#ifdef _WIN32
+                        _close(m_fd);
+#else
+                        ::close(m_fd);
+#endif
+                    }
+                }
+
+                /// Stop guarding the file descriptor and return it.
+                int release() noexcept {
+                    const int fd = m_fd;
+                    m_fd = -1;
+                    return fd;
+                }
+
+            }; // class fd_close_guard
+
             inline int reliable_dup(const int fd) {
 #ifdef _MSC_VER
                 osmium::detail::disable_invalid_parameter_handler diph;
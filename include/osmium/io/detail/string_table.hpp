@@ -35,15 +35,15 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/io/detail/pbf.hpp>
 
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <iterator>
-#include <list>
+#include <numeric>
 #include <string>
-#include <unordered_map>
-#include <utility>
+#include <vector>
 
 namespace osmium {
 
@@ -52,247 +52,271 @@ namespace osmium {
         namespace detail {
 
             /**
-             * class StringStore
+             * class StringTable
              *
-             * Storage of lots of strings (const char *). Memory is allocated in chunks.
-             * If a string is added and there is no space in the current chunk, a new
-             * chunk will be allocated. Strings added to the store must not be larger
-             * than the chunk size.
-             *
-             * All memory is released when the destructor is called. There is no other way
-             * to release all or part of the memory.
+             * The string table of a PBF primitive block. Each string added
+             * gets an index, adding the same string again returns the same
+             * index. Index 0 is always the empty string, it is reserved
+             * by the PBF format as a delimiter.
              *
+             * The strings are stored one after the other in one contiguous
+             * arena. They are indexed by an open-addressing hash table
+             * with linear probing which caches the hash of each string.
+             * The string table can be cleared in O(1) and reused for the
+             * next block, memory allocated for it is kept.
              */
-            class StringStore {
-
-                size_t m_chunk_size;
+            class StringTable {
 
-                std::list<std::string> m_chunks;
+                // This is the maximum number of entries in a string table.
+                // This should never be reached in practice but we better
+                // make sure it doesn't. If we had max_uncompressed_blob_size
+                // many entries, we are sure they would never fit into a PBF
+                // Blob.
+                enum {
+                    max_entries = static_cast<int32_t>(max_uncompressed_blob_size)
+                };
 
-                void add_chunk() {
-                    m_chunks.emplace_back();
-                    m_chunks.back().reserve(m_chunk_size);
-                }
+                enum {
+                    min_slots = 1024
+                };
 
-            public:
+                // No default member initializers here, because this must
+                // be an aggregate in C++11. Slots are always created with
+                // slot{} which sets all members to 0.
+                struct slot {
+                    uint32_t hash;
+                    int32_t index;
 
-                explicit StringStore(size_t chunk_size) :
-                    m_chunk_size(chunk_size) {
-                    add_chunk();
-                }
+                    // The slot is only used if this is the same as the
+                    // generation of the table.
+                    uint32_t generation;
+                };
 
-                void clear() noexcept {
-                    assert(!m_chunks.empty());
-                    m_chunks.erase(std::next(m_chunks.begin()), m_chunks.end());
-                    m_chunks.front().clear();
-                }
+                // All strings including their 0-termination.
+                std::string m_data;
 
-                /**
-                 * Add a null terminated string to the store. This will
-                 * automatically get more memory if we are out.
-                 * Returns a pointer to the copy of the string we have
-                 * allocated.
-                 */
-                const char* add(const char* string) {
-                    const size_t len = std::strlen(string) + 1;
+                // Offset in m_data, hash and number of uses of each entry.
+                std::vector<std::size_t> m_offsets;
+                std::vector<uint32_t> m_hashes;
+                std::vector<uint32_t> m_counts;
 
-                    assert(len <= m_chunk_size);
+                std::vector<slot> m_slots;
+                uint32_t m_generation = 1;
 
-                    size_t chunk_len = m_chunks.back().size();
-                    if (chunk_len + len > m_chunks.back().capacity()) {
-                        add_chunk();
-                        chunk_len = 0;
+                static uint32_t hash_string(const char* str, std::size_t& length) noexcept {
+                    // FNV-1a, also calculating the length of the string.
+                    uint64_t hash = 14695981039346656037ULL;
+                    const char* end = str;
+                    while (*end) {
+                        hash ^= static_cast<unsigned char>(*end++);
+                        hash *= 1099511628211ULL;
                     }
-
-                    m_chunks.back().append(string);
-                    m_chunks.back().append(1, '\0');
-
-                    return m_chunks.back().c_str() + chunk_len;
+                    length = static_cast<std::size_t>(end - str);
+                    return static_cast<uint32_t>(hash ^ (hash >> 32U));
                 }
 
-                class const_iterator {
-
-                    using it_type = std::list<std::string>::const_iterator;
-
-                    it_type m_it;
-                    const it_type m_last;
-                    const char* m_pos;
-
-                public:
-
-                    using iterator_category = std::forward_iterator_tag;
-                    using value_type        = const char*;
-                    using difference_type   = std::ptrdiff_t;
-                    using pointer           = value_type*;
-                    using reference         = value_type&;
-
-                    const_iterator(it_type it, it_type last) :
-                        m_it(it),
-                        m_last(last),
-                        m_pos(it == last ? nullptr : m_it->c_str()) {
-                    }
+                std::size_t mask() const noexcept {
+                    return m_slots.size() - 1;
+                }
 
-                    const_iterator& operator++() {
-                        assert(m_it != m_last);
-                        const auto* const last_pos = m_it->c_str() + m_it->size();
-                        while (m_pos != last_pos && *m_pos) {
-                            ++m_pos;
-                        }
-                        if (m_pos != last_pos) {
-                            ++m_pos;
-                        }
-                        if (m_pos == last_pos) {
-                            ++m_it;
-                            if (m_it != m_last) {
-                                m_pos = m_it->c_str();
-                            } else {
-                                m_pos = nullptr;
-                            }
-                        }
-                        return *this;
-                    }
+                const char* get(std::size_t index) const noexcept {
+                    return m_data.data() + m_offsets[index];
+                }
 
-                    const_iterator operator++(int) {
-                        const_iterator tmp{*this};
-                        operator++();
-                        return tmp;
+                void insert_slot(uint32_t hash, int32_t index) noexcept {
+                    std::size_t pos = hash & mask();
+                    while (m_slots[pos].generation == m_generation) {
+                        pos = (pos + 1) & mask();
                     }
+                    m_slots[pos] = slot{hash, index, m_generation};
+                }
 
-                    bool operator==(const const_iterator& rhs) const {
-                        return m_it == rhs.m_it && m_pos == rhs.m_pos;
+                // Rebuild the hash table with the given number of slots
+                // from the cached hashes of all entries.
+                void rehash(std::size_t num_slots) {
+                    if (num_slots != m_slots.size()) {
+                        m_slots.assign(num_slots, slot{});
+                        m_generation = 1;
+                    } else {
+                        next_generation();
                     }
-
-                    bool operator!=(const const_iterator& rhs) const {
-                        return !(*this == rhs);
+                    for (std::size_t i = 1; i < m_offsets.size(); ++i) {
+                        insert_slot(m_hashes[i], static_cast<int32_t>(i));
                     }
+                }
 
-                    const char* operator*() const {
-                        assert(m_it != m_last);
-                        assert(m_pos != nullptr);
-                        return m_pos;
-                    }
-
-                }; // class const_iterator
-
-                const_iterator begin() const {
-                    if (m_chunks.front().empty()) {
-                        return end();
+                void next_generation() noexcept {
+                    if (++m_generation == 0) {
+                        // After a wrap-around old slots could look like
+                        // new ones, so they have to be cleared.
+                        std::fill(m_slots.begin(), m_slots.end(), slot{});
+                        m_generation = 1;
                     }
-                    return {m_chunks.begin(), m_chunks.end()};
                 }
 
-                const_iterator end() const {
-                    return {m_chunks.end(), m_chunks.end()};
-                }
+            public:
 
-                // These functions get you some idea how much memory was
-                // used.
-                size_t get_chunk_size() const noexcept {
-                    return m_chunk_size;
-                }
+                // There is one string table per PBF primitive block. Most of
+                // them are really small, because most blocks are full of nodes
+                // with no tags. But string tables can get really large for
+                // ways with many tags or for large relations.
+                // The chosen size is enough so that 99% of all string tables
+                // in typical OSM files will only need a single memory
+                // allocation.
+                enum {
+                    default_stringtable_chunk_size = 100U * 1024U
+                };
 
-                size_t get_chunk_count() const noexcept {
-                    return m_chunks.size();
+                explicit StringTable(std::size_t size = default_stringtable_chunk_size) :
+                    m_slots(min_slots) {
+                    m_data.reserve(size);
+                    clear();
                 }
 
-                size_t get_used_bytes_in_last_chunk() const noexcept {
-                    return m_chunks.back().size();
+                /**
+                 * Remove all strings from the table. This takes constant
+                 * time, the memory is kept for reuse.
+                 */
+                void clear() {
+                    m_data.assign(1, '\0');
+                    m_offsets.assign(1, 0);
+                    m_hashes.assign(1, 0);
+                    m_counts.assign(1, 0);
+                    next_generation();
                 }
 
-            }; // class StringStore
-
-            struct str_equal {
+                /// The number of entries including the empty string at index 0.
+                int32_t size() const noexcept {
+                    return static_cast<int32_t>(m_offsets.size());
+                }
 
-                bool operator()(const char* lhs, const char* rhs) const noexcept {
-                    return lhs == rhs || std::strcmp(lhs, rhs) == 0;
+                /// The number of bytes used for the strings.
+                std::size_t data_size() const noexcept {
+                    return m_data.size();
                 }
 
-            }; // struct str_equal
+                int32_t add(const char* s) {
+                    std::size_t length = 0;
+                    const uint32_t hash = hash_string(s, length);
+
+                    std::size_t pos = hash & mask();
+                    while (m_slots[pos].generation == m_generation) {
+                        const auto& entry = m_slots[pos];
+                        if (entry.hash == hash && std::strcmp(get(static_cast<std::size_t>(entry.index)), s) == 0) {
+                            ++m_counts[static_cast<std::size_t>(entry.index)];
+                            return entry.index;
+                        }
+                        pos = (pos + 1) & mask();
+                    }
 
-            struct djb2_hash {
+                    const auto index = size();
+                    if (index > max_entries) {
+                        throw osmium::pbf_error{"string table has too many entries"};
+                    }
 
-                std::size_t operator()(const char* str) const noexcept {
-                    std::size_t hash = 5381;
-                    int c = 0;
+                    m_offsets.push_back(m_data.size());
+                    m_hashes.push_back(hash);
+                    m_counts.push_back(1);
+                    m_data.append(s, length + 1);
 
-                    while ((c = static_cast<signed char>(*str++))) { // NOLINT(bugprone-signed-char-misuse,cert-str34-c)
-                        hash = ((hash << 5U) + hash) + c; /* hash * 33 + c */
+                    // Keep the load factor at or below 50%.
+                    if (m_offsets.size() * 2 > m_slots.size()) {
+                        rehash(m_slots.size() * 2);
+                    } else {
+                        m_slots[pos] = slot{hash, index, m_generation};
                     }
 
-                    return hash;
+                    return index;
                 }
 
-            }; // struct djb2_hash
+                /**
+                 * Reorder the entries so that the most often added strings
+                 * get the smallest indexes. Entries added the same number
+                 * of times keep their order. Indexes returned by add()
+                 * before this call are invalid afterwards.
+                 */
+                void sort_by_frequency() {
+                    std::vector<std::size_t> order(m_offsets.size());
+                    std::iota(order.begin(), order.end(), 0);
+                    std::stable_sort(std::next(order.begin()), order.end(), [this](std::size_t a, std::size_t b) {
+                        return m_counts[a] > m_counts[b];
+                    });
+
+                    std::string data;
+                    data.reserve(m_data.capacity());
+                    std::vector<std::size_t> offsets;
+                    offsets.reserve(m_offsets.size());
+                    std::vector<uint32_t> hashes;
+                    hashes.reserve(m_hashes.size());
+                    std::vector<uint32_t> counts;
+                    counts.reserve(m_counts.size());
+
+                    for (const auto i : order) {
+                        offsets.push_back(data.size());
+                        data.append(get(i), (i + 1 < m_offsets.size() ? m_offsets[i + 1] : m_data.size()) - m_offsets[i]);
+                        hashes.push_back(m_hashes[i]);
+                        counts.push_back(m_counts[i]);
+                    }
 
-            class StringTable {
+                    using std::swap;
+                    swap(m_data, data);
+                    swap(m_offsets, offsets);
+                    swap(m_hashes, hashes);
+                    swap(m_counts, counts);
 
-                // This is the maximum number of entries in a string table.
-                // This should never be reached in practice but we better
-                // make sure it doesn't. If we had max_uncompressed_blob_size
-                // many entries, we are sure they would never fit into a PBF
-                // Blob.
-                enum {
-                    max_entries = static_cast<int32_t>(max_uncompressed_blob_size)
-                };
+                    rehash(m_slots.size());
+                }
 
-                StringStore m_strings;
-                std::unordered_map<const char*, int32_t, djb2_hash, str_equal> m_index;
-                int32_t m_size = 0;
+                class const_iterator {
 
-            public:
+                    const StringTable* m_table;
+                    std::size_t m_index;
 
-                // There is one string table per PBF primitive block. Most of
-                // them are really small, because most blocks are full of nodes
-                // with no tags. But string tables can get really large for
-                // ways with many tags or for large relations.
-                // The chosen size is enough so that 99% of all string tables
-                // in typical OSM files will only need a single memory
-                // allocation.
-                enum {
-                    default_stringtable_chunk_size = 100U * 1024U
-                };
+                public:
 
-                // Minimum bucket count for hash.
-                enum {
-                    min_bucket_count = 1
-                };
+                    using iterator_category = std::forward_iterator_tag;
+                    using value_type        = const char*;
+                    using difference_type   = std::ptrdiff_t;
+                    using pointer           = value_type*;
+                    using reference         = value_type&;
 
-                explicit StringTable(size_t size = default_stringtable_chunk_size, size_t bucket_count = min_bucket_count) :
-                    m_strings(size),
-                    m_index(bucket_count) {
-                    m_strings.add("");
-                }
+                    const_iterator(const StringTable* table, std::size_t index) noexcept :
+                        m_table(table),
+                        m_index(index) {
+                    }
 
-                int32_t size() const noexcept {
-                    return m_size + 1;
-                }
+                    const_iterator& operator++() noexcept {
+                        ++m_index;
+                        return *this;
+                    }
 
-                std::size_t get_bucket_count() const noexcept {
-                    return m_index.bucket_count();
-                }
+                    const_iterator operator++(int) noexcept {
+                        const_iterator tmp{*this};
+                        operator++();
+                        return tmp;
+                    }
 
-                int32_t add(const char* s) {
-                    const auto f = m_index.find(s);
-                    if (f != m_index.end()) {
-                        return f->second;
+                    bool operator==(const const_iterator& rhs) const noexcept {
+                        return m_table == rhs.m_table && m_index == rhs.m_index;
                     }
 
-                    const char* cs = m_strings.add(s);
-                    m_index[cs] = ++m_size;
+                    bool operator!=(const const_iterator& rhs) const noexcept {
+                        return !(*this == rhs);
+                    }
 
-                    if (m_size > max_entries) {
-                        throw osmium::pbf_error{"string table has too many entries"};
+                    const char* operator*() const noexcept {
+                        assert(m_index < m_table->m_offsets.size());
+                        return m_table->get(m_index);
                     }
 
-                    return m_size;
-                }
+                }; // class const_iterator
 
-                StringStore::const_iterator begin() const {
-                    return m_strings.begin();
+                const_iterator begin() const noexcept {
+                    return {this, 0};
                 }
 
-                StringStore::const_iterator end() const {
-                    return m_strings.end();
+                const_iterator end() const noexcept {
+                    return {this, m_offsets.size()};
                 }
 
             }; // class StringTable
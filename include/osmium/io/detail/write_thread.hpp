@@ -35,6 +35,7 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/io/compression.hpp>
 #include <osmium/io/detail/queue_util.hpp>
+#include <osmium/io/pipeline_stats.hpp>
 #include <osmium/thread/util.hpp>
 
 #include <exception>
@@ -56,21 +57,32 @@ namespace osmium {
              */
             class WriteThread {
 
-                queue_wrapper<std::string> m_queue;
+                queue_wrapper<std::string, future_string_queue_type> m_queue;
                 std::unique_ptr<osmium::io::Compressor> m_compressor;
                 std::promise<std::size_t> m_promise;
                 std::atomic_bool* m_notification;
+                pipeline_counters* m_counters;
+                pipeline_stage m_stage;
 
             public:
 
+                /**
+                 * The time spent in Compressor::write() is added to the
+                 * given stage of the counters (if they are not nullptr),
+                 * the time waiting for data to the wait stage.
+                 */
                 WriteThread(future_string_queue_type& input_queue,
                             std::unique_ptr<osmium::io::Compressor>&& compressor,
                             std::promise<std::size_t>&& promise,
-                            std::atomic_bool* notification) :
+                            std::atomic_bool* notification,
+                            pipeline_counters* counters = nullptr,
+                            pipeline_stage stage = pipeline_stage::write) :
                     m_queue(input_queue),
                     m_compressor(std::move(compressor)),
                     m_promise(std::move(promise)),
-                    m_notification(notification) {
+                    m_notification(notification),
+                    m_counters(counters),
+                    m_stage(stage) {
                 }
 
                 WriteThread(const WriteThread&) = delete;
@@ -86,11 +98,19 @@ namespace osmium {
 
                     try {
                         while (true) {
-                            const std::string data{m_queue.pop()};
+                            std::string data;
+                            {
+                                const stage_timer timer{m_counters, pipeline_stage::wait};
+                                data = m_queue.pop();
+                            }
                             if (at_end_of_data(data)) {
                                 break;
                             }
+                            const stage_timer timer{m_counters, m_stage};
                             m_compressor->write(data);
+                            if (m_counters) {
+                                m_counters->add_bytes(data.size());
+                            }
                         }
                         m_compressor->close();
                         m_promise.set_value(m_compressor->file_size());
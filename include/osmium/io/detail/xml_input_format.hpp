@@ -46,6 +46,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/osm/entity_bits.hpp>
 #include <osmium/osm/item_type.hpp>
 #include <osmium/osm/location.hpp>
+#include <osmium/osm/metadata_options.hpp>
 #include <osmium/osm/node.hpp>
 #include <osmium/osm/node_ref.hpp>
 #include <osmium/osm/object.hpp>
@@ -284,6 +285,23 @@ namespace osmium {
                     }
                 }
 
+                // Is this attribute wanted according to the metadata options?
+                static bool want_attribute(const osmium::metadata_options& metadata, const XML_Char* name) noexcept {
+                    if (!std::strcmp(name, "version")) {
+                        return metadata.version();
+                    }
+                    if (!std::strcmp(name, "timestamp")) {
+                        return metadata.timestamp();
+                    }
+                    if (!std::strcmp(name, "changeset")) {
+                        return metadata.changeset();
+                    }
+                    if (!std::strcmp(name, "uid")) {
+                        return metadata.uid();
+                    }
+                    return true;
+                }
+
                 const char* init_object(osmium::OSMObject& object, const XML_Char** attrs) {
                     assert(m_context_stack.size() > 1);
                     if (m_context_stack[m_context_stack.size() - 2] == context::delete_section) {
@@ -292,15 +310,18 @@ namespace osmium {
 
                     osmium::Location location;
                     const char* user = "";
+                    const auto metadata = read_metadata_options();
 
-                    check_attributes(attrs, [&location, &user, &object](const XML_Char* name, const XML_Char* value) {
+                    check_attributes(attrs, [&location, &user, &object, &metadata](const XML_Char* name, const XML_Char* value) {
                         if (!std::strcmp(name, "lon")) {
                             location.set_lon(value);
                         } else if (!std::strcmp(name, "lat")) {
                             location.set_lat(value);
                         } else if (!std::strcmp(name, "user")) {
-                            user = value;
-                        } else {
+                            if (metadata.user()) {
+                                user = value;
+                            }
+                        } else if (metadata.all() || want_attribute(metadata, name)) {
                             object.set_attribute(name, value);
                         }
                     });
@@ -335,6 +356,10 @@ namespace osmium {
                 }
 
                 void get_tag(osmium::builder::Builder& builder, const XML_Char** attrs) {
+                    if (!(read_which_fields() & osmium::io::read_fields::tags)) {
+                        return;
+                    }
+
                     const char* k = "";
                     const char* v = "";
 
@@ -530,7 +555,8 @@ namespace osmium {
                         case context::way:
                             if (!std::strcmp(element, "nd")) {
                                 m_context_stack.push_back(context::nd);
-                                if (read_types() & osmium::osm_entity_bits::way) {
+                                if ((read_types() & osmium::osm_entity_bits::way) &&
+                                    (read_which_fields() & osmium::io::read_fields::way_nodes)) {
                                     m_tl_builder.reset();
 
                                     if (!m_wnl_builder) {
@@ -564,7 +590,8 @@ namespace osmium {
                         case context::relation:
                             if (!std::strcmp(element, "member")) {
                                 m_context_stack.push_back(context::member);
-                                if (read_types() & osmium::osm_entity_bits::relation) {
+                                if ((read_types() & osmium::osm_entity_bits::relation) &&
+                                    (read_which_fields() & osmium::io::read_fields::members)) {
                                     m_tl_builder.reset();
 
                                     if (!m_rml_builder) {
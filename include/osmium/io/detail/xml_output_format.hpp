@@ -552,7 +552,8 @@ namespace osmium {
                 }
 
                 void write_buffer(osmium::memory::Buffer&& buffer) final {
-                    m_output_queue.push(m_pool.submit(XMLOutputBlock{std::move(buffer), m_options}));
+                    const auto size = buffer.committed();
+                    send_to_output_queue(submit(XMLOutputBlock{std::move(buffer), m_options}), size);
                 }
 
                 void write_end() final {
@@ -45,8 +45,14 @@ DEALINGS IN THE SOFTWARE.
 
 #include <zlib.h>
 
+#ifdef OSMIUM_WITH_LIBDEFLATE
+# include <libdeflate.h>
+#endif
+
 #include <cassert>
+#include <cstddef>
 #include <limits>
+#include <memory>
 #include <string>
 
 namespace osmium {
@@ -65,17 +71,78 @@ namespace osmium {
                 }
             }
 
+#ifdef OSMIUM_WITH_LIBDEFLATE
+            struct libdeflate_compressor_deleter {
+                void operator()(libdeflate_compressor* compressor) const noexcept {
+                    ::libdeflate_free_compressor(compressor);
+                }
+            };
+
+            struct libdeflate_decompressor_deleter {
+                void operator()(libdeflate_decompressor* decompressor) const noexcept {
+                    ::libdeflate_free_decompressor(decompressor);
+                }
+            };
+
+            /**
+             * Get the libdeflate compressor for this thread. A compressor
+             * is bound to a compression level, so a new one is allocated
+             * only if the level changes.
+             */
+            inline libdeflate_compressor* libdeflate_get_compressor(int compression_level) {
+                if (compression_level == Z_DEFAULT_COMPRESSION) {
+                    compression_level = 6; // same default as zlib
+                }
+
+                thread_local std::unique_ptr<libdeflate_compressor, libdeflate_compressor_deleter> compressor;
+                thread_local int level = -1;
+
+                if (!compressor || level != compression_level) {
+                    compressor.reset(::libdeflate_alloc_compressor(compression_level));
+                    if (!compressor) {
+                        throw io_error{"failed to compress data: can not allocate compressor"};
+                    }
+                    level = compression_level;
+                }
+
+                return compressor.get();
+            }
+#endif
+
             /**
              * Compress data using zlib.
              *
              * Note that this function can not compress data larger than
              * what fits in an unsigned long, on Windows this is usually 32bit.
              *
+             * If OSMIUM_WITH_LIBDEFLATE is defined, libdeflate is used
+             * instead of zlib. The output is in the same zlib format.
+             *
              * @param input Data to compress.
              * @param compression_level Compression level.
              * @returns Compressed data.
              */
             inline std::string zlib_compress(const std::string& input, int compression_level = Z_DEFAULT_COMPRESSION) {
+#ifdef OSMIUM_WITH_LIBDEFLATE
+                libdeflate_compressor* compressor = libdeflate_get_compressor(compression_level);
+
+                std::string output(::libdeflate_zlib_compress_bound(compressor, input.size()), '\0');
+
+                const std::size_t output_size = ::libdeflate_zlib_compress(
+                    compressor,
+                    input.data(),
+                    input.size(),
+                    &*output.begin(),
+                    output.size());
+
+                if (output_size == 0) {
+                    throw io_error{"failed to compress data: output buffer too small"};
+                }
+
+                output.resize(output_size);
+
+                return output;
+#else
                 assert(input.size() < std::numeric_limits<unsigned long>::max());
                 unsigned long output_size = ::compressBound(static_cast<unsigned long>(input.size())); // NOLINT(google-runtime-int)
 
@@ -95,6 +162,7 @@ namespace osmium {
                 output.resize(output_size);
 
                 return output;
+#endif
             }
 
             /**
@@ -103,6 +171,9 @@ namespace osmium {
              * Note that this function can not uncompress data larger than
              * what fits in an unsigned long, on Windows this is usually 32bit.
              *
+             * If OSMIUM_WITH_LIBDEFLATE is defined, libdeflate is used
+             * instead of zlib.
+             *
              * @param input Compressed input data.
              * @param raw_size Size of uncompressed data.
              * @param output Uncompressed result data.
@@ -111,6 +182,32 @@ namespace osmium {
             inline protozero::data_view zlib_uncompress_string(const char* input, unsigned long input_size, unsigned long raw_size, std::string& output) { // NOLINT(google-runtime-int)
                 output.resize(raw_size);
 
+#ifdef OSMIUM_WITH_LIBDEFLATE
+                thread_local std::unique_ptr<libdeflate_decompressor, libdeflate_decompressor_deleter> decompressor{::libdeflate_alloc_decompressor()};
+                if (!decompressor) {
+                    throw io_error{"failed to uncompress data: can not allocate decompressor"};
+                }
+
+                // The size of the uncompressed data is known, so we ask
+                // libdeflate to check that it matches exactly.
+                const auto result = ::libdeflate_zlib_decompress(
+                    decompressor.get(),
+                    input,
+                    input_size,
+                    &*output.begin(),
+                    raw_size,
+                    nullptr);
+
+                switch (result) {
+                    case LIBDEFLATE_SUCCESS:
+                        break;
+                    case LIBDEFLATE_SHORT_OUTPUT:
+                    case LIBDEFLATE_INSUFFICIENT_SPACE:
+                        throw io_error{"failed to uncompress data: data size does not match"};
+                    default:
+                        throw io_error{"failed to uncompress data: data error"};
+                }
+#else
                 const auto result = ::uncompress(
                     reinterpret_cast<unsigned char*>(&*output.begin()),
                     &raw_size,
@@ -120,6 +217,7 @@ namespace osmium {
                 if (result != Z_OK) {
                     throw io_error{std::string{"failed to uncompress data: "} + zError(result)};
                 }
+#endif
 
                 return protozero::data_view{output.data(), output.size()};
             }
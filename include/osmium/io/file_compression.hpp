@@ -42,7 +42,8 @@ namespace osmium {
         enum class file_compression {
             none  = 0,
             gzip  = 1,
-            bzip2 = 2
+            bzip2 = 2,
+            zstd  = 3
         };
 
         inline const char* as_string(file_compression compression) {
@@ -51,6 +52,8 @@ namespace osmium {
                     return "gzip";
                 case file_compression::bzip2:
                     return "bzip2";
+                case file_compression::zstd:
+                    return "zstd";
                 default: // file_compression::none:
                     break;
             }
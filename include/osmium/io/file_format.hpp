@@ -33,7 +33,9 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <cstddef>
 #include <iosfwd>
+#include <limits>
 
 namespace osmium {
 
@@ -62,6 +64,118 @@ namespace osmium {
             single = 1
         };
 
+        enum class read_mmap {
+            no  = 0,
+            yes = 1
+        };
+
+        /**
+         * Order in which the Reader returns buffers. With "file" the
+         * buffers are returned in the order of the data in the file. With
+         * "any" the PBF parser returns each buffer as soon as it has been
+         * decoded, so one slow blob doesn't hold up the buffers decoded
+         * after it. Use Buffer::sequence() to find out where in the file
+         * a buffer came from. Other formats always use file order.
+         */
+        enum class read_order {
+            file = 0,
+            any  = 1
+        };
+
+        /**
+         * Bit field describing which parts of OSM objects should be read.
+         * Parts not in the set are not added to the objects when reading
+         * PBF, O5M, and XML files. Ids, locations, and the visible flag
+         * are always read. Which metadata fields are read is set with
+         * osmium::io::read_meta and osmium::metadata_options.
+         *
+         * Usage:
+         *
+         * @code{.cpp}
+         * osmium::io::Reader reader{file, osmium::io::read_fields::way_nodes};
+         * @endcode
+         */
+        namespace read_fields {
+
+            enum type : unsigned char {
+                nothing   = 0x00,
+                tags      = 0x01, ///< tags of all objects
+                way_nodes = 0x02, ///< node references (and locations) of ways
+                members   = 0x04, ///< members of relations
+                all       = 0x07
+            }; // enum type
+
+            inline constexpr type operator|(const type lhs, const type rhs) noexcept {
+                return static_cast<type>(static_cast<unsigned char>(lhs) | static_cast<unsigned char>(rhs));
+            }
+
+            inline constexpr type operator&(const type lhs, const type rhs) noexcept {
+                return static_cast<type>(static_cast<unsigned char>(lhs) & static_cast<unsigned char>(rhs));
+            }
+
+            inline constexpr type operator~(const type value) noexcept {
+                return all & static_cast<type>(~static_cast<unsigned char>(value));
+            }
+
+            inline type& operator|=(type& lhs, const type rhs) noexcept {
+                lhs = lhs | rhs;
+                return lhs;
+            }
+
+            inline type& operator&=(type& lhs, const type rhs) noexcept {
+                lhs = lhs & rhs;
+                return lhs;
+            }
+
+        } // namespace read_fields
+
+        /**
+         * Range of blobs to read from a PBF file given as byte offsets into
+         * the file. Reading starts with the blob at offset begin and stops
+         * before the first blob starting at or after end. The offsets are
+         * usually taken from a PBFBlobIndex. The default range contains
+         * all blobs. Ignored for formats other than PBF.
+         */
+        struct blob_range {
+
+            std::size_t begin = 0;
+            std::size_t end = std::numeric_limits<std::size_t>::max();
+
+            constexpr blob_range() noexcept = default;
+
+            constexpr blob_range(std::size_t b, std::size_t e = std::numeric_limits<std::size_t>::max()) noexcept :
+                begin(b),
+                end(e) {
+            }
+
+            constexpr bool all() const noexcept {
+                return begin == 0 && end == std::numeric_limits<std::size_t>::max();
+            }
+
+        }; // struct blob_range
+
+        /**
+         * Maximum number of bytes of data in each of the queues between the
+         * threads of a Reader or Writer. If a queue holds more than this,
+         * the thread producing the data is blocked until the data is used
+         * up. The default (0) is no limit, in that case the limit can also
+         * be set with the environment variables OSMIUM_MAX_INPUT_QUEUE_MB,
+         * OSMIUM_MAX_OSMDATA_QUEUE_MB, and OSMIUM_MAX_OUTPUT_QUEUE_MB.
+         *
+         * The number of elements in the queues is limited independently of
+         * this setting. For data that is still being processed in the
+         * thread pool, the size is estimated from the size of its input.
+         */
+        struct max_queue_bytes {
+
+            std::size_t bytes = 0;
+
+            constexpr explicit max_queue_bytes(std::size_t value) noexcept :
+                bytes(value) {
+            }
+
+        }; // struct max_queue_bytes
+
         inline const char* as_string(const file_format format) noexcept {
             switch (format) {
                 case file_format::xml:
@@ -39,6 +39,12 @@ DEALINGS IN THE SOFTWARE.
  * Include this file if you want to read or write gzip-compressed OSM
  * files.
  *
+ * Files in the BGZF format (a series of independent gzip members, each
+ * with its size in the header, as written by `bgzip`) are decompressed
+ * in parallel using the thread pool. Set the file option
+ * `gzip_blocks=true` to write files in this format, the compression is
+ * then also done in parallel.
+ *
  * @attention If you include this file, you'll need to link with `libz`.
  */
 
@@ -50,11 +56,18 @@ DEALINGS IN THE SOFTWARE.
 
 #include <zlib.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cerrno>
 #include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <iterator>
 #include <limits>
 #include <string>
+#include <system_error>
+#include <utility>
 
 #ifndef _MSC_VER
 # include <unistd.h>
@@ -100,28 +113,316 @@ namespace osmium {
                 throw osmium::gzip_error{error, error_code};
             }
 
+            [[noreturn]] inline void throw_zstream_error(const z_stream& zstream, const char* msg, const int result) {
+                std::string message{"gzip error: "};
+                message += msg;
+                message += ": ";
+                if (zstream.msg) {
+                    message.append(zstream.msg);
+                }
+                throw osmium::gzip_error{message, result};
+            }
+
+            enum bgzf_sizes : std::size_t {
+                bgzf_header_size = 18,
+                bgzf_footer_size = 8,
+
+                // Maximum size of a compressed block including header
+                // and footer.
+                bgzf_max_block_size = 64UL * 1024UL,
+
+                // Maximum amount of uncompressed data we put into one
+                // block. This is what bgzip uses, it makes sure even
+                // incompressible data will fit into a block.
+                bgzf_max_data_size = 0xff00UL,
+
+                // Number of blocks compressed or decompressed in one
+                // task on the thread pool.
+                bgzf_blocks_per_task = 16
+            };
+
+            inline uint32_t get_uint32_le(const unsigned char* data) noexcept {
+                return static_cast<uint32_t>(data[0]) |
+                       (static_cast<uint32_t>(data[1]) << 8U) |
+                       (static_cast<uint32_t>(data[2]) << 16U) |
+                       (static_cast<uint32_t>(data[3]) << 24U);
+            }
+
+            inline void set_uint32_le(unsigned char* data, const uint32_t value) noexcept {
+                data[0] = static_cast<unsigned char>(value & 0xffU);
+                data[1] = static_cast<unsigned char>((value >> 8U) & 0xffU);
+                data[2] = static_cast<unsigned char>((value >> 16U) & 0xffU);
+                data[3] = static_cast<unsigned char>((value >> 24U) & 0xffU);
+            }
+
+            /**
+             * Check whether the data starts with the header of a BGZF
+             * block. Returns the size of the whole block including header
+             * and footer or 0 if this is not a BGZF block.
+             */
+            inline std::size_t bgzf_block_size(const char* data, const std::size_t size) noexcept {
+                if (size < bgzf_header_size) {
+                    return 0;
+                }
+                const auto* d = reinterpret_cast<const unsigned char*>(data);
+
+                // gzip magic, deflate method, only FEXTRA flag set,
+                // one extra subfield "BC" with two bytes block size
+                if (d[0] != 0x1fU || d[1] != 0x8bU || d[2] != 8U || d[3] != 4U ||
+                    d[10] != 6U || d[11] != 0U ||
+                    d[12] != 'B' || d[13] != 'C' || d[14] != 2U || d[15] != 0U) {
+                    return 0;
+                }
+
+                return (static_cast<std::size_t>(d[16]) | (static_cast<std::size_t>(d[17]) << 8U)) + 1;
+            }
+
+#ifndef _MSC_VER
+            /**
+             * Check whether the file starts with a BGZF block at the
+             * current position without changing that position. This only
+             * works for seekable files, for pipes it always returns false.
+             * If the result is true, the current position is returned in
+             * offset.
+             */
+            inline bool starts_with_bgzf_block(const int fd, std::size_t* offset) noexcept {
+                const auto pos = ::lseek(fd, 0, SEEK_CUR);
+                if (pos < 0) {
+                    return false;
+                }
+
+                char header[bgzf_header_size];
+                if (::pread(fd, header, sizeof(header), pos) != static_cast<ssize_t>(sizeof(header))) {
+                    return false;
+                }
+
+                *offset = static_cast<std::size_t>(pos);
+                return bgzf_block_size(header, sizeof(header)) != 0;
+            }
+#endif
+
+            /**
+             * Task for the thread pool compressing data into a series of
+             * BGZF blocks.
+             */
+            class BGZFCompressTask {
+
+                std::string m_input;
+
+            public:
+
+                explicit BGZFCompressTask(std::string&& input) :
+                    m_input(std::move(input)) {
+                }
+
+                std::string operator()() const {
+                    z_stream zstream{};
+                    const int result = deflateInit2(&zstream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+                    if (result != Z_OK) {
+                        throw_zstream_error(zstream, "compression init failed", result);
+                    }
+
+                    std::string output;
+                    try {
+                        for (std::size_t pos = 0; pos < m_input.size(); pos += bgzf_max_data_size) {
+                            const std::size_t size = std::min(m_input.size() - pos, static_cast<std::size_t>(bgzf_max_data_size));
+                            compress_block(zstream, m_input.data() + pos, size, output);
+                        }
+                    } catch (...) {
+                        deflateEnd(&zstream);
+                        throw;
+                    }
+                    deflateEnd(&zstream);
+
+                    return output;
+                }
+
+            private:
+
+                static void compress_block(z_stream& zstream, const char* data, const std::size_t size, std::string& output) {
+                    static const unsigned char header[bgzf_header_size - 2] = {
+                        0x1fU, 0x8bU, 8U, 4U, 0U, 0U, 0U, 0U, 0U, 0xffU, 6U, 0U, 'B', 'C', 2U, 0U
+                    };
+
+                    const int reset = deflateReset(&zstream);
+                    if (reset != Z_OK) {
+                        throw_zstream_error(zstream, "compression reset failed", reset);
+                    }
+
+                    const std::size_t start = output.size();
+                    const std::size_t bound = deflateBound(&zstream, static_cast<uLong>(size));
+                    output.resize(start + bgzf_header_size + bound + bgzf_footer_size);
+                    auto* block = reinterpret_cast<unsigned char*>(&output[start]);
+
+                    zstream.next_in = reinterpret_cast<unsigned char*>(const_cast<char*>(data));
+                    zstream.avail_in = static_cast<unsigned int>(size);
+                    zstream.next_out = block + bgzf_header_size;
+                    zstream.avail_out = static_cast<unsigned int>(bound);
+
+                    const int result = deflate(&zstream, Z_FINISH);
+                    if (result != Z_STREAM_END) {
+                        throw_zstream_error(zstream, "compression failed", result);
+                    }
+
+                    const std::size_t block_size = bgzf_header_size + (bound - zstream.avail_out) + bgzf_footer_size;
+                    if (block_size > bgzf_max_block_size) {
+                        throw osmium::gzip_error{"gzip error: compressed block too large"};
+                    }
+
+                    std::copy(std::begin(header), std::end(header), block);
+                    block[16] = static_cast<unsigned char>((block_size - 1) & 0xffU);
+                    block[17] = static_cast<unsigned char>((block_size - 1) >> 8U);
+
+                    auto* footer = block + block_size - bgzf_footer_size;
+                    set_uint32_le(footer, static_cast<uint32_t>(crc32(0, reinterpret_cast<const unsigned char*>(data), static_cast<unsigned int>(size))));
+                    set_uint32_le(footer + 4, static_cast<uint32_t>(size));
+
+                    output.resize(start + block_size);
+                }
+
+            }; // class BGZFCompressTask
+
+            /**
+             * Task for the thread pool decompressing a series of complete
+             * BGZF blocks.
+             */
+            class BGZFDecompressTask {
+
+                std::string m_input;
+
+            public:
+
+                explicit BGZFDecompressTask(std::string&& input) :
+                    m_input(std::move(input)) {
+                }
+
+                std::string operator()() const {
+                    std::size_t output_size = 0;
+                    for (std::size_t pos = 0; pos < m_input.size(); pos += bgzf_block_size(&m_input[pos], m_input.size() - pos)) {
+                        const std::size_t block_end = pos + bgzf_block_size(&m_input[pos], m_input.size() - pos);
+                        const std::size_t data_size = get_uint32_le(reinterpret_cast<const unsigned char*>(&m_input[block_end - 4]));
+                        // BGZF blocks never contain more than 64k of data.
+                        // Don't let corrupt data make us allocate more.
+                        if (data_size > bgzf_max_block_size) {
+                            throw osmium::gzip_error{"gzip error: BGZF block has wrong size or checksum", Z_DATA_ERROR};
+                        }
+                        output_size += data_size;
+                    }
+
+                    z_stream zstream{};
+                    const int result = inflateInit2(&zstream, -MAX_WBITS);
+                    if (result != Z_OK) {
+                        throw_zstream_error(zstream, "decompression init failed", result);
+                    }
+
+                    std::string output(output_size, '\0');
+                    try {
+                        std::size_t out_pos = 0;
+                        for (std::size_t pos = 0; pos < m_input.size();) {
+                            const std::size_t block_size = bgzf_block_size(&m_input[pos], m_input.size() - pos);
+                            out_pos += decompress_block(zstream, &m_input[pos], block_size, &output[0] + out_pos);
+                            pos += block_size;
+                        }
+                    } catch (...) {
+                        inflateEnd(&zstream);
+                        throw;
+                    }
+                    inflateEnd(&zstream);
+
+                    return output;
+                }
+
+            private:
+
+                static std::size_t decompress_block(z_stream& zstream, const char* block, const std::size_t block_size, char* output) {
+                    const auto* footer = reinterpret_cast<const unsigned char*>(block + block_size - bgzf_footer_size);
+                    const uint32_t crc = get_uint32_le(footer);
+                    const uint32_t size = get_uint32_le(footer + 4);
+
+                    const int reset = inflateReset(&zstream);
+                    if (reset != Z_OK) {
+                        throw_zstream_error(zstream, "decompression reset failed", reset);
+                    }
+
+                    // The dummy byte of output space lets inflate() report
+                    // the end of the stream even for empty blocks.
+                    unsigned char dummy = 0;
+                    zstream.next_in = reinterpret_cast<unsigned char*>(const_cast<char*>(block + bgzf_header_size));
+                    zstream.avail_in = static_cast<unsigned int>(block_size - bgzf_header_size - bgzf_footer_size);
+                    zstream.next_out = size > 0 ? reinterpret_cast<unsigned char*>(output) : &dummy;
+                    zstream.avail_out = size > 0 ? size : 1;
+
+                    const int result = inflate(&zstream, Z_FINISH);
+                    if (result != Z_STREAM_END) {
+                        throw_zstream_error(zstream, "inflate failed", result == Z_BUF_ERROR ? Z_DATA_ERROR : result);
+                    }
+
+                    if (size > 0 && (zstream.avail_out != 0 || crc32(0, reinterpret_cast<const unsigned char*>(output), size) != crc)) {
+                        throw osmium::gzip_error{"gzip error: BGZF block has wrong size or checksum", Z_DATA_ERROR};
+                    }
+
+                    return size;
+                }
+
+            }; // class BGZFDecompressTask
+
         } // namespace detail
 
         class GzipCompressor final : public Compressor {
 
             std::size_t m_file_size = 0;
             int m_fd;
-            gzFile m_gzfile;
 
-        public:
+            // Duplicate of m_fd handed over to zlib when the gzFile is
+            // opened.
+            int m_gz_fd;
+            gzFile m_gzfile = nullptr;
 
-            explicit GzipCompressor(const int fd, const fsync sync) :
-                Compressor(sync),
-                m_fd(fd) {
+            bool m_closed = false;
+
+            // Write independent BGZF blocks compressed in parallel?
+            bool m_blocks = false;
+            std::string m_pending;
+            std::deque<std::future<std::string>> m_compressed;
+
+            gzFile gzfile() {
+                if (!m_gzfile) {
 #ifdef _MSC_VER
-                osmium::detail::disable_invalid_parameter_handler diph;
+                    osmium::detail::disable_invalid_parameter_handler diph;
 #endif
-                m_gzfile = ::gzdopen(osmium::io::detail::reliable_dup(fd), "wb"); // NOLINT(cppcoreguidelines-prefer-member-initializer)
-                if (!m_gzfile) {
-                    throw gzip_error{"gzip error: write initialization failed"};
+                    m_gzfile = ::gzdopen(m_gz_fd, "wb");
+                    if (!m_gzfile) {
+                        osmium::io::detail::reliable_close(m_gz_fd);
+                        m_gz_fd = -1;
+                        throw gzip_error{"gzip error: write initialization failed"};
+                    }
+                    m_gz_fd = -1;
+                }
+                return m_gzfile;
+            }
+
+            void submit_blocks(std::string&& data) {
+                m_compressed.push_back(pool().submit(detail::BGZFCompressTask{std::move(data)}));
+            }
+
+            // Write out compressed data until there are at most
+            // max_in_flight compression tasks left.
+            void write_blocks(const std::size_t max_in_flight) {
+                while (m_compressed.size() > max_in_flight) {
+                    const std::string data{m_compressed.front().get()};
+                    m_compressed.pop_front();
+                    osmium::io::detail::reliable_write(m_fd, data.data(), data.size());
                 }
             }
 
+        public:
+
+            explicit GzipCompressor(const int fd, const fsync sync) :
+                Compressor(sync),
+                m_fd(fd),
+                m_gz_fd(osmium::io::detail::reliable_dup(fd)) {
+            }
+
             GzipCompressor(const GzipCompressor&) = delete;
             GzipCompressor& operator=(const GzipCompressor&) = delete;
 
@@ -136,14 +437,39 @@ namespace osmium {
                 }
             }
 
+            /**
+             * If the option "gzip_blocks" is set to true, write the file
+             * as a series of independent BGZF blocks which are compressed
+             * in parallel on the thread pool. The result is a valid gzip
+             * file that can also be decompressed in parallel.
+             */
+            void set_options(const osmium::Options& options) override {
+                if (options.is_true("gzip_blocks") && !m_gzfile && !m_closed && !m_blocks) {
+                    m_blocks = true;
+                    osmium::io::detail::reliable_close(m_gz_fd);
+                    m_gz_fd = -1;
+                }
+            }
+
             void write(const std::string& data) override {
+                if (m_blocks) {
+                    constexpr const std::size_t task_size = detail::bgzf_blocks_per_task * detail::bgzf_max_data_size;
+                    m_pending.append(data);
+                    std::size_t pos = 0;
+                    for (; m_pending.size() - pos >= task_size; pos += task_size) {
+                        submit_blocks(m_pending.substr(pos, task_size));
+                    }
+                    m_pending.erase(0, pos);
+                    write_blocks(2 * static_cast<std::size_t>(pool().num_threads()));
+                    return;
+                }
+
 #ifdef _MSC_VER
                 osmium::detail::disable_invalid_parameter_handler diph;
 #endif
-                assert(m_gzfile);
                 assert(data.size() < std::numeric_limits<unsigned int>::max());
                 if (!data.empty()) {
-                    const int nwrite = ::gzwrite(m_gzfile, data.data(), static_cast<unsigned int>(data.size()));
+                    const int nwrite = ::gzwrite(gzfile(), data.data(), static_cast<unsigned int>(data.size()));
                     if (nwrite == 0) {
                         detail::throw_gzip_error(m_gzfile, "write failed");
                     }
@@ -151,28 +477,48 @@ namespace osmium {
             }
 
             void close() override {
-                if (m_gzfile) {
+                if (m_closed) {
+                    return;
+                }
+                m_closed = true;
+
+                // Do not sync or close stdout
+                osmium::io::detail::fd_close_guard guard{m_fd == 1 ? -1 : m_fd};
+
+                if (m_blocks) {
+                    if (!m_pending.empty()) {
+                        submit_blocks(std::move(m_pending));
+                    }
+                    write_blocks(0);
+
+                    // BGZF end-of-file marker: a block with no data
+                    static const unsigned char eof_block[] = {
+                        0x1fU, 0x8bU, 8U, 4U, 0U, 0U, 0U, 0U, 0U, 0xffU, 6U, 0U, 'B', 'C', 2U, 0U,
+                        0x1bU, 0U, 3U, 0U, 0U, 0U, 0U, 0U, 0U, 0U, 0U, 0U
+                    };
+                    osmium::io::detail::reliable_write(m_fd, eof_block, sizeof(eof_block));
+                } else {
+                    gzFile file = gzfile();
 #ifdef _MSC_VER
                     osmium::detail::disable_invalid_parameter_handler diph;
 #endif
-                    const int result = ::gzclose_w(m_gzfile);
+                    const int result = ::gzclose_w(file);
                     m_gzfile = nullptr;
                     if (result != Z_OK) {
                         throw gzip_error{"gzip error: write close failed", result};
                     }
+                }
 
-                    // Do not sync or close stdout
-                    if (m_fd == 1) {
-                        return;
-                    }
+                if (m_fd == 1) {
+                    return;
+                }
 
-                    m_file_size = osmium::file_size(m_fd);
+                m_file_size = osmium::file_size(m_fd);
 
-                    if (do_fsync()) {
-                        osmium::io::detail::reliable_fsync(m_fd);
-                    }
-                    osmium::io::detail::reliable_close(m_fd);
+                if (do_fsync()) {
+                    osmium::io::detail::reliable_fsync(m_fd);
                 }
+                osmium::io::detail::reliable_close(guard.release());
             }
 
             std::size_t file_size() const override {
@@ -186,22 +532,161 @@ namespace osmium {
             gzFile m_gzfile = nullptr;
             int m_fd;
 
-        public:
+            // Set if the file is in BGZF format. In that case blocks of
+            // the file are decompressed in parallel on the thread pool.
+            bool m_blocks = false;
 
-            explicit GzipDecompressor(const int fd) : m_fd(fd) {
+            // Set when data was found that is not a BGZF block. The rest
+            // of the file from m_file_offset is then read with zlib.
+            bool m_not_bgzf = false;
+
+            bool m_input_eof = false;
+
+            // Offset in the file of the first byte in m_input.
+            std::size_t m_file_offset = 0;
+
+            // Data read from the file but not yet submitted to the pool.
+            std::string m_input;
+
+            struct decompressed_blocks {
+                std::future<std::string> data;
+                std::size_t end_offset;
+            };
+
+            std::deque<decompressed_blocks> m_decompressed;
+
+            void open_gzfile() {
 #ifdef _MSC_VER
                 osmium::detail::disable_invalid_parameter_handler diph;
 #endif
-                m_gzfile = ::gzdopen(fd, "rb"); // NOLINT(cppcoreguidelines-prefer-member-initializer)
+                m_gzfile = ::gzdopen(m_fd, "rb");
                 if (!m_gzfile) {
                     try {
-                        osmium::io::detail::reliable_close(fd);
+                        osmium::io::detail::reliable_close(m_fd);
                     } catch (...) {
                     }
+                    m_fd = -1;
                     throw gzip_error{"gzip error: read initialization failed"};
                 }
             }
 
+            bool fill_input() {
+                if (m_input_eof) {
+                    return false;
+                }
+                std::string buffer(osmium::io::Decompressor::input_buffer_size, '\0');
+                const auto nread = osmium::io::detail::reliable_read(m_fd, &*buffer.begin(), static_cast<unsigned int>(buffer.size()));
+                if (nread == 0) {
+                    m_input_eof = true;
+                    return false;
+                }
+                m_input.append(buffer.data(), static_cast<std::size_t>(nread));
+                return true;
+            }
+
+            // Collect complete BGZF blocks from the input and submit them
+            // to the pool for decompression. Returns false if there are
+            // no more blocks.
+            bool submit_blocks() {
+                std::size_t pos = 0;
+                for (std::size_t count = 0; count < detail::bgzf_blocks_per_task;) {
+                    if (m_input.size() - pos < detail::bgzf_header_size) {
+                        if (fill_input()) {
+                            continue;
+                        }
+                        m_not_bgzf = m_input.size() > pos;
+                        break;
+                    }
+                    const std::size_t block_size = detail::bgzf_block_size(&m_input[pos], m_input.size() - pos);
+                    if (block_size == 0) {
+                        m_not_bgzf = true;
+                        break;
+                    }
+                    if (block_size < detail::bgzf_header_size + detail::bgzf_footer_size) {
+                        throw gzip_error{"gzip error: invalid BGZF block", Z_DATA_ERROR};
+                    }
+                    while (m_input.size() - pos < block_size) {
+                        if (!fill_input()) {
+                            throw gzip_error{"gzip error: unexpected end of file", Z_BUF_ERROR};
+                        }
+                    }
+                    pos += block_size;
+                    ++count;
+                }
+
+                if (pos == 0) {
+                    return false;
+                }
+
+                m_file_offset += pos;
+                m_decompressed.push_back({pool().submit(detail::BGZFDecompressTask{m_input.substr(0, pos)}), m_file_offset});
+                m_input.erase(0, pos);
+
+                return true;
+            }
+
+            std::string read_blocks() {
+                const auto max_in_flight = 2 * static_cast<std::size_t>(pool().num_threads());
+
+                while (true) {
+                    while (!m_not_bgzf && m_decompressed.size() < max_in_flight) {
+                        if (!submit_blocks()) {
+                            break;
+                        }
+                    }
+
+                    if (m_decompressed.empty()) {
+                        break;
+                    }
+
+                    auto blocks = std::move(m_decompressed.front());
+                    m_decompressed.pop_front();
+                    std::string output{blocks.data.get()};
+
+                    if (want_buffered_pages_removed()) {
+                        osmium::io::detail::remove_buffered_pages(m_fd, blocks.end_offset);
+                    }
+                    set_offset(blocks.end_offset);
+
+                    // BGZF files end with an empty block, don't return
+                    // that, because an empty string signals end of file.
+                    if (!output.empty()) {
+                        return output;
+                    }
+                }
+
+                m_blocks = false;
+                m_input.clear();
+
+                if (m_not_bgzf) {
+                    // Let zlib handle the rest of the file from the first
+                    // gzip member that is not a BGZF block.
+#ifndef _MSC_VER
+                    if (::lseek(m_fd, static_cast<off_t>(m_file_offset), SEEK_SET) < 0) {
+                        throw std::system_error{errno, std::system_category(), "Seek failed"};
+                    }
+#endif
+                    open_gzfile();
+                    return read();
+                }
+
+                // Closing the file descriptor is left to close(), there
+                // is no gzFile to do it.
+                return std::string{};
+            }
+
+        public:
+
+            explicit GzipDecompressor(const int fd) : m_fd(fd) {
+#ifndef _MSC_VER
+                if (detail::starts_with_bgzf_block(fd, &m_file_offset)) {
+                    m_blocks = true;
+                    return;
+                }
+#endif
+                open_gzfile();
+            }
+
             GzipDecompressor(const GzipDecompressor&) = delete;
             GzipDecompressor& operator=(const GzipDecompressor&) = delete;
 
@@ -217,7 +702,12 @@ namespace osmium {
             }
 
             std::string read() override {
-                assert(m_gzfile);
+                if (m_blocks) {
+                    return read_blocks();
+                }
+                if (!m_gzfile) {
+                    return std::string{};
+                }
 #ifdef _MSC_VER
                 osmium::detail::disable_invalid_parameter_handler diph;
 #else
@@ -251,9 +741,21 @@ namespace osmium {
 #endif
                     const int result = ::gzclose_r(m_gzfile);
                     m_gzfile = nullptr;
+                    m_fd = -1;
                     if (result != Z_OK) {
                         throw gzip_error{"gzip error: read close failed", result};
                     }
+                } else if (m_fd >= 0) {
+                    // Tasks still running on the pool own their data, so
+                    // the futures can be dropped here.
+                    m_decompressed.clear();
+                    m_blocks = false;
+                    if (want_buffered_pages_removed()) {
+                        osmium::io::detail::remove_buffered_pages(m_fd);
+                    }
+                    const int fd = m_fd;
+                    m_fd = -1;
+                    osmium::io::detail::reliable_close(fd);
                 }
             }
 
@@ -301,12 +803,22 @@ namespace osmium {
             std::string read() override {
                 std::string output;
 
-                if (m_buffer) {
+                // Loop until there is some output, because an empty
+                // string signals the end of the data. Gzip members can
+                // be empty.
+                while (m_buffer && output.empty()) {
                     const std::size_t buffer_size = 10240;
                     output.append(buffer_size, '\0');
                     m_zstream.next_out = reinterpret_cast<unsigned char*>(&*output.begin());
                     m_zstream.avail_out = buffer_size;
-                    const int result = inflate(&m_zstream, Z_SYNC_FLUSH);
+                    int result = inflate(&m_zstream, Z_SYNC_FLUSH);
+
+                    // Another gzip member follows, for instance in BGZF
+                    // files.
+                    if (result == Z_STREAM_END && m_zstream.avail_in >= 2 &&
+                        m_zstream.next_in[0] == 0x1fU && m_zstream.next_in[1] == 0x8bU) {
+                        result = inflateReset(&m_zstream);
+                    }
 
                     if (result != Z_OK) {
                         m_buffer = nullptr;
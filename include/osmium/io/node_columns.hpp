@@ -0,0 +1,124 @@
+#ifndef OSMIUM_IO_NODE_COLUMNS_HPP
+#define OSMIUM_IO_NODE_COLUMNS_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2023 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        /**
+         * Ids and locations of nodes stored in separate arrays ("columns")
+         * instead of as osmium::Node objects in a buffer. This is what the
+         * PBFNodeColumnsReader returns for each blob. It is much cheaper
+         * to create than full nodes and enough for programs that only need
+         * node locations, for instance to fill a location index.
+         *
+         * Nodes that are not visible (deleted nodes in history files) have
+         * an undefined location.
+         */
+        class NodeColumns {
+
+            std::vector<osmium::object_id_type> m_ids;
+            std::vector<int32_t> m_x;
+            std::vector<int32_t> m_y;
+
+        public:
+
+            /// The number of nodes.
+            std::size_t size() const noexcept {
+                return m_ids.size();
+            }
+
+            bool empty() const noexcept {
+                return m_ids.empty();
+            }
+
+            void clear() noexcept {
+                m_ids.clear();
+                m_x.clear();
+                m_y.clear();
+            }
+
+            void reserve(std::size_t size) {
+                m_ids.reserve(size);
+                m_x.reserve(size);
+                m_y.reserve(size);
+            }
+
+            /// Add a node with the given id and location at the end.
+            void add(osmium::object_id_type id, const osmium::Location& location) {
+                m_ids.push_back(id);
+                m_x.push_back(location.x());
+                m_y.push_back(location.y());
+            }
+
+            /// The id of node number n. No bounds checking.
+            osmium::object_id_type id(std::size_t n) const noexcept {
+                return m_ids[n];
+            }
+
+            /// The location of node number n. No bounds checking.
+            osmium::Location location(std::size_t n) const noexcept {
+                return osmium::Location{m_x[n], m_y[n]};
+            }
+
+            /// The ids of all nodes.
+            const std::vector<osmium::object_id_type>& ids() const noexcept {
+                return m_ids;
+            }
+
+            /// The x coordinates (longitudes) of all nodes.
+            const std::vector<int32_t>& x() const noexcept {
+                return m_x;
+            }
+
+            /// The y coordinates (latitudes) of all nodes.
+            const std::vector<int32_t>& y() const noexcept {
+                return m_y;
+            }
+
+        }; // class NodeColumns
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_NODE_COLUMNS_HPP
@@ -0,0 +1,584 @@
+#ifndef OSMIUM_IO_PBF_BLOB_INDEX_HPP
+#define OSMIUM_IO_PBF_BLOB_INDEX_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2023 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/detail/pbf.hpp> // IWYU pragma: export
+#include <osmium/io/detail/pbf_decoder.hpp>
+#include <osmium/io/detail/protobuf_tags.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/error.hpp>
+#include <osmium/io/file_format.hpp>
+#include <osmium/io/writer_options.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/util/delta.hpp>
+#include <osmium/util/file.hpp>
+
+#include <protozero/exception.hpp>
+#include <protozero/pbf_builder.hpp>
+#include <protozero/pbf_message.hpp>
+#include <protozero/types.hpp>
+
+#ifdef _MSC_VER
+# include <io.h>
+#else
+# include <sys/types.h>
+# include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        /**
+         * Information about one OSMData blob in a PBF file.
+         */
+        struct pbf_blob_info {
+
+            /// Offset of the blob in the file (start of the BlobHeader size).
+            std::size_t offset = 0;
+
+            /// Number of bytes the blob takes up in the file (including the
+            /// BlobHeader and its size).
+            std::size_t size = 0;
+
+            /// Types of the OSM entities in this blob.
+            osmium::osm_entity_bits::type types = osmium::osm_entity_bits::nothing;
+
+            /// Smallest and largest id of all objects in this blob.
+            osmium::object_id_type min_id = std::numeric_limits<osmium::object_id_type>::max();
+            osmium::object_id_type max_id = std::numeric_limits<osmium::object_id_type>::min();
+
+            /// Bounding box of all objects in this blob (invalid if unknown).
+            osmium::Box bbox{};
+
+            pbf_blob_info() = default;
+
+            pbf_blob_info(std::size_t blob_offset, std::size_t blob_size) noexcept :
+                offset(blob_offset),
+                size(blob_size) {
+            }
+
+            /// Offset of the first byte after this blob.
+            std::size_t end() const noexcept {
+                return offset + size;
+            }
+
+            /// Does this blob contain any objects of the given types?
+            bool contains(osmium::osm_entity_bits::type entities) const noexcept {
+                return (types & entities) != osmium::osm_entity_bits::nothing;
+            }
+
+            /// Record an object with given type and id as being in this blob.
+            void add(osmium::osm_entity_bits::type type, osmium::object_id_type id) noexcept {
+                types |= type;
+                min_id = std::min(min_id, id);
+                max_id = std::max(max_id, id);
+            }
+
+        }; // struct pbf_blob_info
+
+        namespace detail {
+
+            // Protobuf format of the index sidecar file
+            namespace BlobIndexFormat {
+
+                enum class Index : protozero::pbf_tag_type {
+                    required_string_format   = 1,
+                    optional_uint64_filesize = 2,
+                    repeated_Blob_blobs      = 3
+                };
+
+                enum class Blob : protozero::pbf_tag_type {
+                    required_uint64_offset = 1,
+                    required_uint64_size   = 2,
+                    optional_uint32_types  = 3,
+                    optional_sint64_min_id = 4,
+                    optional_sint64_max_id = 5,
+                    optional_sint32_min_x  = 6,
+                    optional_sint32_min_y  = 7,
+                    optional_sint32_max_x  = 8,
+                    optional_sint32_max_y  = 9
+                };
+
+            } // namespace BlobIndexFormat
+
+            constexpr const char* blob_index_format_name = "OSMBlobIndex-1";
+
+        } // namespace detail
+
+        /**
+         * An index of the OSMData blobs in a PBF file. For each blob it
+         * records the offset and size in the file, the types of the
+         * entities in the blob and their smallest and largest id.
+         *
+         * The index can be created with create_pbf_blob_index() and saved
+         * into a sidecar file next to the PBF file. The byte ranges from
+         * the index can be given to the Reader (as osmium::io::blob_range)
+         * to read only parts of the file, for instance with several
+         * readers in parallel.
+         */
+        class PBFBlobIndex {
+
+            std::vector<pbf_blob_info> m_blobs{};
+            std::size_t m_file_size = 0;
+
+        public:
+
+            using const_iterator = std::vector<pbf_blob_info>::const_iterator;
+
+            PBFBlobIndex() = default;
+
+            /**
+             * Create an empty index for a file with the given size.
+             */
+            explicit PBFBlobIndex(std::size_t file_size) noexcept :
+                m_file_size(file_size) {
+            }
+
+            /// The size of the PBF file this index was created for.
+            std::size_t file_size() const noexcept {
+                return m_file_size;
+            }
+
+            bool empty() const noexcept {
+                return m_blobs.empty();
+            }
+
+            std::size_t size() const noexcept {
+                return m_blobs.size();
+            }
+
+            const_iterator begin() const noexcept {
+                return m_blobs.cbegin();
+            }
+
+            const_iterator end() const noexcept {
+                return m_blobs.cend();
+            }
+
+            const pbf_blob_info& operator[](std::size_t n) const noexcept {
+                return m_blobs[n];
+            }
+
+            /**
+             * Add information about a blob. Blobs must be added in the
+             * order they appear in the file.
+             */
+            void add(const pbf_blob_info& info) {
+                m_blobs.push_back(info);
+            }
+
+            /**
+             * Return the byte range containing the blobs first (inclusive)
+             * to last (exclusive).
+             */
+            osmium::io::blob_range range(std::size_t first, std::size_t last) const noexcept {
+                if (first >= last || first >= m_blobs.size()) {
+                    return osmium::io::blob_range{m_file_size, m_file_size};
+                }
+                last = std::min(last, m_blobs.size());
+                return osmium::io::blob_range{m_blobs[first].offset, m_blobs[last - 1].end()};
+            }
+
+            /**
+             * Return the smallest byte range containing all blobs with
+             * any objects of the specified types in them.
+             */
+            osmium::io::blob_range range(osmium::osm_entity_bits::type entities) const noexcept {
+                const auto first = std::find_if(m_blobs.cbegin(), m_blobs.cend(), [entities](const pbf_blob_info& info) {
+                    return info.contains(entities);
+                });
+                if (first == m_blobs.cend()) {
+                    return range(0, 0);
+                }
+                const auto last = std::find_if(m_blobs.crbegin(), m_blobs.crend(), [entities](const pbf_blob_info& info) {
+                    return info.contains(entities);
+                });
+                return osmium::io::blob_range{first->offset, last->end()};
+            }
+
+            /**
+             * Split the file into (at most) num_parts disjoint ranges of
+             * blobs with roughly the same number of bytes each. Each range
+             * can be read by a different Reader.
+             */
+            std::vector<osmium::io::blob_range> split(std::size_t num_parts) const {
+                std::vector<osmium::io::blob_range> ranges;
+                if (m_blobs.empty() || num_parts == 0) {
+                    return ranges;
+                }
+
+                const std::size_t total = m_blobs.back().end() - m_blobs.front().offset;
+                const std::size_t per_part = (total + num_parts - 1) / num_parts;
+
+                std::size_t first = 0;
+                std::size_t bytes = 0;
+                for (std::size_t n = 0; n < m_blobs.size(); ++n) {
+                    bytes += m_blobs[n].size;
+                    if (bytes >= per_part) {
+                        ranges.push_back(range(first, n + 1));
+                        first = n + 1;
+                        bytes = 0;
+                    }
+                }
+                if (first < m_blobs.size()) {
+                    ranges.push_back(range(first, m_blobs.size()));
+                }
+
+                return ranges;
+            }
+
+            /**
+             * Save the index into a file.
+             *
+             * @throws std::system_error If the file could not be written.
+             */
+            void save(const std::string& filename) const {
+                std::string data;
+                protozero::pbf_builder<detail::BlobIndexFormat::Index> pbf_index{data};
+                pbf_index.add_string(detail::BlobIndexFormat::Index::required_string_format, detail::blob_index_format_name);
+                pbf_index.add_uint64(detail::BlobIndexFormat::Index::optional_uint64_filesize, m_file_size);
+
+                for (const auto& info : m_blobs) {
+                    protozero::pbf_builder<detail::BlobIndexFormat::Blob> pbf_blob{pbf_index, detail::BlobIndexFormat::Index::repeated_Blob_blobs};
+                    pbf_blob.add_uint64(detail::BlobIndexFormat::Blob::required_uint64_offset, info.offset);
+                    pbf_blob.add_uint64(detail::BlobIndexFormat::Blob::required_uint64_size, info.size);
+                    if (info.types != osmium::osm_entity_bits::nothing) {
+                        pbf_blob.add_uint32(detail::BlobIndexFormat::Blob::optional_uint32_types, static_cast<uint32_t>(info.types));
+                        pbf_blob.add_sint64(detail::BlobIndexFormat::Blob::optional_sint64_min_id, info.min_id);
+                        pbf_blob.add_sint64(detail::BlobIndexFormat::Blob::optional_sint64_max_id, info.max_id);
+                    }
+                    if (info.bbox.valid()) {
+                        pbf_blob.add_sint32(detail::BlobIndexFormat::Blob::optional_sint32_min_x, info.bbox.bottom_left().x());
+                        pbf_blob.add_sint32(detail::BlobIndexFormat::Blob::optional_sint32_min_y, info.bbox.bottom_left().y());
+                        pbf_blob.add_sint32(detail::BlobIndexFormat::Blob::optional_sint32_max_x, info.bbox.top_right().x());
+                        pbf_blob.add_sint32(detail::BlobIndexFormat::Blob::optional_sint32_max_y, info.bbox.top_right().y());
+                    }
+                }
+
+                const int fd = detail::open_for_writing(filename, osmium::io::overwrite::allow);
+                detail::fd_close_guard guard{fd};
+                detail::reliable_write(fd, data.data(), data.size());
+                detail::reliable_close(guard.release());
+            }
+
+            /**
+             * Load an index from a file.
+             *
+             * @throws std::system_error If the file could not be read.
+             * @throws osmium::pbf_error If the file is not a valid index.
+             */
+            static PBFBlobIndex load(const std::string& filename) {
+                const int fd = detail::open_for_reading(filename);
+                detail::fd_close_guard guard{fd};
+                std::string data(osmium::file_size(fd), '\0');
+                std::size_t pos = 0;
+                while (pos < data.size()) {
+                    const auto read_size = detail::reliable_read(fd, &data[pos], static_cast<unsigned int>(std::min(data.size() - pos, std::size_t{1024UL * 1024UL})));
+                    if (read_size == 0) {
+                        break;
+                    }
+                    pos += static_cast<std::size_t>(read_size);
+                }
+                detail::reliable_close(guard.release());
+                data.resize(pos);
+
+                PBFBlobIndex index;
+                bool format_okay = false;
+
+                try {
+                    protozero::pbf_message<detail::BlobIndexFormat::Index> pbf_index{data};
+                    while (pbf_index.next()) {
+                        switch (pbf_index.tag_and_type()) {
+                            case protozero::tag_and_type(detail::BlobIndexFormat::Index::required_string_format, protozero::pbf_wire_type::length_delimited):
+                                format_okay = pbf_index.get_string() == detail::blob_index_format_name;
+                                break;
+                            case protozero::tag_and_type(detail::BlobIndexFormat::Index::optional_uint64_filesize, protozero::pbf_wire_type::varint):
+                                index.m_file_size = pbf_index.get_uint64();
+                                break;
+                            case protozero::tag_and_type(detail::BlobIndexFormat::Index::repeated_Blob_blobs, protozero::pbf_wire_type::length_delimited): {
+                                    pbf_blob_info info;
+                                    osmium::Location bottom_left;
+                                    osmium::Location top_right;
+                                    protozero::pbf_message<detail::BlobIndexFormat::Blob> pbf_blob{pbf_index.get_message()};
+                                    while (pbf_blob.next()) {
+                                        switch (pbf_blob.tag_and_type()) {
+                                            case protozero::tag_and_type(detail::BlobIndexFormat::Blob::required_uint64_offset, protozero::pbf_wire_type::varint):
+                                                info.offset = pbf_blob.get_uint64();
+                                                break;
+                                            case protozero::tag_and_type(detail::BlobIndexFormat::Blob::required_uint64_size, protozero::pbf_wire_type::varint):
+                                                info.size = pbf_blob.get_uint64();
+                                                break;
+                                            case protozero::tag_and_type(detail::BlobIndexFormat::Blob::optional_uint32_types, protozero::pbf_wire_type::varint):
+                                                info.types = static_cast<osmium::osm_entity_bits::type>(pbf_blob.get_uint32());
+                                                break;
+                                            case protozero::tag_and_type(detail::BlobIndexFormat::Blob::optional_sint64_min_id, protozero::pbf_wire_type::varint):
+                                                info.min_id = pbf_blob.get_sint64();
+                                                break;
+                                            case protozero::tag_and_type(detail::BlobIndexFormat::Blob::optional_sint64_max_id, protozero::pbf_wire_type::varint):
+                                                info.max_id = pbf_blob.get_sint64();
+                                                break;
+                                            case protozero::tag_and_type(detail::BlobIndexFormat::Blob::optional_sint32_min_x, protozero::pbf_wire_type::varint):
+                                                bottom_left.set_x(pbf_blob.get_sint32());
+                                                break;
+                                            case protozero::tag_and_type(detail::BlobIndexFormat::Blob::optional_sint32_min_y, protozero::pbf_wire_type::varint):
+                                                bottom_left.set_y(pbf_blob.get_sint32());
+                                                break;
+                                            case protozero::tag_and_type(detail::BlobIndexFormat::Blob::optional_sint32_max_x, protozero::pbf_wire_type::varint):
+                                                top_right.set_x(pbf_blob.get_sint32());
+                                                break;
+                                            case protozero::tag_and_type(detail::BlobIndexFormat::Blob::optional_sint32_max_y, protozero::pbf_wire_type::varint):
+                                                top_right.set_y(pbf_blob.get_sint32());
+                                                break;
+                                            default:
+                                                pbf_blob.skip();
+                                        }
+                                    }
+                                    info.bbox.extend(bottom_left);
+                                    info.bbox.extend(top_right);
+                                    index.add(info);
+                                }
+                                break;
+                            default:
+                                pbf_index.skip();
+                        }
+                    }
+                } catch (const protozero::exception&) {
+                    throw osmium::pbf_error{"not a PBF blob index file"};
+                }
+
+                if (!format_okay) {
+                    throw osmium::pbf_error{"not a PBF blob index file"};
+                }
+
+                return index;
+            }
+
+        }; // class PBFBlobIndex
+
+        namespace detail {
+
+            /**
+             * Look at all objects in an (uncompressed) PrimitiveBlock and
+             * record their types and ids in the blob info.
+             */
+            inline void scan_primitive_block(const data_view& data, pbf_blob_info& info) {
+                protozero::pbf_message<OSMFormat::PrimitiveBlock> pbf_primitive_block{data};
+                while (pbf_primitive_block.next(OSMFormat::PrimitiveBlock::repeated_PrimitiveGroup_primitivegroup, protozero::pbf_wire_type::length_delimited)) {
+                    protozero::pbf_message<OSMFormat::PrimitiveGroup> pbf_primitive_group{pbf_primitive_block.get_message()};
+                    while (pbf_primitive_group.next()) {
+                        switch (pbf_primitive_group.tag_and_type()) {
+                            case protozero::tag_and_type(OSMFormat::PrimitiveGroup::repeated_Node_nodes, protozero::pbf_wire_type::length_delimited): {
+                                    protozero::pbf_message<OSMFormat::Node> pbf_node{pbf_primitive_group.get_message()};
+                                    if (pbf_node.next(OSMFormat::Node::required_sint64_id, protozero::pbf_wire_type::varint)) {
+                                        info.add(osmium::osm_entity_bits::node, pbf_node.get_sint64());
+                                    }
+                                }
+                                break;
+                            case protozero::tag_and_type(OSMFormat::PrimitiveGroup::optional_DenseNodes_dense, protozero::pbf_wire_type::length_delimited): {
+                                    protozero::pbf_message<OSMFormat::DenseNodes> pbf_dense_nodes{pbf_primitive_group.get_message()};
+                                    if (pbf_dense_nodes.next(OSMFormat::DenseNodes::packed_sint64_id, protozero::pbf_wire_type::length_delimited)) {
+                                        varint_range ids{pbf_dense_nodes.get_view()};
+                                        osmium::util::DeltaDecode<osmium::object_id_type> dense_id;
+                                        while (!ids.empty()) {
+                                            info.add(osmium::osm_entity_bits::node, dense_id.update(ids.next_sint64()));
+                                        }
+                                    }
+                                }
+                                break;
+                            case protozero::tag_and_type(OSMFormat::PrimitiveGroup::repeated_Way_ways, protozero::pbf_wire_type::length_delimited): {
+                                    protozero::pbf_message<OSMFormat::Way> pbf_way{pbf_primitive_group.get_message()};
+                                    if (pbf_way.next(OSMFormat::Way::required_int64_id, protozero::pbf_wire_type::varint)) {
+                                        info.add(osmium::osm_entity_bits::way, pbf_way.get_int64());
+                                    }
+                                }
+                                break;
+                            case protozero::tag_and_type(OSMFormat::PrimitiveGroup::repeated_Relation_relations, protozero::pbf_wire_type::length_delimited): {
+                                    protozero::pbf_message<OSMFormat::Relation> pbf_relation{pbf_primitive_group.get_message()};
+                                    if (pbf_relation.next(OSMFormat::Relation::required_int64_id, protozero::pbf_wire_type::varint)) {
+                                        info.add(osmium::osm_entity_bits::relation, pbf_relation.get_int64());
+                                    }
+                                }
+                                break;
+                            case protozero::tag_and_type(OSMFormat::PrimitiveGroup::repeated_Area_areas, protozero::pbf_wire_type::length_delimited): {
+                                    protozero::pbf_message<OSMFormat::Area> pbf_area{pbf_primitive_group.get_message()};
+                                    if (pbf_area.next(OSMFormat::Area::required_int64_id, protozero::pbf_wire_type::varint)) {
+                                        info.add(osmium::osm_entity_bits::area, pbf_area.get_int64());
+                                    }
+                                }
+                                break;
+                            default:
+                                pbf_primitive_group.skip();
+                        }
+                    }
+                }
+            }
+
+            /**
+             * Read exactly size bytes from fd into buffer.
+             *
+             * @returns true if size bytes could be read
+             *          false if EOF was encountered
+             */
+            inline bool read_exactly_from_fd(int fd, char* buffer, std::size_t size) {
+                std::size_t to_read = size;
+
+                while (to_read > 0) {
+                    const auto read_size = reliable_read(fd, buffer + (size - to_read), static_cast<unsigned int>(to_read));
+                    if (read_size == 0) { // EOF
+                        return false;
+                    }
+                    to_read -= static_cast<std::size_t>(read_size);
+                }
+
+                return true;
+            }
+
+            /**
+             * Skip size bytes in the file. Uses lseek() if possible.
+             *
+             * @returns true if size bytes could be skipped
+             *          false if EOF was encountered
+             */
+            inline bool skip_in_fd(int fd, std::size_t size, std::string& buffer) {
+#ifdef _MSC_VER
+                osmium::detail::disable_invalid_parameter_handler diph;
+                const auto offset = _lseeki64(fd, static_cast<__int64>(size), SEEK_CUR);
+#else
+                const auto offset = ::lseek(fd, static_cast<off_t>(size), SEEK_CUR);
+#endif
+                if (offset != -1) {
+                    // lseek() doesn't fail when moving past the end of
+                    // the file, so check for truncated files here.
+                    return static_cast<std::size_t>(offset) <= osmium::file_size(fd);
+                }
+                buffer.resize(size);
+                return read_exactly_from_fd(fd, &*buffer.begin(), size);
+            }
+
+        } // namespace detail
+
+        /**
+         * Create a blob index for the (uncompressed) PBF file with the
+         * given name.
+         *
+         * If the BlobHeaders contain index data (libosmium writes this
+         * if the `pbf_index_data` file option is set), only the headers
+         * are read. Otherwise the blobs are
+         * read and decompressed to find out which objects are in them,
+         * but the objects are not decoded.
+         *
+         * @throws std::system_error If the file could not be read.
+         * @throws osmium::pbf_error If the file is not a valid PBF file.
+         */
+        inline PBFBlobIndex create_pbf_blob_index(const std::string& filename) {
+            const int fd = detail::open_for_reading(filename);
+            detail::fd_close_guard guard{fd};
+            PBFBlobIndex index{osmium::file_size(fd)};
+
+            std::size_t offset = 0;
+            std::string header;
+            std::string blob;
+            std::string output;
+            bool first = true;
+
+            while (true) {
+                std::array<char, sizeof(uint32_t)> size_buffer{};
+                if (!detail::read_exactly_from_fd(fd, size_buffer.data(), size_buffer.size())) {
+                    break; // EOF
+                }
+
+                const auto header_size = detail::get_size_in_network_byte_order(size_buffer.data());
+                if (header_size > static_cast<uint32_t>(detail::max_blob_header_size)) {
+                    throw osmium::pbf_error{"invalid BlobHeader size (> max_blob_header_size)"};
+                }
+
+                header.resize(header_size);
+                if (!detail::read_exactly_from_fd(fd, &*header.begin(), header_size)) {
+                    throw osmium::pbf_error{"unexpected EOF"};
+                }
+                detail::pbf_index_data index_data;
+                const auto blob_size = detail::decode_blob_header(protozero::data_view{header.data(), header.size()}, first ? "OSMHeader" : "OSMData", &index_data);
+                if (blob_size > detail::max_uncompressed_blob_size) {
+                    throw osmium::pbf_error{std::string{"invalid blob size: "} + std::to_string(blob_size)};
+                }
+
+                const std::size_t size = size_buffer.size() + header_size + blob_size;
+                pbf_blob_info info{offset, size};
+
+                if (first || index_data.valid()) {
+                    if (!detail::skip_in_fd(fd, blob_size, blob)) {
+                        throw osmium::pbf_error{"unexpected EOF"};
+                    }
+                    info.types = index_data.types;
+                    info.min_id = index_data.min_id;
+                    info.max_id = index_data.max_id;
+                    info.bbox = index_data.bbox;
+                } else {
+                    blob.resize(blob_size);
+                    if (!detail::read_exactly_from_fd(fd, &*blob.begin(), blob_size)) {
+                        throw osmium::pbf_error{"unexpected EOF"};
+                    }
+                    detail::scan_primitive_block(detail::decode_blob(protozero::data_view{blob.data(), blob.size()}, output), info);
+                }
+
+                if (!first) {
+                    index.add(info);
+                }
+
+                offset += size;
+                first = false;
+            }
+
+            detail::reliable_close(guard.release());
+
+            return index;
+        }
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_PBF_BLOB_INDEX_HPP
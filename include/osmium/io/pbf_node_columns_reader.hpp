@@ -0,0 +1,235 @@
+#ifndef OSMIUM_IO_PBF_NODE_COLUMNS_READER_HPP
+#define OSMIUM_IO_PBF_NODE_COLUMNS_READER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2023 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/detail/pbf.hpp> // IWYU pragma: export
+#include <osmium/io/detail/pbf_decoder.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/node_columns.hpp>
+#include <osmium/io/pbf_blob_index.hpp>
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <protozero/types.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <initializer_list>
+#include <string>
+#include <utility>
+
+namespace osmium {
+
+    namespace io {
+
+        /**
+         * Read only the ids and locations of all nodes in an (uncompressed
+         * or compressed) PBF file. For each blob containing nodes
+         * a NodeColumns object is returned. No osmium::Node objects are
+         * built, tags and metadata are not decoded, and blobs which,
+         * according to their index data, don't contain any nodes are
+         * skipped without being read.
+         *
+         * The blobs are decoded in parallel in the thread pool, the results
+         * are returned in the order of the blobs in the file.
+         *
+         * Use this instead of the Reader if you only need node locations,
+         * for instance to fill a location index. See also
+         * apply_node_columns().
+         */
+        class PBFNodeColumnsReader {
+
+            osmium::thread::Pool& m_pool;
+            std::deque<std::future<NodeColumns>> m_queue{};
+            std::size_t m_max_queue_size;
+            int m_fd;
+            bool m_first = true;
+            bool m_eof = false;
+
+            std::string m_header{};
+            std::string m_skip_buffer{};
+
+            // Read the next blob containing nodes and hand it to the thread
+            // pool for decoding. Sets m_eof at the end of the file.
+            void submit_next_blob() {
+                while (true) {
+                    std::array<char, sizeof(uint32_t)> size_buffer{};
+                    if (!detail::read_exactly_from_fd(m_fd, size_buffer.data(), size_buffer.size())) {
+                        m_eof = true;
+                        return;
+                    }
+
+                    const auto header_size = detail::get_size_in_network_byte_order(size_buffer.data());
+                    if (header_size > static_cast<uint32_t>(detail::max_blob_header_size)) {
+                        throw osmium::pbf_error{"invalid BlobHeader size (> max_blob_header_size)"};
+                    }
+
+                    m_header.resize(header_size);
+                    if (!detail::read_exactly_from_fd(m_fd, &*m_header.begin(), header_size)) {
+                        throw osmium::pbf_error{"unexpected EOF"};
+                    }
+
+                    detail::pbf_index_data index_data;
+                    const auto blob_size = detail::decode_blob_header(protozero::data_view{m_header.data(), m_header.size()}, m_first ? "OSMHeader" : "OSMData", &index_data);
+                    if (blob_size > detail::max_uncompressed_blob_size) {
+                        throw osmium::pbf_error{std::string{"invalid blob size: "} + std::to_string(blob_size)};
+                    }
+
+                    if (m_first || (index_data.valid() && !(index_data.types & osmium::osm_entity_bits::node))) {
+                        m_first = false;
+                        if (!detail::skip_in_fd(m_fd, blob_size, m_skip_buffer)) {
+                            throw osmium::pbf_error{"unexpected EOF"};
+                        }
+                        continue;
+                    }
+
+                    std::string blob(blob_size, '\0');
+                    if (!detail::read_exactly_from_fd(m_fd, &*blob.begin(), blob_size)) {
+                        throw osmium::pbf_error{"unexpected EOF"};
+                    }
+                    m_queue.push_back(m_pool.submit(detail::PBFNodeColumnsDecoder{std::move(blob)}));
+                    return;
+                }
+            }
+
+        public:
+
+            /**
+             * Open a PBF file for reading node locations.
+             *
+             * @param filename Name of the PBF file.
+             * @param pool Thread pool used for decoding the blobs.
+             *
+             * @throws std::system_error If the file could not be opened.
+             */
+            explicit PBFNodeColumnsReader(const std::string& filename,
+                                          osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) :
+                m_pool(pool),
+                m_max_queue_size(static_cast<std::size_t>(pool.num_threads()) * 2),
+                m_fd(detail::open_for_reading(filename)) {
+            }
+
+            PBFNodeColumnsReader(const PBFNodeColumnsReader&) = delete;
+            PBFNodeColumnsReader& operator=(const PBFNodeColumnsReader&) = delete;
+
+            PBFNodeColumnsReader(PBFNodeColumnsReader&&) = delete;
+            PBFNodeColumnsReader& operator=(PBFNodeColumnsReader&&) = delete;
+
+            ~PBFNodeColumnsReader() noexcept {
+                try {
+                    close();
+                } catch (...) {
+                    // Ignore any exceptions because destructor must not throw.
+                }
+            }
+
+            /**
+             * Close the file. A call to this is optional, because the
+             * destructor will also call this. But if you don't call this
+             * function first, you might miss an exception, because the
+             * destructor is not allowed to throw.
+             */
+            void close() {
+                // Wait for all outstanding decoding tasks, they don't
+                // reference this object, so the results can be dropped.
+                for (auto& future : m_queue) {
+                    future.wait();
+                }
+                m_queue.clear();
+                m_eof = true;
+                if (m_fd >= 0) {
+                    const int fd = m_fd;
+                    m_fd = -1;
+                    detail::reliable_close(fd);
+                }
+            }
+
+            /**
+             * Read the ids and locations of the nodes in the next blob
+             * containing nodes.
+             *
+             * @returns The nodes in the next blob. Empty at the end of the
+             *          file or after close() was called.
+             *
+             * @throws osmium::pbf_error If there was a problem decoding
+             *         the data.
+             * @throws std::system_error If the file could not be read.
+             */
+            NodeColumns read() {
+                while (true) {
+                    while (!m_eof && m_queue.size() < m_max_queue_size) {
+                        submit_next_blob();
+                    }
+
+                    if (m_queue.empty()) {
+                        return NodeColumns{};
+                    }
+
+                    auto columns = m_queue.front().get();
+                    m_queue.pop_front();
+                    if (!columns.empty()) {
+                        return columns;
+                    }
+                }
+            }
+
+        }; // class PBFNodeColumnsReader
+
+        /**
+         * Read all node locations with the PBFNodeColumnsReader and call
+         * the node_columns() function of all handlers with them, followed
+         * by a call to flush().
+         */
+        template <typename... THandlers>
+        inline void apply_node_columns(PBFNodeColumnsReader& reader, THandlers&&... handlers) {
+            while (true) {
+                const auto columns = reader.read();
+                if (columns.empty()) {
+                    break;
+                }
+                (void)std::initializer_list<int>{
+                    (handlers.node_columns(columns), 0)...};
+            }
+            (void)std::initializer_list<int>{
+                (handlers.flush(), 0)...};
+        }
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_PBF_NODE_COLUMNS_READER_HPP
@@ -0,0 +1,387 @@
+#ifndef OSMIUM_IO_PBF_RANDOM_ACCESS_READER_HPP
+#define OSMIUM_IO_PBF_RANDOM_ACCESS_READER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2023 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/detail/pbf.hpp> // IWYU pragma: export
+#include <osmium/io/detail/pbf_decoder.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/file_format.hpp>
+#include <osmium/io/pbf_blob_index.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/util/file.hpp>
+
+#include <protozero/types.hpp>
+
+#ifdef _MSC_VER
+# include <io.h>
+#else
+# include <sys/types.h>
+# include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <iterator>
+#include <list>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        /**
+         * Look up single OSM objects by type and id in a PBF file without
+         * reading the whole file. A PBFBlobIndex is used to find the blob
+         * the object must be in, only that blob is read and decoded. The
+         * most recently used decoded blobs are kept in a small cache.
+         *
+         * This works best with files sorted by type and id. For those the
+         * right blob is found with a binary search. For unsorted files
+         * all blobs whose id range contains the id are tried.
+         */
+        class PBFRandomAccessReader {
+
+            // A decoded blob with all its objects sorted by id.
+            struct cached_blob {
+                std::size_t blob_num;
+                std::vector<osmium::memory::Buffer> buffers;
+                std::vector<const osmium::OSMObject*> objects;
+            };
+
+            PBFBlobIndex m_index;
+            std::size_t m_cache_size;
+            osmium::io::read_meta m_read_metadata;
+            int m_fd;
+            bool m_sorted;
+
+            // Most recently used blob is at the front
+            std::list<cached_blob> m_cache{};
+
+            std::string m_input_buffer{};
+            std::string m_output_buffer{};
+
+            static bool check_sorted(const PBFBlobIndex& index) noexcept {
+                for (std::size_t n = 1; n < index.size(); ++n) {
+                    const auto& prev = index[n - 1];
+                    const auto& curr = index[n];
+                    if (prev.types == curr.types) {
+                        if (curr.min_id < prev.max_id) {
+                            return false;
+                        }
+                    } else if (curr.types < prev.types) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            void read_blob(const pbf_blob_info& info) {
+#ifdef _MSC_VER
+                osmium::detail::disable_invalid_parameter_handler diph;
+                if (_lseeki64(m_fd, static_cast<__int64>(info.offset), SEEK_SET) == -1) {
+#else
+                if (::lseek(m_fd, static_cast<off_t>(info.offset), SEEK_SET) == -1) {
+#endif
+                    throw std::system_error{errno, std::system_category(), "Seek failed"};
+                }
+
+                m_input_buffer.resize(info.size);
+                if (!detail::read_exactly_from_fd(m_fd, &*m_input_buffer.begin(), info.size)) {
+                    throw osmium::pbf_error{"unexpected EOF"};
+                }
+            }
+
+            cached_blob decode_blob(std::size_t blob_num) {
+                const auto& info = m_index[blob_num];
+                if (info.size < sizeof(uint32_t)) {
+                    throw osmium::pbf_error{"invalid blob size in index"};
+                }
+
+                read_blob(info);
+
+                const auto header_size = detail::get_size_in_network_byte_order(m_input_buffer.data());
+                if (header_size > info.size - sizeof(uint32_t)) {
+                    throw osmium::pbf_error{"invalid BlobHeader size"};
+                }
+                const protozero::data_view header{m_input_buffer.data() + sizeof(uint32_t), header_size};
+                const auto blob_size = detail::decode_blob_header(header, "OSMData");
+                if (blob_size != info.size - sizeof(uint32_t) - header_size) {
+                    throw osmium::pbf_error{"blob index does not match file"};
+                }
+
+                detail::PBFPrimitiveBlockDecoder decoder{
+                    detail::decode_blob(protozero::data_view{header.data() + header.size(), blob_size}, m_output_buffer),
+                    info.types == osmium::osm_entity_bits::nothing ? osmium::osm_entity_bits::nwra : info.types,
+                    m_read_metadata};
+
+                cached_blob blob{blob_num, {}, {}};
+                blob.buffers.push_back(decoder());
+                while (blob.buffers.front().has_nested_buffers()) {
+                    blob.buffers.push_back(std::move(*blob.buffers.front().get_last_nested()));
+                }
+
+                for (const auto& buffer : blob.buffers) {
+                    for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                        blob.objects.push_back(&object);
+                    }
+                }
+
+                std::stable_sort(blob.objects.begin(), blob.objects.end(), [](const osmium::OSMObject* lhs, const osmium::OSMObject* rhs) {
+                    return lhs->type() < rhs->type() || (lhs->type() == rhs->type() && lhs->id() < rhs->id());
+                });
+
+                return blob;
+            }
+
+            const cached_blob& get_blob(std::size_t blob_num) {
+                const auto it = std::find_if(m_cache.begin(), m_cache.end(), [blob_num](const cached_blob& blob) {
+                    return blob.blob_num == blob_num;
+                });
+
+                if (it != m_cache.end()) {
+                    m_cache.splice(m_cache.begin(), m_cache, it);
+                } else {
+                    m_cache.push_front(decode_blob(blob_num));
+                    while (m_cache.size() > m_cache_size) {
+                        m_cache.pop_back();
+                    }
+                }
+
+                return m_cache.front();
+            }
+
+            static const osmium::OSMObject* find_in_blob(const cached_blob& blob, osmium::item_type type, osmium::object_id_type id) noexcept {
+                const auto range = std::equal_range(blob.objects.begin(), blob.objects.end(), std::make_pair(type, id), id_compare{});
+                if (range.first == range.second) {
+                    return nullptr;
+                }
+                // If there are several versions of the object, return the
+                // last one.
+                return *std::prev(range.second);
+            }
+
+            struct id_compare {
+
+                using key_type = std::pair<osmium::item_type, osmium::object_id_type>;
+
+                bool operator()(const osmium::OSMObject* object, const key_type& key) const noexcept {
+                    return object->type() < key.first || (object->type() == key.first && object->id() < key.second);
+                }
+
+                bool operator()(const key_type& key, const osmium::OSMObject* object) const noexcept {
+                    return key.first < object->type() || (key.first == object->type() && key.second < object->id());
+                }
+
+            }; // struct id_compare
+
+        public:
+
+            enum {
+                default_cache_size = 8
+            };
+
+            /**
+             * Open a PBF file for random access using an existing index.
+             *
+             * @param filename Name of the PBF file.
+             * @param index Blob index for this file.
+             * @param cache_size Maximum number of decoded blobs to keep.
+             * @param read_metadata Decode metadata of objects?
+             *
+             * @throws std::system_error If the file could not be opened.
+             * @throws osmium::pbf_error If the index doesn't fit the file.
+             */
+            PBFRandomAccessReader(const std::string& filename,
+                                  PBFBlobIndex index,
+                                  std::size_t cache_size = default_cache_size,
+                                  osmium::io::read_meta read_metadata = osmium::io::read_meta::yes) :
+                m_index(std::move(index)),
+                m_cache_size(cache_size == 0 ? 1 : cache_size),
+                m_read_metadata(read_metadata),
+                m_fd(detail::open_for_reading(filename)),
+                m_sorted(check_sorted(m_index)) {
+                if (m_index.file_size() != osmium::file_size(m_fd)) {
+                    detail::reliable_close(m_fd);
+                    throw osmium::pbf_error{"blob index does not match file"};
+                }
+            }
+
+            /**
+             * Open a PBF file for random access. The blob index is created
+             * by scanning the file, which is cheap for files that contain
+             * index data in their BlobHeaders.
+             *
+             * @param filename Name of the PBF file.
+             * @param cache_size Maximum number of decoded blobs to keep.
+             * @param read_metadata Decode metadata of objects?
+             *
+             * @throws std::system_error If the file could not be opened.
+             * @throws osmium::pbf_error If the file is not a valid PBF file.
+             */
+            explicit PBFRandomAccessReader(const std::string& filename,
+                                           std::size_t cache_size = default_cache_size,
+                                           osmium::io::read_meta read_metadata = osmium::io::read_meta::yes) :
+                PBFRandomAccessReader(filename, create_pbf_blob_index(filename), cache_size, read_metadata) {
+            }
+
+            PBFRandomAccessReader(const PBFRandomAccessReader&) = delete;
+            PBFRandomAccessReader& operator=(const PBFRandomAccessReader&) = delete;
+
+            PBFRandomAccessReader(PBFRandomAccessReader&&) = delete;
+            PBFRandomAccessReader& operator=(PBFRandomAccessReader&&) = delete;
+
+            ~PBFRandomAccessReader() noexcept {
+                try {
+                    close();
+                } catch (...) {
+                    // Ignore any exceptions because destructor must not throw.
+                }
+            }
+
+            /**
+             * Close the file. A call to this is optional, because the
+             * destructor will also call this. But if you don't call this
+             * function first, you might miss an exception, because the
+             * destructor is not allowed to throw.
+             */
+            void close() {
+                m_cache.clear();
+                if (m_fd >= 0) {
+                    const int fd = m_fd;
+                    m_fd = -1;
+                    detail::reliable_close(fd);
+                }
+            }
+
+            const PBFBlobIndex& index() const noexcept {
+                return m_index;
+            }
+
+            /// Is the file sorted so binary search can be used?
+            bool sorted() const noexcept {
+                return m_sorted;
+            }
+
+            /// Number of decoded blobs currently in the cache.
+            std::size_t num_cached_blobs() const noexcept {
+                return m_cache.size();
+            }
+
+            /**
+             * Get the object with the given type and id. If the file
+             * contains several versions of the object, the last one in the
+             * file is returned.
+             *
+             * @returns Pointer to the object or nullptr if it wasn't found.
+             *          The pointer is only valid until the next call to
+             *          get() or close().
+             *
+             * @pre File must not be closed.
+             * @throws osmium::pbf_error If there was a problem decoding
+             *         the data.
+             * @throws std::system_error If the file could not be read.
+             */
+            const osmium::OSMObject* get(osmium::item_type type, osmium::object_id_type id) {
+                const auto types = osmium::osm_entity_bits::from_item_type(type);
+
+                const auto blob_matches = [types, id](const pbf_blob_info& info) noexcept {
+                    return info.contains(types) && info.min_id <= id && id <= info.max_id;
+                };
+
+                if (m_sorted) {
+                    // Find the first blob of this type (or a later type)
+                    // whose largest id is not smaller than id.
+                    const auto it = std::lower_bound(m_index.begin(), m_index.end(), std::make_pair(types, id),
+                        [](const pbf_blob_info& info, const std::pair<osmium::osm_entity_bits::type, osmium::object_id_type>& key) noexcept {
+                            return info.types < key.first || (info.types == key.first && info.max_id < key.second);
+                        });
+                    if (it == m_index.end() || !blob_matches(*it)) {
+                        return nullptr;
+                    }
+
+                    // In history files the versions of an object can be
+                    // spread over several blobs whose id ranges touch.
+                    // Look at the last of those first.
+                    const auto first = static_cast<std::size_t>(std::distance(m_index.begin(), it));
+                    auto last = first;
+                    while (last + 1 < m_index.size() && blob_matches(m_index[last + 1])) {
+                        ++last;
+                    }
+                    for (auto n = last + 1; n > first; --n) {
+                        const auto* object = find_in_blob(get_blob(n - 1), type, id);
+                        if (object) {
+                            return object;
+                        }
+                    }
+                    return nullptr;
+                }
+
+                // Search from the end, so we find the last version of the
+                // object in the file.
+                for (std::size_t n = m_index.size(); n > 0; --n) {
+                    if (blob_matches(m_index[n - 1])) {
+                        const auto* object = find_in_blob(get_blob(n - 1), type, id);
+                        if (object) {
+                            return object;
+                        }
+                    }
+                }
+
+                return nullptr;
+            }
+
+            /**
+             * Get the object of type T (osmium::Node, osmium::Way, etc.)
+             * with the given id. See get() for details.
+             */
+            template <typename T>
+            const T* get(osmium::object_id_type id) {
+                return static_cast<const T*>(get(T::itemtype, id));
+            }
+
+        }; // class PBFRandomAccessReader
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_PBF_RANDOM_ACCESS_READER_HPP
@@ -0,0 +1,264 @@
+#ifndef OSMIUM_IO_PIPELINE_STATS_HPP
+#define OSMIUM_IO_PIPELINE_STATS_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2023 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/thread/queue_stats.hpp>
+#include <osmium/util/tracer.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace osmium {
+
+    namespace io {
+
+        /**
+         * Statistics about a Reader returned by Reader::stats(). All times
+         * are summed up over all threads working on that stage, so they
+         * can be larger than the wall clock time if the thread pool is
+         * used. Use them to find out whether reading is I/O bound,
+         * decompression bound, parser bound, or bound by the code using
+         * the data.
+         */
+        struct reader_stats {
+
+            /// Number of bytes read from the input. For compressed files
+            /// this is the compressed size. Parts of a PBF file that are
+            /// skipped without reading them are not counted.
+            std::uint64_t bytes_read = 0;
+
+            /// Time spent reading uncompressed input from the file.
+            std::chrono::nanoseconds read_time{0};
+
+            /// Time spent reading and decompressing compressed input files
+            /// and decompressing the blobs in PBF files.
+            std::chrono::nanoseconds decompress_time{0};
+
+            /// Time spent parsing the data into OSM objects.
+            std::chrono::nanoseconds parse_time{0};
+
+            /// Time Reader::read() was blocked waiting for data.
+            std::chrono::nanoseconds wait_time{0};
+
+            /// Queue between read thread and parser.
+            osmium::thread::queue_stats input_queue;
+
+            /// Queue between parser and Reader::read().
+            osmium::thread::queue_stats osmdata_queue;
+
+        }; // struct reader_stats
+
+        /**
+         * Statistics about a Writer returned by Writer::stats(). All times
+         * are summed up over all threads working on that stage.
+         */
+        struct writer_stats {
+
+            /// Number of bytes of encoded data given to the compressor or,
+            /// for uncompressed files, written to the file.
+            std::uint64_t bytes_written = 0;
+
+            /// Time spent encoding OSM objects into the output format.
+            std::chrono::nanoseconds encode_time{0};
+
+            /// Time spent compressing PBF blobs and compressing and writing
+            /// compressed output files.
+            std::chrono::nanoseconds compress_time{0};
+
+            /// Time spent writing uncompressed output files.
+            std::chrono::nanoseconds write_time{0};
+
+            /// Time the write thread was blocked waiting for data.
+            std::chrono::nanoseconds wait_time{0};
+
+            /// Queue between the encoder and the write thread.
+            osmium::thread::queue_stats output_queue;
+
+        }; // struct writer_stats
+
+        namespace detail {
+
+            enum class pipeline_stage : std::size_t {
+                read       = 0,
+                decompress = 1,
+                parse      = 2,
+                encode     = 3,
+                compress   = 4,
+                write      = 5,
+                wait       = 6,
+                last       = 6 // must have the same value as the last real value
+            };
+
+            inline const char* stage_name(const pipeline_stage stage) noexcept {
+                static const char* names[] = {
+                    "read",
+                    "decompress",
+                    "parse",
+                    "encode",
+                    "compress",
+                    "write",
+                    "wait"
+                };
+                return names[static_cast<std::size_t>(stage)];
+            }
+
+            /**
+             * Counters shared by all threads of a Reader or Writer. Updates
+             * are relaxed atomic additions, so they are cheap enough to
+             * always be collected.
+             */
+            class pipeline_counters {
+
+                std::array<std::atomic<std::int64_t>, static_cast<std::size_t>(pipeline_stage::last) + 1> m_time_ns;
+
+                std::atomic<std::uint64_t> m_bytes{0};
+
+                std::atomic<std::int64_t>& counter(const pipeline_stage stage) noexcept {
+                    return m_time_ns[static_cast<std::size_t>(stage)];
+                }
+
+                const std::atomic<std::int64_t>& counter(const pipeline_stage stage) const noexcept {
+                    return m_time_ns[static_cast<std::size_t>(stage)];
+                }
+
+            public:
+
+                pipeline_counters() noexcept {
+                    for (auto& time_ns : m_time_ns) {
+                        time_ns.store(0, std::memory_order_relaxed);
+                    }
+                }
+
+                /**
+                 * Add the duration to the time spent in the given stage.
+                 * The duration can be negative to take out time spent
+                 * waiting while in a stage.
+                 */
+                void add_time(const pipeline_stage stage, const std::chrono::steady_clock::duration duration) noexcept {
+                    counter(stage).fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count(), std::memory_order_relaxed);
+                }
+
+                std::chrono::nanoseconds time(const pipeline_stage stage) const noexcept {
+                    return std::chrono::nanoseconds{counter(stage).load(std::memory_order_relaxed)};
+                }
+
+                void add_bytes(const std::uint64_t bytes) noexcept {
+                    m_bytes.fetch_add(bytes, std::memory_order_relaxed);
+                }
+
+                std::uint64_t bytes() const noexcept {
+                    return m_bytes.load(std::memory_order_relaxed);
+                }
+
+            }; // class pipeline_counters
+
+            /**
+             * Adds the time between construction and destruction of this
+             * object to a stage of the pipeline counters (if they are not
+             * a nullptr). If the osmium::Tracer is enabled, the time is
+             * also recorded as a trace event named after the stage.
+             */
+            class stage_timer {
+
+                pipeline_counters* m_counters;
+                pipeline_stage m_stage;
+                std::chrono::steady_clock::time_point m_start;
+
+            public:
+
+                stage_timer(pipeline_counters* counters, const pipeline_stage stage) noexcept :
+                    m_counters(counters),
+                    m_stage(stage),
+                    m_start((counters || osmium::Tracer::instance().enabled()) ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{}) {
+                }
+
+                stage_timer(const stage_timer&) = delete;
+                stage_timer& operator=(const stage_timer&) = delete;
+
+                stage_timer(stage_timer&&) = delete;
+                stage_timer& operator=(stage_timer&&) = delete;
+
+                ~stage_timer() noexcept {
+                    if (m_start == std::chrono::steady_clock::time_point{}) {
+                        return;
+                    }
+                    const auto end = std::chrono::steady_clock::now();
+                    if (m_counters) {
+                        m_counters->add_time(m_stage, end - m_start);
+                    }
+                    osmium::Tracer::instance().add_event(stage_name(m_stage), m_start, end);
+                }
+
+            }; // class stage_timer
+
+            /**
+             * Wraps a function object and adds the time it runs to a stage
+             * of the pipeline counters. Used for tasks submitted to the
+             * thread pool. The counters are kept alive by the task, because
+             * it might still run after the Reader or Writer is gone.
+             */
+            template <typename TFunction>
+            class timed_function {
+
+                TFunction m_function;
+                std::shared_ptr<pipeline_counters> m_counters;
+                pipeline_stage m_stage;
+
+            public:
+
+                timed_function(TFunction&& function, std::shared_ptr<pipeline_counters> counters, const pipeline_stage stage) :
+                    m_function(std::move(function)),
+                    m_counters(std::move(counters)),
+                    m_stage(stage) {
+                }
+
+                auto operator()() -> decltype(std::declval<TFunction&>()()) {
+                    const stage_timer timer{m_counters.get(), m_stage};
+                    return m_function();
+                }
+
+            }; // class timed_function
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_PIPELINE_STATS_HPP
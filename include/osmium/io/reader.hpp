@@ -41,8 +41,13 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/io/error.hpp>
 #include <osmium/io/file.hpp>
 #include <osmium/io/header.hpp>
+#include <osmium/io/pipeline_stats.hpp>
 #include <osmium/memory/buffer.hpp>
+#include <osmium/memory/buffer_recycler.hpp>
+#include <osmium/osm/box.hpp>
 #include <osmium/osm/entity_bits.hpp>
+#include <osmium/osm/metadata_options.hpp>
+#include <osmium/tags/tags_filter.hpp>
 #include <osmium/thread/pool.hpp>
 #include <osmium/thread/util.hpp>
 #include <osmium/util/config.hpp>
@@ -100,6 +105,8 @@ namespace osmium {
 
             std::atomic<std::size_t> m_offset{0};
 
+            std::shared_ptr<detail::pipeline_counters> m_counters{std::make_shared<detail::pipeline_counters>()};
+
             detail::ParserFactory::create_parser_type m_creator;
 
             enum class status {
@@ -132,6 +139,15 @@ namespace osmium {
             osmium::osm_entity_bits::type m_read_which_entities = osmium::osm_entity_bits::all;
             osmium::io::read_meta m_read_metadata = osmium::io::read_meta::yes;
             osmium::io::buffers_type m_buffers_kind = osmium::io::buffers_type::any;
+            osmium::io::read_mmap m_read_mmap = osmium::io::read_mmap::no;
+            osmium::io::blob_range m_blob_range{};
+            osmium::Box m_bbox{};
+            std::shared_ptr<osmium::memory::detail::recycler_handle> m_recycler{};
+            osmium::io::read_fields::type m_read_which_fields = osmium::io::read_fields::all;
+            osmium::metadata_options m_read_metadata_options{};
+            std::shared_ptr<const osmium::TagsFilter> m_tags_filter{};
+            osmium::io::read_order m_read_order = osmium::io::read_order::file;
+            std::size_t m_max_queue_bytes = 0;
 
             void set_option(osmium::thread::Pool& pool) noexcept {
                 m_pool = &pool;
@@ -154,6 +170,42 @@ namespace osmium {
                 m_buffers_kind = value;
             }
 
+            void set_option(osmium::io::read_mmap value) noexcept {
+                m_read_mmap = value;
+            }
+
+            void set_option(const osmium::io::blob_range& value) noexcept {
+                m_blob_range = value;
+            }
+
+            void set_option(const osmium::Box& value) noexcept {
+                m_bbox = value;
+            }
+
+            void set_option(osmium::memory::BufferRecycler& recycler) {
+                m_recycler = std::make_shared<osmium::memory::detail::recycler_handle>(recycler);
+            }
+
+            void set_option(osmium::io::read_fields::type value) noexcept {
+                m_read_which_fields = value;
+            }
+
+            void set_option(const osmium::metadata_options& value) noexcept {
+                m_read_metadata_options = value;
+            }
+
+            void set_option(const osmium::TagsFilter& filter) {
+                m_tags_filter = std::make_shared<const osmium::TagsFilter>(filter);
+            }
+
+            void set_option(osmium::io::read_order value) noexcept {
+                m_read_order = value;
+            }
+
+            void set_option(const osmium::io::max_queue_bytes& value) noexcept {
+                m_max_queue_bytes = value.bytes;
+            }
+
             // This function will run in a separate thread.
             static void parser_thread(osmium::thread::Pool& pool,
                                       int fd,
@@ -165,7 +217,16 @@ namespace osmium {
                                       osmium::osm_entity_bits::type read_which_entities,
                                       osmium::io::read_meta read_metadata,
                                       osmium::io::buffers_type buffers_kind,
-                                      bool want_buffered_pages_removed) {
+                                      bool want_buffered_pages_removed,
+                                      osmium::io::read_mmap use_mmap,
+                                      osmium::io::blob_range range,
+                                      osmium::Box bbox,
+                                      const std::shared_ptr<osmium::memory::detail::recycler_handle>& recycler,
+                                      osmium::io::read_fields::type read_which_fields,
+                                      osmium::metadata_options read_metadata_options,
+                                      const std::shared_ptr<const osmium::TagsFilter>& tags_filter,
+                                      osmium::io::read_order order,
+                                      const std::shared_ptr<detail::pipeline_counters>& counters) {
                 std::promise<osmium::io::Header> promise{std::move(header_promise)};
                 osmium::io::detail::parser_arguments args = {
                     pool,
@@ -177,7 +238,16 @@ namespace osmium {
                     read_which_entities,
                     read_metadata,
                     buffers_kind,
-                    want_buffered_pages_removed};
+                    want_buffered_pages_removed,
+                    use_mmap,
+                    range,
+                    bbox,
+                    recycler,
+                    read_which_fields,
+                    read_metadata_options,
+                    tags_filter,
+                    order,
+                    counters};
                 creator(args)->parse();
             }
 
@@ -305,6 +375,67 @@ namespace osmium {
              *      use in "single" mode if the input file is not sorted by
              *      type, otherwise this will be rather inefficient.
              *
+             * * osmium::io::read_mmap: Memory map the input file instead of
+             *      reading it into buffers (osmium::io::read_mmap::yes).
+             *      This is currently only used for PBF files read from a
+             *      regular file, it saves copying every blob before it is
+             *      decoded. If the input can not be mapped (for instance
+             *      because it is a pipe), it is read normally. The default
+             *      is osmium::io::read_mmap::no.
+             *
+             * * osmium::io::blob_range: Only read the PBF blobs in the given
+             *      range of file offsets. The offsets usually come from a
+             *      PBFBlobIndex. This allows reading only part of a file or
+             *      reading disjoint parts of a file with several readers in
+             *      parallel. The header is always read.
+             *
+             * * osmium::Box: Skip all PBF blobs whose bounding box (as
+             *      recorded by the writer in the BlobHeader) doesn't
+             *      overlap this box. Blobs without bounding box information
+             *      (for instance those containing relations) are always
+             *      read. This does not filter individual objects, only
+             *      whole blobs are skipped, so the results will contain
+             *      objects outside the box.
+             *
+             * * osmium::memory::BufferRecycler&: Reference to a recycler
+             *      the PBF decoder gets its buffers from. Put the buffers
+             *      returned by read() into the recycler once you are done
+             *      with them, so their memory can be reused. The recycler
+             *      must not be destroyed before the Reader is closed.
+             *
+             * * osmium::io::read_fields::type: Which parts of the objects
+             *      (tags, way nodes, relation members) should be read. The
+             *      default is osmium::io::read_fields::all. Parts not read
+             *      are missing from the objects. Used by the PBF, O5M, and
+             *      XML parsers.
+             *
+             * * osmium::metadata_options: Which metadata fields (version,
+             *      timestamp, changeset, uid, user) should be read if meta
+             *      data is read at all (see osmium::io::read_meta). The
+             *      default is all fields. Used by the PBF, O5M, and XML
+             *      parsers.
+             *
+             * * osmium::TagsFilter: Only read objects with at least one tag
+             *      for which the filter returns true. The filter is checked
+             *      against the string table of each PBF block first, so
+             *      blocks without any matching strings are not decoded at
+             *      all. The filter is copied. This is currently only used
+             *      for PBF files, other formats return all objects.
+             *
+             * * osmium::io::read_order: Return buffers in the order of
+             *      the file (osmium::io::read_order::file, the default) or
+             *      as soon as they are ready (osmium::io::read_order::any).
+             *      Only the PBF parser makes use of this. Use
+             *      Buffer::sequence() to find out which PBF blob a buffer
+             *      was decoded from.
+             *
+             * * osmium::io::max_queue_bytes: Maximum number of bytes of
+             *      data in each of the queues between the read thread and
+             *      the parser and between the parser and the read()
+             *      function. The default is no limit, or the limits set in
+             *      the environment variables OSMIUM_MAX_INPUT_QUEUE_MB and
+             *      OSMIUM_MAX_OSMDATA_QUEUE_MB.
+             *
              * * osmium::thread::Pool&: Reference to a thread pool that should
              *      be used for reading instead of the default pool. Usually
              *      it is okay to use the statically initialized shared
@@ -323,7 +454,9 @@ namespace osmium {
                 m_fd(m_file.buffer() ? -1 : open_input_file_or_url(m_file.filename(), &m_childpid)),
                 m_file_size(m_fd > 2 ? osmium::file_size(m_fd) : 0),
                 m_decompressor(make_decompressor(m_file, m_fd, &m_offset)),
-                m_read_thread_manager(*m_decompressor, m_input_queue),
+                m_read_thread_manager(*m_decompressor, m_input_queue, m_counters.get(),
+                                      m_file.compression() == file_compression::none ? detail::pipeline_stage::read
+                                                                                     : detail::pipeline_stage::decompress),
                 m_osmdata_queue(detail::get_osmdata_queue_size(), "parser_results"),
                 m_osmdata_queue_wrapper(m_osmdata_queue) {
 
@@ -332,6 +465,12 @@ namespace osmium {
                 if (!m_pool) {
                     m_pool = &thread::Pool::default_instance();
                 }
+                m_decompressor->set_pool(*m_pool);
+
+                m_input_queue.set_max_bytes(m_max_queue_bytes > 0 ? m_max_queue_bytes
+                                                                  : osmium::config::get_max_queue_bytes("INPUT"));
+                m_osmdata_queue.set_max_bytes(m_max_queue_bytes > 0 ? m_max_queue_bytes
+                                                                    : osmium::config::get_max_queue_bytes("OSMDATA"));
 
                 std::promise<osmium::io::Header> header_promise;
                 m_header_future = header_promise.get_future();
@@ -346,7 +485,10 @@ namespace osmium {
                                                           std::ref(m_input_queue), std::ref(m_osmdata_queue),
                                                           std::move(header_promise), &m_offset, m_read_which_entities,
                                                           m_read_metadata, m_buffers_kind,
-                                                          m_decompressor->want_buffered_pages_removed()};
+                                                          m_decompressor->want_buffered_pages_removed(),
+                                                          m_read_mmap, m_blob_range, m_bbox, m_recycler,
+                                                          m_read_which_fields, m_read_metadata_options,
+                                                          m_tags_filter, m_read_order, m_counters};
             }
 
             template <typename... TArgs>
@@ -384,6 +526,12 @@ namespace osmium {
             void close() {
                 m_status = status::closed;
 
+                // Decoder tasks still in the pool must not use the
+                // recycler after this, it might be gone soon.
+                if (m_recycler) {
+                    m_recycler->detach();
+                }
+
                 m_read_thread_manager.stop();
 
                 m_osmdata_queue_wrapper.shutdown();
@@ -448,6 +596,7 @@ namespace osmium {
                 if (m_back_buffers) {
                     if (m_back_buffers.has_nested_buffers()) {
                         buffer = std::move(*m_back_buffers.get_last_nested());
+                        buffer.set_sequence(m_back_buffers.sequence());
                     } else {
                         buffer = std::move(m_back_buffers);
                         m_back_buffers = osmium::memory::Buffer{};
@@ -470,7 +619,10 @@ namespace osmium {
                     // without data is not an error, it just means we have to
                     // keep getting the next buffer until there is one with data.
                     while (true) {
-                        buffer = m_osmdata_queue_wrapper.pop();
+                        {
+                            const detail::stage_timer timer{m_counters.get(), detail::pipeline_stage::wait};
+                            buffer = m_osmdata_queue_wrapper.pop();
+                        }
                         if (detail::at_end_of_data(buffer)) {
                             m_status = status::eof;
                             m_read_thread_manager.close();
@@ -479,6 +631,7 @@ namespace osmium {
                         if (buffer.has_nested_buffers()) {
                             m_back_buffers = std::move(buffer);
                             buffer = std::move(*m_back_buffers.get_last_nested());
+                            buffer.set_sequence(m_back_buffers.sequence());
                         }
                         if (buffer.committed() > 0) {
                             return buffer;
@@ -525,6 +678,28 @@ namespace osmium {
                 return m_offset;
             }
 
+            /**
+             * Get statistics about the reading so far: Bytes read, time
+             * spent in the different stages of reading, and the state of
+             * the internal queues. This is cheap and can be called at any
+             * time from the thread using the Reader.
+             */
+            osmium::io::reader_stats stats() const {
+                osmium::io::reader_stats result;
+
+                // Decompressors keep the offset up to date. If the parser
+                // reads the file itself, it counts the bytes read.
+                result.bytes_read = m_decompressor->is_real() ? m_offset.load() : m_counters->bytes();
+                result.read_time = m_counters->time(detail::pipeline_stage::read);
+                result.decompress_time = m_counters->time(detail::pipeline_stage::decompress);
+                result.parse_time = m_counters->time(detail::pipeline_stage::parse);
+                result.wait_time = m_counters->time(detail::pipeline_stage::wait);
+                result.input_queue = m_input_queue.stats();
+                result.osmdata_queue = m_osmdata_queue.stats();
+
+                return result;
+            }
+
         }; // class Reader
 
         /**
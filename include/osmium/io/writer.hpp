@@ -40,7 +40,9 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/io/detail/write_thread.hpp>
 #include <osmium/io/error.hpp>
 #include <osmium/io/file.hpp>
+#include <osmium/io/file_format.hpp>
 #include <osmium/io/header.hpp>
+#include <osmium/io/pipeline_stats.hpp>
 #include <osmium/io/writer_options.hpp>
 #include <osmium/memory/buffer.hpp>
 #include <osmium/thread/pool.hpp>
@@ -105,6 +107,8 @@ namespace osmium {
 
             osmium::io::File m_file;
 
+            std::shared_ptr<detail::pipeline_counters> m_counters{std::make_shared<detail::pipeline_counters>()};
+
             detail::future_string_queue_type m_output_queue{detail::get_output_queue_size(), "raw_output"};
 
             std::unique_ptr<osmium::io::detail::OutputFormat> m_output{nullptr};
@@ -137,11 +141,15 @@ namespace osmium {
             static void write_thread(detail::future_string_queue_type& output_queue,
                                      std::unique_ptr<osmium::io::Compressor>&& compressor,
                                      std::promise<std::size_t>&& write_promise,
-                                     std::atomic_bool* notification) {
+                                     std::atomic_bool* notification,
+                                     detail::pipeline_counters* counters,
+                                     detail::pipeline_stage stage) {
                 detail::WriteThread write_thread{output_queue,
                                                  std::move(compressor),
                                                  std::move(write_promise),
-                                                 notification};
+                                                 notification,
+                                                 counters,
+                                                 stage};
                 write_thread();
             }
 
@@ -150,6 +158,7 @@ namespace osmium {
                     m_header.set("generator", "libosmium/" LIBOSMIUM_VERSION_STRING);
                 }
 
+                const detail::stage_timer timer{m_counters.get(), detail::pipeline_stage::encode};
                 m_output->write_header(m_header);
 
                 m_header_written = true;
@@ -160,6 +169,7 @@ namespace osmium {
                     write_header();
                 }
                 if (buffer && buffer.committed() > 0) {
+                    const detail::stage_timer timer{m_counters.get(), detail::pipeline_stage::encode};
                     m_output->write_buffer(std::move(buffer));
                 }
             }
@@ -177,6 +187,7 @@ namespace osmium {
                     using std::swap;
                     swap(m_buffer, buffer);
 
+                    const detail::stage_timer timer{m_counters.get(), detail::pipeline_stage::encode};
                     m_output->write_buffer(std::move(buffer));
                 }
             }
@@ -202,6 +213,7 @@ namespace osmium {
                 overwrite allow_overwrite = overwrite::no;
                 fsync sync = fsync::no;
                 osmium::thread::Pool* pool = nullptr;
+                std::size_t max_queue_bytes = 0;
             };
 
             static void set_option(options_type& options, osmium::thread::Pool& pool) {
@@ -220,11 +232,18 @@ namespace osmium {
                 options.sync = value;
             }
 
+            static void set_option(options_type& options, const osmium::io::max_queue_bytes& value) {
+                options.max_queue_bytes = value.bytes;
+            }
+
             void do_close() {
                 if (m_status == status::okay) {
                     ensure_cleanup([&]() {
                         do_write(std::move(m_buffer));
-                        m_output->write_end();
+                        {
+                            const detail::stage_timer timer{m_counters.get(), detail::pipeline_stage::encode};
+                            m_output->write_end();
+                        }
                         m_status = status::closed;
                         detail::add_end_of_data_to_queue(m_output_queue);
                     });
@@ -253,6 +272,11 @@ namespace osmium {
              *       before closing it? Can be osmium::io::fsync::yes or
              *       osmium::io::fsync::no (default).
              *
+             * * osmium::io::max_queue_bytes: Maximum number of bytes of
+             *       encoded data waiting to be written. The default is no
+             *       limit, or the limit set in the environment variable
+             *       OSMIUM_MAX_OUTPUT_QUEUE_MB.
+             *
              * * osmium::thread::Pool&: Reference to a thread pool that should
              *      be used for writing instead of the default pool. Usually
              *      it is okay to use the statically initialized shared
@@ -277,16 +301,25 @@ namespace osmium {
 
                 m_header = options.header;
 
+                m_output_queue.set_max_bytes(options.max_queue_bytes > 0 ? options.max_queue_bytes
+                                                                         : osmium::config::get_max_queue_bytes("OUTPUT"));
+
                 m_output = osmium::io::detail::OutputFormatFactory::instance().create_output(*options.pool, m_file, m_output_queue);
+                m_output->set_counters(m_counters);
 
                 std::unique_ptr<osmium::io::Compressor> compressor =
                     CompressionFactory::instance().create_compressor(file.compression(),
                                                                      osmium::io::detail::open_for_writing(m_file.filename(), options.allow_overwrite),
                                                                      options.sync);
+                compressor->set_pool(*options.pool);
+                compressor->set_options(m_file);
 
                 std::promise<std::size_t> write_promise;
                 m_write_future = write_promise.get_future();
-                m_thread = osmium::thread::thread_handler{write_thread, std::ref(m_output_queue), std::move(compressor), std::move(write_promise), &m_notification};
+                m_thread = osmium::thread::thread_handler{write_thread, std::ref(m_output_queue), std::move(compressor), std::move(write_promise), &m_notification,
+                                                          m_counters.get(),
+                                                          file.compression() == file_compression::none ? detail::pipeline_stage::write
+                                                                                                       : detail::pipeline_stage::compress};
             }
 
             template <typename... TArgs>
@@ -409,6 +442,25 @@ namespace osmium {
                 return 0;
             }
 
+            /**
+             * Get statistics about the writing so far: Bytes written, time
+             * spent in the different stages of writing, and the state of
+             * the output queue. This is cheap and can be called at any
+             * time from the thread using the Writer.
+             */
+            osmium::io::writer_stats stats() const {
+                osmium::io::writer_stats result;
+
+                result.bytes_written = m_counters->bytes();
+                result.encode_time = m_counters->time(detail::pipeline_stage::encode);
+                result.compress_time = m_counters->time(detail::pipeline_stage::compress);
+                result.write_time = m_counters->time(detail::pipeline_stage::write);
+                result.wait_time = m_counters->time(detail::pipeline_stage::wait);
+                result.output_queue = m_output_queue.stats();
+
+                return result;
+            }
+
         }; // class Writer
 
     } // namespace io
@@ -0,0 +1,356 @@
+#ifndef OSMIUM_IO_ZSTD_COMPRESSION_HPP
+#define OSMIUM_IO_ZSTD_COMPRESSION_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2023 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+/**
+ * @file
+ *
+ * Include this file if you want to read or write zstd-compressed OSM
+ * files.
+ *
+ * @attention If you include this file, you'll need to link with `libzstd`.
+ */
+
+#include <osmium/io/compression.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/error.hpp>
+#include <osmium/io/file_compression.hpp>
+#include <osmium/io/writer_options.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/options.hpp>
+
+#include <zstd.h>
+
+#include <cstddef>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+namespace osmium {
+
+    /**
+     * Exception thrown when there are problems compressing or
+     * decompressing zstd files.
+     */
+    struct zstd_error : public io_error {
+
+        std::size_t zstd_error_code = 0;
+
+        explicit zstd_error(const std::string& what) :
+            io_error(what) {
+        }
+
+        zstd_error(const std::string& what, const std::size_t error_code) :
+            io_error(what),
+            zstd_error_code(error_code) {
+        }
+
+    }; // struct zstd_error
+
+    namespace io {
+
+        namespace detail {
+
+            inline std::size_t check_zstd_result(const std::size_t result, const char* msg) {
+                if (::ZSTD_isError(result)) {
+                    std::string error{"zstd error: "};
+                    error += msg;
+                    error += ": ";
+                    error += ::ZSTD_getErrorName(result);
+                    throw osmium::zstd_error{error, result};
+                }
+                return result;
+            }
+
+        } // namespace detail
+
+        class ZstdCompressor final : public Compressor {
+
+            std::size_t m_file_size = 0;
+            int m_fd;
+            ZSTD_CCtx* m_cctx;
+            std::string m_output;
+            bool m_closed = false;
+
+            void compress(const char* data, const std::size_t size, const ZSTD_EndDirective mode) {
+                ZSTD_inBuffer input{data, size, 0};
+                std::size_t remaining = 0;
+                do {
+                    ZSTD_outBuffer output{&*m_output.begin(), m_output.size(), 0};
+                    remaining = detail::check_zstd_result(::ZSTD_compressStream2(m_cctx, &output, &input, mode), "compression failed");
+                    if (output.pos > 0) {
+                        osmium::io::detail::reliable_write(m_fd, m_output.data(), output.pos);
+                    }
+                } while (input.pos < input.size || (mode == ZSTD_e_end && remaining > 0));
+            }
+
+        public:
+
+            explicit ZstdCompressor(const int fd, const fsync sync) :
+                Compressor(sync),
+                m_fd(fd),
+                m_cctx(::ZSTD_createCCtx()),
+                m_output(::ZSTD_CStreamOutSize(), '\0') {
+                if (!m_cctx) {
+                    throw zstd_error{"zstd error: compression init failed"};
+                }
+            }
+
+            ZstdCompressor(const ZstdCompressor&) = delete;
+            ZstdCompressor& operator=(const ZstdCompressor&) = delete;
+
+            ZstdCompressor(ZstdCompressor&&) = delete;
+            ZstdCompressor& operator=(ZstdCompressor&&) = delete;
+
+            ~ZstdCompressor() noexcept override {
+                try {
+                    close();
+                } catch (...) {
+                    // Ignore any exceptions because destructor must not throw.
+                }
+                ::ZSTD_freeCCtx(m_cctx);
+            }
+
+            /**
+             * The option "zstd_level" sets the compression level.
+             *
+             * @throws std::invalid_argument If the level is invalid.
+             */
+            void set_options(const osmium::Options& options) override {
+                const auto level = options.get("zstd_level");
+                if (level.empty()) {
+                    return;
+                }
+
+                char* end_ptr = nullptr;
+                const auto val = std::strtol(level.c_str(), &end_ptr, 10);
+                if (*end_ptr != '\0' || val < ::ZSTD_minCLevel() || val > ::ZSTD_maxCLevel()) {
+                    throw std::invalid_argument{"The 'zstd_level' option must be an integer between " +
+                                                std::to_string(::ZSTD_minCLevel()) + " and " +
+                                                std::to_string(::ZSTD_maxCLevel()) + "."};
+                }
+                detail::check_zstd_result(::ZSTD_CCtx_setParameter(m_cctx, ZSTD_c_compressionLevel, static_cast<int>(val)), "setting compression level failed");
+            }
+
+            void write(const std::string& data) override {
+                if (!data.empty()) {
+                    compress(data.data(), data.size(), ZSTD_e_continue);
+                }
+            }
+
+            void close() override {
+                if (m_closed) {
+                    return;
+                }
+                m_closed = true;
+
+                // Do not sync or close stdout
+                osmium::io::detail::fd_close_guard guard{m_fd == 1 ? -1 : m_fd};
+
+                compress(nullptr, 0, ZSTD_e_end);
+
+                if (m_fd == 1) {
+                    return;
+                }
+
+                m_file_size = osmium::file_size(m_fd);
+
+                if (do_fsync()) {
+                    osmium::io::detail::reliable_fsync(m_fd);
+                }
+                osmium::io::detail::reliable_close(guard.release());
+            }
+
+            std::size_t file_size() const override {
+                return m_file_size;
+            }
+
+        }; // class ZstdCompressor
+
+        class ZstdDecompressor final : public Decompressor {
+
+            int m_fd;
+            ZSTD_DCtx* m_dctx;
+            std::string m_input;
+            ZSTD_inBuffer m_in{nullptr, 0, 0};
+            std::size_t m_offset = 0;
+
+            // Set when the last frame was decompressed completely.
+            bool m_frame_done = true;
+
+        public:
+
+            explicit ZstdDecompressor(const int fd) :
+                m_fd(fd),
+                m_dctx(::ZSTD_createDCtx()),
+                m_input(::ZSTD_DStreamInSize(), '\0') {
+                if (!m_dctx) {
+                    try {
+                        osmium::io::detail::reliable_close(fd);
+                    } catch (...) {
+                    }
+                    throw zstd_error{"zstd error: decompression init failed"};
+                }
+            }
+
+            ZstdDecompressor(const ZstdDecompressor&) = delete;
+            ZstdDecompressor& operator=(const ZstdDecompressor&) = delete;
+
+            ZstdDecompressor(ZstdDecompressor&&) = delete;
+            ZstdDecompressor& operator=(ZstdDecompressor&&) = delete;
+
+            ~ZstdDecompressor() noexcept override {
+                try {
+                    close();
+                } catch (...) {
+                    // Ignore any exceptions because destructor must not throw.
+                }
+                ::ZSTD_freeDCtx(m_dctx);
+            }
+
+            std::string read() override {
+                if (m_offset > 0 && want_buffered_pages_removed()) {
+                    osmium::io::detail::remove_buffered_pages(m_fd, m_offset);
+                }
+
+                std::string buffer(osmium::io::Decompressor::input_buffer_size, '\0');
+                ZSTD_outBuffer output{&*buffer.begin(), buffer.size(), 0};
+
+                while (output.pos < output.size) {
+                    if (m_in.pos == m_in.size) {
+                        // Return what we have before blocking on a read.
+                        if (output.pos > 0) {
+                            break;
+                        }
+                        const auto nread = osmium::io::detail::reliable_read(m_fd, &*m_input.begin(), static_cast<unsigned int>(m_input.size()));
+                        if (nread == 0) {
+                            if (!m_frame_done) {
+                                throw zstd_error{"zstd error: read failed: unexpected end of file"};
+                            }
+                            break;
+                        }
+                        m_in = ZSTD_inBuffer{m_input.data(), static_cast<std::size_t>(nread), 0};
+                        m_offset += static_cast<std::size_t>(nread);
+                    }
+                    m_frame_done = detail::check_zstd_result(::ZSTD_decompressStream(m_dctx, &output, &m_in), "read failed") == 0;
+                }
+
+                buffer.resize(output.pos);
+                set_offset(m_offset);
+
+                return buffer;
+            }
+
+            void close() override {
+                if (m_fd >= 0) {
+                    if (want_buffered_pages_removed()) {
+                        osmium::io::detail::remove_buffered_pages(m_fd);
+                    }
+                    const int fd = m_fd;
+                    m_fd = -1;
+                    osmium::io::detail::reliable_close(fd);
+                }
+            }
+
+        }; // class ZstdDecompressor
+
+        class ZstdBufferDecompressor final : public Decompressor {
+
+            ZSTD_DCtx* m_dctx;
+            ZSTD_inBuffer m_in;
+
+            // Set when the last frame was decompressed completely.
+            bool m_frame_done = true;
+
+        public:
+
+            ZstdBufferDecompressor(const char* buffer, const std::size_t size) :
+                m_dctx(::ZSTD_createDCtx()),
+                m_in{buffer, size, 0} {
+                if (!m_dctx) {
+                    throw zstd_error{"zstd error: decompression init failed"};
+                }
+            }
+
+            ZstdBufferDecompressor(const ZstdBufferDecompressor&) = delete;
+            ZstdBufferDecompressor& operator=(const ZstdBufferDecompressor&) = delete;
+
+            ZstdBufferDecompressor(ZstdBufferDecompressor&&) = delete;
+            ZstdBufferDecompressor& operator=(ZstdBufferDecompressor&&) = delete;
+
+            ~ZstdBufferDecompressor() noexcept override {
+                ::ZSTD_freeDCtx(m_dctx);
+            }
+
+            std::string read() override {
+                std::string buffer(osmium::io::Decompressor::input_buffer_size, '\0');
+                ZSTD_outBuffer output{&*buffer.begin(), buffer.size(), 0};
+
+                while (output.pos < output.size && m_in.pos < m_in.size) {
+                    m_frame_done = detail::check_zstd_result(::ZSTD_decompressStream(m_dctx, &output, &m_in), "decompression failed") == 0;
+                }
+                if (output.pos == 0 && !m_frame_done) {
+                    throw zstd_error{"zstd error: decompression failed: unexpected end of data"};
+                }
+
+                buffer.resize(output.pos);
+                return buffer;
+            }
+
+            void close() override {
+            }
+
+        }; // class ZstdBufferDecompressor
+
+        namespace detail {
+
+            // we want the register_compression() function to run, setting
+            // the variable is only a side-effect, it will never be used
+            const bool registered_zstd_compression = osmium::io::CompressionFactory::instance().register_compression(osmium::io::file_compression::zstd,
+                [](const int fd, const fsync sync) { return new osmium::io::ZstdCompressor{fd, sync}; },
+                [](const int fd) { return new osmium::io::ZstdDecompressor{fd}; },
+                [](const char* buffer, const std::size_t size) { return new osmium::io::ZstdBufferDecompressor{buffer, size}; }
+            );
+
+            // dummy function to silence the unused variable warning from above
+            inline bool get_registered_zstd_compression() noexcept {
+                return registered_zstd_compression;
+            }
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_ZSTD_COMPRESSION_HPP
@@ -109,6 +109,7 @@ namespace osmium {
             std::size_t m_capacity = 0;
             std::size_t m_written = 0;
             std::size_t m_committed = 0;
+            std::size_t m_sequence = 0;
 #ifndef NDEBUG
             uint8_t m_builder_count = 0;
 #endif
@@ -140,6 +141,7 @@ namespace osmium {
                 std::copy_n(old->data() + m_committed, m_written, m_data);
                 m_committed = 0;
 
+                old->m_sequence = m_sequence;
                 old->m_next_buffer = std::move(m_next_buffer);
                 m_next_buffer = std::move(old);
             }
@@ -265,6 +267,7 @@ namespace osmium {
                 m_capacity(other.m_capacity),
                 m_written(other.m_written),
                 m_committed(other.m_committed),
+                m_sequence(other.m_sequence),
 #ifndef NDEBUG
                 m_builder_count(other.m_builder_count),
 #endif
@@ -273,6 +276,7 @@ namespace osmium {
                 other.m_capacity = 0;
                 other.m_written = 0;
                 other.m_committed = 0;
+                other.m_sequence = 0;
 #ifndef NDEBUG
                 other.m_builder_count = 0;
 #endif
@@ -285,6 +289,7 @@ namespace osmium {
                 m_capacity = other.m_capacity;
                 m_written = other.m_written;
                 m_committed = other.m_committed;
+                m_sequence = other.m_sequence;
 #ifndef NDEBUG
                 m_builder_count = other.m_builder_count;
 #endif
@@ -293,6 +298,7 @@ namespace osmium {
                 other.m_capacity = 0;
                 other.m_written = 0;
                 other.m_committed = 0;
+                other.m_sequence = 0;
 #ifndef NDEBUG
                 other.m_builder_count = 0;
 #endif
@@ -351,6 +357,42 @@ namespace osmium {
                 return m_written;
             }
 
+            /**
+             * Does this buffer use internal memory management? Only those
+             * buffers can grow.
+             */
+            bool has_internal_memory() const noexcept {
+                return m_memory != nullptr;
+            }
+
+            /**
+             * Set whether this buffer should automatically grow when it
+             * becomes too small. This only makes sense for buffers with
+             * internal memory management.
+             */
+            void set_auto_grow(auto_grow value) noexcept {
+                m_auto_grow = value;
+            }
+
+            /**
+             * The sequence number of this buffer. The PBF parser sets this
+             * to the running number (starting at 1) of the data blob the
+             * buffer was decoded from. This can be used to restore the
+             * order of the buffers when reading with
+             * osmium::io::read_order::any. Buffers created in other ways
+             * have the sequence number 0.
+             */
+            std::size_t sequence() const noexcept {
+                return m_sequence;
+            }
+
+            /**
+             * Set the sequence number of this buffer.
+             */
+            void set_sequence(std::size_t sequence) noexcept {
+                m_sequence = sequence;
+            }
+
             /**
              * This tests if the current state of the buffer is aligned
              * properly. Can be used for asserts.
@@ -784,6 +826,7 @@ namespace osmium {
                 swap(m_capacity, other.m_capacity);
                 swap(m_written, other.m_written);
                 swap(m_committed, other.m_committed);
+                swap(m_sequence, other.m_sequence);
                 swap(m_auto_grow, other.m_auto_grow);
             }
 
@@ -0,0 +1,191 @@
+#ifndef OSMIUM_MEMORY_BUFFER_RECYCLER_HPP
+#define OSMIUM_MEMORY_BUFFER_RECYCLER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2023 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/memory/buffer.hpp>
+
+#include <cstddef>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace memory {
+
+        /**
+         * A thread-safe store for Buffers that are not needed any more so
+         * that their memory can be reused instead of being freed and
+         * allocated again.
+         *
+         * Give the recycler to the Reader as option and put() the buffers
+         * you got from the Reader into the recycler once you are done with
+         * them. The decoder threads will get() them from there.
+         */
+        class BufferRecycler {
+
+            mutable std::mutex m_mutex{};
+            std::vector<Buffer> m_buffers{};
+            std::size_t m_max_buffers;
+
+            void put_single(Buffer&& buffer) {
+                if (!buffer || !buffer.has_internal_memory()) {
+                    return;
+                }
+
+                buffer.clear();
+
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                if (m_buffers.size() < m_max_buffers) {
+                    m_buffers.push_back(std::move(buffer));
+                }
+            }
+
+        public:
+
+            enum {
+                default_max_buffers = 16
+            };
+
+            /**
+             * Create a recycler.
+             *
+             * @param max_buffers Maximum number of buffers kept for reuse.
+             *                    Further buffers put into the recycler
+             *                    will be freed.
+             */
+            explicit BufferRecycler(std::size_t max_buffers = default_max_buffers) :
+                m_max_buffers(max_buffers) {
+            }
+
+            BufferRecycler(const BufferRecycler&) = delete;
+            BufferRecycler& operator=(const BufferRecycler&) = delete;
+
+            BufferRecycler(BufferRecycler&&) = delete;
+            BufferRecycler& operator=(BufferRecycler&&) = delete;
+
+            ~BufferRecycler() noexcept = default;
+
+            /**
+             * Get an empty buffer with at least the given capacity. This is
+             * a previously used buffer if there is one, otherwise a new
+             * buffer is created.
+             *
+             * @param capacity Minimum capacity of the buffer.
+             * @param auto_grow Auto-grow setting for the buffer.
+             */
+            Buffer get(std::size_t capacity, Buffer::auto_grow auto_grow = Buffer::auto_grow::yes) {
+                Buffer buffer;
+                {
+                    const std::lock_guard<std::mutex> lock{m_mutex};
+                    if (!m_buffers.empty()) {
+                        buffer = std::move(m_buffers.back());
+                        m_buffers.pop_back();
+                    }
+                }
+
+                if (!buffer) {
+                    return Buffer{capacity, auto_grow};
+                }
+
+                buffer.set_auto_grow(auto_grow);
+                buffer.grow(capacity);
+                return buffer;
+            }
+
+            /**
+             * Put a buffer that is not needed any more into the recycler.
+             * Nested buffers are recycled, too. Invalid buffers or buffers
+             * without internal memory management are ignored.
+             */
+            void put(Buffer&& buffer) {
+                while (buffer && buffer.has_nested_buffers()) {
+                    put_single(std::move(*buffer.get_last_nested()));
+                }
+                put_single(std::move(buffer));
+            }
+
+            /// The number of buffers currently available for reuse.
+            std::size_t size() const {
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                return m_buffers.size();
+            }
+
+        }; // class BufferRecycler
+
+        namespace detail {
+
+            /**
+             * Access to a BufferRecycler that can be cut off. The Reader
+             * shares this with its decoder tasks and detaches it when it
+             * is closed, so tasks still running in the pool after that
+             * don't use the recycler which might not exist any more.
+             */
+            class recycler_handle {
+
+                std::mutex m_mutex{};
+                BufferRecycler* m_recycler;
+
+            public:
+
+                explicit recycler_handle(BufferRecycler& recycler) noexcept :
+                    m_recycler(&recycler) {
+                }
+
+                /**
+                 * Get a buffer from the recycler or a new buffer if the
+                 * handle was detached.
+                 */
+                Buffer get(std::size_t capacity, Buffer::auto_grow auto_grow = Buffer::auto_grow::yes) {
+                    const std::lock_guard<std::mutex> lock{m_mutex};
+                    if (m_recycler) {
+                        return m_recycler->get(capacity, auto_grow);
+                    }
+                    return Buffer{capacity, auto_grow};
+                }
+
+                void detach() {
+                    const std::lock_guard<std::mutex> lock{m_mutex};
+                    m_recycler = nullptr;
+                }
+
+            }; // class recycler_handle
+
+        } // namespace detail
+
+    } // namespace memory
+
+} // namespace osmium
+
+#endif // OSMIUM_MEMORY_BUFFER_RECYCLER_HPP
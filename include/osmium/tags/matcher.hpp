@@ -97,6 +97,15 @@ namespace osmium {
             m_result(!invert) {
         }
 
+        /**
+         * Match only the key against the key matcher.
+         *
+         * @returns true if a tag with this key can match.
+         */
+        bool match_key(const char* key) const noexcept {
+            return m_key_matcher(key);
+        }
+
         /**
          * Match against the specified key and value.
          *
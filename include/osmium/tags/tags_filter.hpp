@@ -124,14 +124,52 @@ namespace osmium {
          *          matched, the default result.
          */
         TResult operator()(const osmium::Tag& tag) const noexcept {
+            return operator()(tag.key(), tag.value());
+        }
+
+        /**
+         * Matching function. Check the specified key and value against
+         * the rules.
+         *
+         * @param key The key of a tag.
+         * @param value The value of a tag.
+         * @returns The result of the matching rule, or, if none of the rules
+         *          matched, the default result.
+         */
+        TResult operator()(const char* key, const char* value) const noexcept {
             for (const auto& rule : m_rules) {
-                if (rule.second(tag)) {
+                if (rule.second(key, value)) {
                     return rule.first;
                 }
             }
             return m_default_result;
         }
 
+        /**
+         * Check only the key against the rules. This can be used to find
+         * out whether tags with some key can match at all before looking
+         * at the values.
+         *
+         * @param key The key of a tag.
+         * @param result Set to the result of the filter if it is the same
+         *               for all tags with this key.
+         * @returns true if the result is the same for all tags with this
+         *          key, false if it depends on the value.
+         */
+        bool match_key(const char* key, TResult& result) const noexcept {
+            for (const auto& rule : m_rules) {
+                if (rule.second.match_key(key)) {
+                    if (rule.second.has_value_matcher()) {
+                        return false;
+                    }
+                    result = rule.first;
+                    return true;
+                }
+            }
+            result = m_default_result;
+            return true;
+        }
+
         /**
          * Return the number of rules in this filter.
          *
@@ -34,12 +34,18 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <osmium/thread/function_wrapper.hpp>
-#include <osmium/thread/queue.hpp>
 #include <osmium/thread/util.hpp>
 #include <osmium/util/config.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstddef>
+#include <deque>
 #include <future>
+#include <memory>
+#include <mutex>
 #include <thread>
 #include <type_traits>
 #include <utility>
@@ -55,7 +61,8 @@ namespace osmium {
         namespace detail {
 
             // Maximum number of allowed pool threads (just to keep the user
-            // from setting something silly).
+            // from setting something silly). On machines with more cores
+            // the number of cores is the maximum.
             enum {
                 max_pool_threads = 32
             };
@@ -69,10 +76,11 @@ namespace osmium {
                     num_threads += int(hardware_concurrency);
                 }
 
+                const int max_threads = std::max(int(max_pool_threads), int(hardware_concurrency));
                 if (num_threads < 1) {
                     num_threads = 1;
-                } else if (num_threads > max_pool_threads) {
-                    num_threads = max_pool_threads;
+                } else if (num_threads > max_threads) {
+                    num_threads = max_threads;
                 }
 
                 return num_threads;
@@ -82,10 +90,52 @@ namespace osmium {
                 return osmium::config::get_max_queue_size("WORK", 10);
             }
 
+            /**
+             * The queue of tasks of a single worker thread. Other workers
+             * can steal tasks from it when they have nothing to do. Each
+             * queue has its own mutex, so threads only contend for it when
+             * they submit to or steal from the same queue at the same time.
+             */
+            class work_queue {
+
+                mutable std::mutex m_mutex;
+                std::deque<function_wrapper> m_tasks;
+
+            public:
+
+                void push(function_wrapper&& task) {
+                    const std::lock_guard<std::mutex> lock{m_mutex};
+                    m_tasks.push_back(std::move(task));
+                }
+
+                /**
+                 * Take the oldest task from the queue. This is used by the
+                 * owner of the queue as well as by other workers stealing
+                 * from it, so tasks are run roughly in the order they were
+                 * submitted. This is important for users like the Reader
+                 * which wait for the results in this order.
+                 */
+                bool try_pop(function_wrapper& task) {
+                    const std::lock_guard<std::mutex> lock{m_mutex};
+                    if (m_tasks.empty()) {
+                        return false;
+                    }
+                    task = std::move(m_tasks.front());
+                    m_tasks.pop_front();
+                    return true;
+                }
+
+            }; // class work_queue
+
         } // namespace detail
 
         /**
          *  Thread pool.
+         *
+         *  Every worker thread has its own queue of tasks. Tasks submitted
+         *  from a worker thread go into its own queue, all other tasks are
+         *  distributed round-robin over all queues. Workers without tasks
+         *  in their own queue steal tasks from the other queues.
          */
         class Pool {
 
@@ -119,24 +169,119 @@ namespace osmium {
 
             }; // class thread_joiner
 
-            osmium::thread::Queue<function_wrapper> m_work_queue;
+            // Set for the worker threads of a pool so that tasks they submit
+            // go into their own queue.
+            struct worker_info {
+                const Pool* pool = nullptr;
+                std::size_t index = 0;
+            };
+
+            static worker_info& this_worker() noexcept {
+                static thread_local worker_info info;
+                return info;
+            }
+
+            std::size_t m_max_queue_size;
+            int m_num_threads;
+            std::vector<std::unique_ptr<detail::work_queue>> m_queues{};
+
+            // Number of tasks in all queues
+            std::atomic<std::size_t> m_queued{0};
+
+            // Used for round-robin distribution of tasks over the queues
+            std::atomic<std::size_t> m_next_queue{0};
+
+            // Number of workers waiting for new tasks
+            std::atomic<int> m_sleeping{0};
+
+            std::atomic<bool> m_shutdown{false};
+
+            // Only used for putting idle workers and, if the queues are
+            // full, submitting threads to sleep.
+            std::mutex m_wait_mutex;
+            std::condition_variable m_work_available;
+            std::condition_variable m_space_available;
+
             std::vector<std::thread> m_threads{};
             thread_joiner m_joiner;
-            int m_num_threads;
 
-            void worker_thread() {
+            bool find_task(std::size_t index, function_wrapper& task) {
+                if (m_queues[index]->try_pop(task)) {
+                    return true;
+                }
+                for (std::size_t i = 1; i < m_queues.size(); ++i) {
+                    if (m_queues[(index + i) % m_queues.size()]->try_pop(task)) {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            void wait_for_work() {
+                std::unique_lock<std::mutex> lock{m_wait_mutex};
+                ++m_sleeping;
+                m_work_available.wait(lock, [this] {
+                    return m_queued > 0 || m_shutdown;
+                });
+                --m_sleeping;
+            }
+
+            void worker_thread(std::size_t index) {
                 osmium::thread::set_thread_name("_osmium_worker");
+                this_worker().pool = this;
+                this_worker().index = index;
+
                 while (true) {
                     function_wrapper task;
-                    m_work_queue.wait_and_pop(task);
-                    if (task && task()) {
-                        // The called tasks returns true only when the
-                        // worker thread should shut down.
-                        return;
+                    if (find_task(index, task)) {
+                        if (m_queued-- >= m_max_queue_size) {
+                            m_space_available.notify_all();
+                        }
+                        task();
+                    } else if (m_queued == 0) {
+                        if (m_shutdown) {
+                            return;
+                        }
+                        wait_for_work();
+                    } else {
+                        // A task was counted but not pushed yet
+                        std::this_thread::yield();
                     }
                 }
             }
 
+            void push_task(function_wrapper&& task) {
+                const auto& worker = this_worker();
+                const bool from_worker = worker.pool == this;
+
+                // Workers never wait for space in the queues, if all of them
+                // did, nobody would be left to empty the queues.
+                if (!from_worker && m_max_queue_size > 0) {
+                    constexpr const std::chrono::milliseconds max_wait{10};
+                    while (m_queued >= m_max_queue_size) {
+                        std::unique_lock<std::mutex> lock{m_wait_mutex};
+                        m_space_available.wait_for(lock, max_wait, [this] {
+                            return m_queued < m_max_queue_size;
+                        });
+                    }
+                }
+
+                const std::size_t index = from_worker ? worker.index
+                                                      : m_next_queue++ % m_queues.size();
+                ++m_queued;
+                m_queues[index]->push(std::move(task));
+
+                // Only take the lock if there is a worker to wake up. The
+                // lock makes sure the notification doesn't get lost while
+                // the worker is about to go to sleep.
+                if (m_sleeping > 0) {
+                    {
+                        const std::lock_guard<std::mutex> lock{m_wait_mutex};
+                    }
+                    m_work_available.notify_one();
+                }
+            }
+
         public:
 
             enum {
@@ -158,18 +303,24 @@ namespace osmium {
              * given number, ie it will leave a number of cores unused.
              *
              * In all cases the minimum number of threads in the pool is 1.
+             * The maximum is 32 or the number of cores, whichever is larger.
              *
-             * If max_queue_size is 0, the queue size is read from
+             * The max_queue_size is the maximum number of tasks waiting in
+             * all queues together. If it is 0, the queue size is read from
              * the environment variable OSMIUM_MAX_WORK_QUEUE_SIZE.
              */
             explicit Pool(int num_threads = default_num_threads, std::size_t max_queue_size = default_queue_size) :
-                m_work_queue(max_queue_size > 0 ? max_queue_size : detail::get_work_queue_size(), "work"),
-                m_joiner(m_threads),
-                m_num_threads(detail::get_pool_size(num_threads, osmium::config::get_pool_threads(), std::thread::hardware_concurrency())) {
+                m_max_queue_size(max_queue_size > 0 ? max_queue_size : detail::get_work_queue_size()),
+                m_num_threads(detail::get_pool_size(num_threads, osmium::config::get_pool_threads(), std::thread::hardware_concurrency())),
+                m_joiner(m_threads) {
+
+                for (int i = 0; i < m_num_threads; ++i) {
+                    m_queues.emplace_back(new detail::work_queue{});
+                }
 
                 try {
                     for (int i = 0; i < m_num_threads; ++i) {
-                        m_threads.emplace_back(&Pool::worker_thread, this);
+                        m_threads.emplace_back(&Pool::worker_thread, this, static_cast<std::size_t>(i));
                     }
                 } catch (...) {
                     shutdown_all_workers();
@@ -188,11 +339,15 @@ namespace osmium {
                 return pool;
             }
 
+            /**
+             * Tell all workers to shut down once all queued tasks are done.
+             */
             void shutdown_all_workers() {
-                for (int i = 0; i < m_num_threads; ++i) {
-                    // The special function wrapper makes a worker shut down.
-                    m_work_queue.push(function_wrapper{0});
+                {
+                    const std::lock_guard<std::mutex> lock{m_wait_mutex};
+                    m_shutdown = true;
                 }
+                m_work_available.notify_all();
             }
 
             Pool(const Pool&) = delete;
@@ -210,11 +365,11 @@ namespace osmium {
             }
 
             std::size_t queue_size() const {
-                return m_work_queue.size();
+                return m_queued;
             }
 
             bool queue_empty() const {
-                return m_work_queue.empty();
+                return m_queued == 0;
             }
 
 #if defined(__cpp_lib_is_invocable) && __cpp_lib_is_invocable >= 201703
@@ -232,7 +387,7 @@ namespace osmium {
             std::future<submit_func_result_type<TFunction>> submit(TFunction&& func) {
                 std::packaged_task<submit_func_result_type<TFunction>()> task{std::forward<TFunction>(func)};
                 std::future<submit_func_result_type<TFunction>> future_result{task.get_future()};
-                m_work_queue.push(std::move(task));
+                push_task(std::move(task));
 
                 return future_result;
             }
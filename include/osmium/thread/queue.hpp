@@ -33,6 +33,8 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/thread/queue_stats.hpp>
+
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
@@ -63,9 +65,17 @@ namespace osmium {
             /// Name of this queue (for debugging only).
             const std::string m_name;
 
+            /// Maximum number of bytes of payload in this queue. If this
+            /// is exceeded pushing to the queue will block. 0 if unlimited.
+            std::atomic<std::size_t> m_max_bytes{0};
+
             mutable std::mutex m_mutex;
 
-            std::queue<T> m_queue;
+            /// The elements in the queue with their payload size in bytes.
+            std::queue<std::pair<T, std::size_t>> m_queue;
+
+            /// Sum of the payload sizes of all elements in the queue.
+            std::size_t m_bytes = 0;
 
             /// Used to signal consumers when data is available in the queue.
             std::condition_variable m_data_available;
@@ -75,27 +85,15 @@ namespace osmium {
 
             std::atomic<bool> m_in_use{true};
 
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
-            /// The largest size the queue has been so far.
-            std::size_t m_largest_size;
-
-            /// The number of times push() was called on the queue.
-            std::atomic<int> m_push_counter;
-
-            /// The number of times the queue was full and a thread pushing
-            /// to the queue was blocked.
-            std::atomic<int> m_full_counter;
+            /// Usage counters, only changed while holding the mutex.
+            queue_stats m_stats;
 
-            /**
-             * The number of times wait_and_pop(with_timeout)() was called
-             * on the queue.
-             */
-            std::atomic<int> m_pop_counter;
-
-            /// The number of times the queue was full and a thread pushing
-            /// to the queue was blocked.
-            std::atomic<int> m_empty_counter;
-#endif
+            bool is_full_locked(std::size_t bytes) const noexcept {
+                if (m_max_size && m_queue.size() >= m_max_size) {
+                    return true;
+                }
+                return m_max_bytes && !m_queue.empty() && m_bytes + bytes > m_max_bytes;
+            }
 
         public:
 
@@ -109,16 +107,8 @@ namespace osmium {
             explicit Queue(std::size_t max_size = 0, std::string name = "") :
                 m_max_size(max_size),
                 m_name(std::move(name)),
-                m_queue()
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
-                ,
-                m_largest_size(0),
-                m_push_counter(0),
-                m_full_counter(0),
-                m_pop_counter(0),
-                m_empty_counter(0)
-#endif
-            {
+                m_queue() {
+                m_stats.max_size = m_max_size;
             }
 
             Queue(const Queue&) = delete;
@@ -131,89 +121,100 @@ namespace osmium {
             ~Queue() {
                 std::cerr << "queue '" << m_name
                           << "' with max_size=" << m_max_size
-                          << " had largest size " << m_largest_size
-                          << " and was full " << m_full_counter
-                          << " times in " << m_push_counter
-                          << " push() calls and was empty " << m_empty_counter
-                          << " times in " << m_pop_counter
+                          << " had largest size " << m_stats.largest_size
+                          << " and was full " << m_stats.full_count
+                          << " times in " << m_stats.push_count
+                          << " push() calls and was empty " << m_stats.empty_count
+                          << " times in " << m_stats.pop_count
                           << " pop() calls\n";
             }
 #else
             ~Queue() = default;
 #endif
 
+            /**
+             * Set the maximum number of bytes of payload in this queue.
+             * Set to 0 for no limit (the default). This can be changed
+             * while the queue is in use, a lower limit only takes effect
+             * for elements pushed afterwards.
+             */
+            void set_max_bytes(std::size_t max_bytes) noexcept {
+                m_max_bytes = max_bytes;
+            }
+
+            std::size_t max_bytes() const noexcept {
+                return m_max_bytes;
+            }
+
             /**
              * Push an element onto the queue. If the queue has a max size,
              * this call will block if the queue is full.
+             *
+             * @param value The element.
+             * @param bytes Size of the payload of this element. If the
+             *              queue has a maximum number of bytes set, this
+             *              call will block until the element fits. An
+             *              element is always accepted into an empty
+             *              queue, regardless of its size.
              */
-            void push(T value) {
+            void push(T value, std::size_t bytes = 0) {
                 if (!m_in_use) {
                     return;
                 }
                 constexpr const std::chrono::milliseconds max_wait{10};
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
-                ++m_push_counter;
-#endif
-                if (m_max_size) {
-                    while (size() >= m_max_size) {
-                        std::unique_lock<std::mutex> lock{m_mutex};
-                        m_space_available.wait_for(lock, max_wait, [this] {
-                            return m_queue.size() < m_max_size;
-                        });
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
-                        ++m_full_counter;
-#endif
+                std::unique_lock<std::mutex> lock{m_mutex};
+                if ((m_max_size || m_max_bytes) && is_full_locked(bytes)) {
+                    ++m_stats.full_count;
+                    const auto start = std::chrono::steady_clock::now();
+                    while (is_full_locked(bytes)) {
+                        m_space_available.wait_for(lock, max_wait);
                     }
+                    m_stats.push_wait_time += std::chrono::steady_clock::now() - start;
                 }
-                const std::lock_guard<std::mutex> lock{m_mutex};
-                m_queue.push(std::move(value));
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
-                if (m_largest_size < m_queue.size()) {
-                    m_largest_size = m_queue.size();
+                m_queue.emplace(std::move(value), bytes);
+                m_bytes += bytes;
+                ++m_stats.push_count;
+                if (m_stats.largest_size < m_queue.size()) {
+                    m_stats.largest_size = m_queue.size();
                 }
-#endif
                 m_data_available.notify_one();
             }
 
             void wait_and_pop(T& value) {
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
-                ++m_pop_counter;
-#endif
                 std::unique_lock<std::mutex> lock{m_mutex};
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
+                ++m_stats.pop_count;
                 if (m_queue.empty()) {
-                    ++m_empty_counter;
+                    ++m_stats.empty_count;
+                    const auto start = std::chrono::steady_clock::now();
+                    m_data_available.wait(lock, [this] {
+                        return !m_in_use || !m_queue.empty();
+                    });
+                    m_stats.pop_wait_time += std::chrono::steady_clock::now() - start;
                 }
-#endif
-                m_data_available.wait(lock, [this] {
-                    return !m_in_use || !m_queue.empty();
-                });
                 if (!m_queue.empty()) {
-                    value = std::move(m_queue.front());
+                    value = std::move(m_queue.front().first);
+                    m_bytes -= m_queue.front().second;
                     m_queue.pop();
                     lock.unlock();
-                    if (m_max_size) {
+                    if (m_max_size || m_max_bytes) {
                         m_space_available.notify_one();
                     }
                 }
             }
 
             bool try_pop(T& value) {
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
-                ++m_pop_counter;
-#endif
                 {
                     const std::lock_guard<std::mutex> lock{m_mutex};
+                    ++m_stats.pop_count;
                     if (m_queue.empty()) {
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
-                        ++m_empty_counter;
-#endif
+                        ++m_stats.empty_count;
                         return false;
                     }
-                    value = std::move(m_queue.front());
+                    value = std::move(m_queue.front().first);
+                    m_bytes -= m_queue.front().second;
                     m_queue.pop();
                 }
-                if (m_max_size) {
+                if (m_max_size || m_max_bytes) {
                     m_space_available.notify_one();
                 }
                 return true;
@@ -229,6 +230,24 @@ namespace osmium {
                 return m_queue.size();
             }
 
+            /**
+             * The sum of the payload sizes of all elements in the queue.
+             */
+            std::size_t bytes() const {
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                return m_bytes;
+            }
+
+            /**
+             * Get a snapshot of the usage counters of this queue.
+             */
+            queue_stats stats() const {
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                queue_stats result{m_stats};
+                result.size = m_queue.size();
+                return result;
+            }
+
             bool in_use() const noexcept {
                 return m_in_use;
             }
@@ -239,6 +258,7 @@ namespace osmium {
                 while (!m_queue.empty()) {
                     m_queue.pop();
                 }
+                m_bytes = 0;
                 m_data_available.notify_all();
             }
 
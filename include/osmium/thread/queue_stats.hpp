@@ -0,0 +1,87 @@
+#ifndef OSMIUM_THREAD_QUEUE_STATS_HPP
+#define OSMIUM_THREAD_QUEUE_STATS_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2023 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace osmium {
+
+    namespace thread {
+
+        /**
+         * Counters describing how a Queue or SPSCQueue has been used so
+         * far. They are always collected, because the queues only need to
+         * update them while holding a lock or from the single thread
+         * owning that side of the queue. The clock is only read when a
+         * thread actually has to wait.
+         */
+        struct queue_stats {
+
+            /// Maximum number of elements in the queue (0 if unlimited).
+            std::size_t max_size = 0;
+
+            /// Number of elements in the queue right now.
+            std::size_t size = 0;
+
+            /// The largest number of elements the queue has held so far.
+            std::size_t largest_size = 0;
+
+            /// Number of elements pushed onto the queue.
+            std::uint64_t push_count = 0;
+
+            /// Number of times a producer had to wait because the queue
+            /// was full.
+            std::uint64_t full_count = 0;
+
+            /// Number of calls to wait_and_pop() and try_pop().
+            std::uint64_t pop_count = 0;
+
+            /// Number of times the queue was empty when popping.
+            std::uint64_t empty_count = 0;
+
+            /// Total time producers were blocked in push().
+            std::chrono::nanoseconds push_wait_time{0};
+
+            /// Total time consumers were blocked in wait_and_pop().
+            std::chrono::nanoseconds pop_wait_time{0};
+
+        }; // struct queue_stats
+
+    } // namespace thread
+
+} // namespace osmium
+
+#endif // OSMIUM_THREAD_QUEUE_STATS_HPP
@@ -0,0 +1,362 @@
+#ifndef OSMIUM_THREAD_SPSC_QUEUE_HPP
+#define OSMIUM_THREAD_SPSC_QUEUE_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2023 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/thread/queue_stats.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility> // IWYU pragma: keep
+#include <vector>
+
+#ifdef OSMIUM_DEBUG_QUEUE_SIZE
+# include <iostream>
+#endif
+
+namespace osmium {
+
+    namespace thread {
+
+        /**
+         * A bounded queue for exactly one producer thread and one consumer
+         * thread. It has the same interface and blocking behaviour as
+         * osmium::thread::Queue, but it is implemented as a ring buffer
+         * with atomic indexes, so push() and pop() don't need a lock as
+         * long as the queue is neither empty nor full. The mutex is only
+         * used to put the producer or consumer to sleep and wake it up.
+         *
+         * Only one thread may call push(), and only one (other) thread may
+         * call wait_and_pop(), try_pop(), and shutdown().
+         */
+        template <typename T>
+        class SPSCQueue {
+
+            enum {
+                cache_line_size = 64,
+
+                // Size used if 0 is given as max size in the constructor.
+                default_max_size = 1024
+            };
+
+            /// Maximum size of this queue. If the queue is full pushing to
+            /// the queue will block.
+            const std::size_t m_max_size;
+
+            /// Name of this queue (for debugging only).
+            const std::string m_name;
+
+            /// Maximum number of bytes of payload in this queue. If this
+            /// is exceeded pushing to the queue will block. 0 if unlimited.
+            std::atomic<std::size_t> m_max_bytes{0};
+
+            std::vector<T> m_slots;
+
+            /// Payload size of the element in the slot with the same index.
+            std::vector<std::size_t> m_slot_bytes;
+
+            /// Sum of the payload sizes of all elements in the queue.
+            std::atomic<std::size_t> m_bytes{0};
+
+            // The indexes are padded so that they are in different cache
+            // lines and the producer and consumer don't slow each other
+            // down when updating them.
+            struct padded_index {
+                std::atomic<std::size_t> value{0};
+                char padding[cache_line_size - sizeof(std::atomic<std::size_t>)];
+            };
+
+            // Index of the next element to pop. Only changed by the consumer.
+            padded_index m_head;
+
+            // Index of the next element to push. Only changed by the producer.
+            padded_index m_tail;
+
+            std::mutex m_mutex;
+
+            /// Used to signal the consumer when data is available in the queue.
+            std::condition_variable m_data_available;
+
+            /// Used to signal the producer when queue is not full.
+            std::condition_variable m_space_available;
+
+            std::atomic<bool> m_consumer_waiting{false};
+            std::atomic<bool> m_producer_waiting{false};
+
+            std::atomic<bool> m_in_use{true};
+
+            // Usage counters. Each side only updates its own counters,
+            // so they are padded like the indexes. They are atomic only
+            // so that stats() can read them from any thread.
+            struct padded_counters {
+                std::atomic<std::uint64_t> calls{0};
+                std::atomic<std::uint64_t> waits{0};
+                std::atomic<std::uint64_t> wait_ns{0};
+                std::atomic<std::size_t> largest_size{0}; // only used by the producer
+                char padding[cache_line_size - 3 * sizeof(std::atomic<std::uint64_t>) - sizeof(std::atomic<std::size_t>)];
+            };
+
+            padded_counters m_producer_stats;
+            padded_counters m_consumer_stats;
+
+            // Only one thread writes each counter, so it doesn't need an
+            // atomic read-modify-write operation.
+            template <typename TValue>
+            static void add_to(std::atomic<TValue>& counter, TValue value) noexcept {
+                counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+            }
+
+            static std::uint64_t elapsed_ns(std::chrono::steady_clock::time_point start) noexcept {
+                return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+            }
+
+            bool has_space(std::size_t bytes) const noexcept {
+                const std::size_t current_size = size();
+                if (current_size >= m_max_size) {
+                    return false;
+                }
+                return m_max_bytes == 0 || current_size == 0 || m_bytes + bytes <= m_max_bytes;
+            }
+
+            // Wake up the other side if it is waiting. Taking the lock
+            // makes sure the notification can't get lost between the other
+            // side checking the condition and going to sleep.
+            void notify(const std::atomic<bool>& waiting, std::condition_variable& condition) {
+                if (waiting) {
+                    {
+                        const std::lock_guard<std::mutex> lock{m_mutex};
+                    }
+                    condition.notify_one();
+                }
+            }
+
+            void pop_front(T& value) {
+                const std::size_t head = m_head.value.load(std::memory_order_relaxed);
+                value = std::move(m_slots[head % m_max_size]);
+                m_slots[head % m_max_size] = T{};
+                m_bytes -= m_slot_bytes[head % m_max_size];
+                m_head.value = head + 1;
+                notify(m_producer_waiting, m_space_available);
+            }
+
+        public:
+
+            /**
+             * Construct a single-producer single-consumer queue.
+             *
+             * @param max_size Maximum number of elements in the queue. If
+             *                 this is 0, a default size is used. (Unlike
+             *                 osmium::thread::Queue this queue can not
+             *                 be unbounded.)
+             * @param name Optional name for this queue. (Used for debugging.)
+             */
+            explicit SPSCQueue(std::size_t max_size = 0, std::string name = "") :
+                m_max_size(max_size > 0 ? max_size : static_cast<std::size_t>(default_max_size)),
+                m_name(std::move(name)),
+                m_slots(m_max_size),
+                m_slot_bytes(m_max_size) {
+            }
+
+            SPSCQueue(const SPSCQueue&) = delete;
+            SPSCQueue& operator=(const SPSCQueue&) = delete;
+
+            SPSCQueue(SPSCQueue&&) = delete;
+            SPSCQueue& operator=(SPSCQueue&&) = delete;
+
+#ifdef OSMIUM_DEBUG_QUEUE_SIZE
+            ~SPSCQueue() {
+                std::cerr << "queue '" << m_name
+                          << "' with max_size=" << m_max_size
+                          << " had largest size " << m_producer_stats.largest_size
+                          << " and was full " << m_producer_stats.waits
+                          << " times in " << m_producer_stats.calls
+                          << " push() calls and was empty " << m_consumer_stats.waits
+                          << " times in " << m_consumer_stats.calls
+                          << " pop() calls\n";
+            }
+#else
+            ~SPSCQueue() = default;
+#endif
+
+            /**
+             * Set the maximum number of bytes of payload in this queue.
+             * Set to 0 for no limit (the default). This can be changed
+             * while the queue is in use, a lower limit only takes effect
+             * for elements pushed afterwards.
+             */
+            void set_max_bytes(std::size_t max_bytes) noexcept {
+                m_max_bytes = max_bytes;
+            }
+
+            std::size_t max_bytes() const noexcept {
+                return m_max_bytes;
+            }
+
+            /**
+             * Push an element onto the queue. If the queue is full, this
+             * call will block.
+             *
+             * @param value The element.
+             * @param bytes Size of the payload of this element. If the
+             *              queue has a maximum number of bytes set, this
+             *              call will block until the element fits. An
+             *              element is always accepted into an empty
+             *              queue, regardless of its size.
+             */
+            void push(T value, std::size_t bytes = 0) {
+                if (!m_in_use) {
+                    return;
+                }
+                if (!has_space(bytes)) {
+                    add_to(m_producer_stats.waits, std::uint64_t{1});
+                    const auto start = std::chrono::steady_clock::now();
+                    std::unique_lock<std::mutex> lock{m_mutex};
+                    m_producer_waiting = true;
+                    m_space_available.wait(lock, [this, bytes] {
+                        return has_space(bytes) || !m_in_use;
+                    });
+                    m_producer_waiting = false;
+                    add_to(m_producer_stats.wait_ns, elapsed_ns(start));
+                    if (!m_in_use) {
+                        return;
+                    }
+                }
+
+                const std::size_t tail = m_tail.value.load(std::memory_order_relaxed);
+                m_slots[tail % m_max_size] = std::move(value);
+                m_slot_bytes[tail % m_max_size] = bytes;
+                m_bytes += bytes;
+                m_tail.value = tail + 1;
+                add_to(m_producer_stats.calls, std::uint64_t{1});
+                const std::size_t current_size = size();
+                if (m_producer_stats.largest_size.load(std::memory_order_relaxed) < current_size) {
+                    m_producer_stats.largest_size.store(current_size, std::memory_order_relaxed);
+                }
+                notify(m_consumer_waiting, m_data_available);
+            }
+
+            void wait_and_pop(T& value) {
+                add_to(m_consumer_stats.calls, std::uint64_t{1});
+                if (empty()) {
+                    add_to(m_consumer_stats.waits, std::uint64_t{1});
+                    const auto start = std::chrono::steady_clock::now();
+                    std::unique_lock<std::mutex> lock{m_mutex};
+                    m_consumer_waiting = true;
+                    m_data_available.wait(lock, [this] {
+                        return !m_in_use || !empty();
+                    });
+                    m_consumer_waiting = false;
+                    add_to(m_consumer_stats.wait_ns, elapsed_ns(start));
+                    if (empty()) {
+                        return;
+                    }
+                }
+                pop_front(value);
+            }
+
+            bool try_pop(T& value) {
+                add_to(m_consumer_stats.calls, std::uint64_t{1});
+                if (empty()) {
+                    add_to(m_consumer_stats.waits, std::uint64_t{1});
+                    return false;
+                }
+                pop_front(value);
+                return true;
+            }
+
+            bool empty() const noexcept {
+                return size() == 0;
+            }
+
+            std::size_t size() const noexcept {
+                // Read head first, so tail can't be smaller
+                const std::size_t head = m_head.value;
+                return m_tail.value - head;
+            }
+
+            std::size_t max_size() const noexcept {
+                return m_max_size;
+            }
+
+            /**
+             * The sum of the payload sizes of all elements in the queue.
+             */
+            std::size_t bytes() const noexcept {
+                return m_bytes;
+            }
+
+            /**
+             * Get a snapshot of the usage counters of this queue. Can be
+             * called from any thread.
+             */
+            queue_stats stats() const noexcept {
+                queue_stats result;
+                result.max_size = m_max_size;
+                result.size = size();
+                result.largest_size = m_producer_stats.largest_size.load(std::memory_order_relaxed);
+                result.push_count = m_producer_stats.calls.load(std::memory_order_relaxed);
+                result.full_count = m_producer_stats.waits.load(std::memory_order_relaxed);
+                result.pop_count = m_consumer_stats.calls.load(std::memory_order_relaxed);
+                result.empty_count = m_consumer_stats.waits.load(std::memory_order_relaxed);
+                result.push_wait_time = std::chrono::nanoseconds{static_cast<std::chrono::nanoseconds::rep>(m_producer_stats.wait_ns.load(std::memory_order_relaxed))};
+                result.pop_wait_time = std::chrono::nanoseconds{static_cast<std::chrono::nanoseconds::rep>(m_consumer_stats.wait_ns.load(std::memory_order_relaxed))};
+                return result;
+            }
+
+            bool in_use() const noexcept {
+                return m_in_use;
+            }
+
+            void shutdown() {
+                m_in_use = false;
+                T value;
+                while (!empty()) {
+                    pop_front(value);
+                }
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                m_data_available.notify_all();
+                m_space_available.notify_all();
+            }
+
+        }; // class SPSCQueue
+
+    } // namespace thread
+
+} // namespace osmium
+
+#endif // OSMIUM_THREAD_SPSC_QUEUE_HPP
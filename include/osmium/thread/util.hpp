@@ -33,6 +33,8 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/util/tracer.hpp>
+
 #include <chrono>
 #include <future>
 #include <thread>
@@ -73,20 +75,18 @@ namespace osmium {
 
         /**
          * Set name of current thread for debugging. This currently only works on Linux and FreeBSD.
+         * The name is also used for the thread in the output of osmium::Tracer.
          */
-#if defined(__linux__)
         inline void set_thread_name(const char* name) noexcept {
+            osmium::Tracer::instance().set_thread_name(name);
+#if defined(__linux__)
             prctl(PR_SET_NAME, name, 0, 0, 0);
-        }
 #elif defined(__FreeBSD__)
-        inline void set_thread_name(const char* name) noexcept {
             pthread_setname_np(pthread_self(), name);
-        }
 #else
-        inline void set_thread_name(const char*) noexcept {
-            // intentionally left blank
-        }
+            (void)name;
 #endif
+        }
 
         class thread_handler {
 
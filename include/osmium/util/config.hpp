@@ -103,6 +103,48 @@ namespace osmium {
             return value;
         }
 
+        /**
+         * Get the maximum number of bytes of data in the named queue from
+         * the environment variable OSMIUM_MAX_<NAME>_QUEUE_MB (in
+         * megabytes). Returns 0 (no limit) if the variable is not set.
+         */
+        inline std::size_t get_max_queue_bytes(const char* queue_name) noexcept {
+            assert(queue_name);
+            std::string name{"OSMIUM_MAX_"};
+            name += queue_name;
+            name += "_QUEUE_MB";
+            const char* env = osmium::detail::getenv_wrapper(name.c_str());
+
+            if (env) {
+                return osmium::detail::str_to_int<std::size_t>(env) * 1024UL * 1024UL;
+            }
+
+            return 0;
+        }
+
+        /**
+         * Get the number of bytes input files are read ahead of the current
+         * position from the environment variable OSMIUM_READ_AHEAD_MB (in
+         * megabytes). Returns the default of 32 MB if the variable is not
+         * set or invalid, 0 if it is set to 0 which disables reading ahead.
+         */
+        inline std::size_t get_read_ahead_bytes() noexcept {
+            const char* env = osmium::detail::getenv_wrapper("OSMIUM_READ_AHEAD_MB");
+            std::size_t value = 32;
+
+            if (env) {
+                if (!std::strcmp(env, "0")) {
+                    return 0;
+                }
+                const auto new_value = osmium::detail::str_to_int<std::size_t>(env);
+                if (new_value != 0) {
+                    value = new_value;
+                }
+            }
+
+            return value * 1024UL * 1024UL;
+        }
+
         inline int8_t clean_page_cache_after_read() noexcept {
             const char* env = osmium::detail::getenv_wrapper("OSMIUM_CLEAN_PAGE_CACHE_AFTER_READ");
             if (env) {
@@ -0,0 +1,298 @@
+#ifndef OSMIUM_UTIL_TRACER_HPP
+#define OSMIUM_UTIL_TRACER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2023 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <chrono>
+#include <iosfwd>
+
+#ifdef OSMIUM_WITH_TRACE
+
+#include <atomic>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    /**
+     * Records begin and end times of the work done in the threads of the
+     * I/O pipeline (reading, decompressing, parsing, encoding, compressing,
+     * writing, and the time the Reader waits for data) and writes them out
+     * in the Chrome trace event format. Load the output into Perfetto or
+     * chrome://tracing to see a timeline of all threads.
+     *
+     * The tracer is only compiled in if OSMIUM_WITH_TRACE is defined.
+     * Otherwise all functions do nothing.
+     *
+     * Usage:
+     * @code{.cpp}
+     * osmium::Tracer::instance().start();
+     * // ... read and/or write some data ...
+     * osmium::Tracer::instance().stop();
+     * std::ofstream out{"trace.json"};
+     * osmium::Tracer::instance().write(out);
+     * @endcode
+     */
+    class Tracer {
+
+        struct event {
+            const char* name;
+            std::chrono::steady_clock::time_point start;
+            std::chrono::steady_clock::duration duration;
+            int thread;
+        };
+
+        mutable std::mutex m_mutex;
+        std::vector<event> m_events;
+        std::vector<std::pair<int, std::string>> m_thread_names;
+        std::chrono::steady_clock::time_point m_start{};
+        std::atomic<bool> m_enabled{false};
+
+        Tracer() = default;
+
+        static int thread_index() noexcept {
+            static std::atomic<int> next_index{1};
+            thread_local const int index = next_index++;
+            return index;
+        }
+
+        static void write_string(std::ostream& out, const char* str) {
+            out << '"';
+            for (; *str; ++str) {
+                if (*str == '"' || *str == '\\') {
+                    out << '\\';
+                }
+                if (static_cast<unsigned char>(*str) >= 0x20) {
+                    out << *str;
+                }
+            }
+            out << '"';
+        }
+
+        static double microseconds(std::chrono::steady_clock::duration duration) {
+            return std::chrono::duration<double, std::micro>{duration}.count();
+        }
+
+    public:
+
+        Tracer(const Tracer&) = delete;
+        Tracer& operator=(const Tracer&) = delete;
+
+        Tracer(Tracer&&) = delete;
+        Tracer& operator=(Tracer&&) = delete;
+
+        ~Tracer() = default;
+
+        static Tracer& instance() {
+            static Tracer tracer;
+            return tracer;
+        }
+
+        /**
+         * Start recording events. Events recorded earlier are removed.
+         */
+        void start() {
+            const std::lock_guard<std::mutex> lock{m_mutex};
+            m_events.clear();
+            m_start = std::chrono::steady_clock::now();
+            m_enabled = true;
+        }
+
+        /**
+         * Stop recording events.
+         */
+        void stop() noexcept {
+            m_enabled = false;
+        }
+
+        bool enabled() const noexcept {
+            return m_enabled;
+        }
+
+        /**
+         * Add an event that happened in the current thread. Does nothing
+         * if the tracer is not enabled.
+         *
+         * @param name Name of the event. Must be a string literal or
+         *             otherwise outlive the tracer.
+         * @param start Time the event started.
+         * @param end Time the event ended.
+         */
+        void add_event(const char* name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) noexcept {
+            if (!m_enabled) {
+                return;
+            }
+            try {
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                m_events.push_back(event{name, start, end - start, thread_index()});
+            } catch (...) {
+                // Losing an event is better than disturbing the program.
+            }
+        }
+
+        /**
+         * Remember the name of the current thread. This is called from
+         * osmium::thread::set_thread_name(), names are recorded even if
+         * the tracer is not enabled.
+         */
+        void set_thread_name(const char* name) noexcept {
+            try {
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                m_thread_names.emplace_back(thread_index(), name);
+            } catch (...) {
+                // Losing a name is better than disturbing the program.
+            }
+        }
+
+        /**
+         * Write all recorded events as JSON in the Chrome trace event
+         * format to the stream.
+         */
+        void write(std::ostream& out) const {
+            const std::lock_guard<std::mutex> lock{m_mutex};
+
+            out << "{\"traceEvents\":[\n";
+            bool first = true;
+            for (const auto& thread_name : m_thread_names) {
+                if (!first) {
+                    out << ",\n";
+                }
+                first = false;
+                out << R"({"name":"thread_name","ph":"M","pid":1,"tid":)" << thread_name.first << R"(,"args":{"name":)";
+                write_string(out, thread_name.second.c_str());
+                out << "}}";
+            }
+            for (const auto& e : m_events) {
+                if (!first) {
+                    out << ",\n";
+                }
+                first = false;
+                out << R"({"name":)";
+                write_string(out, e.name);
+                out << R"(,"cat":"osmium","ph":"X","pid":1,"tid":)" << e.thread
+                    << R"(,"ts":)" << microseconds(e.start - m_start)
+                    << R"(,"dur":)" << microseconds(e.duration)
+                    << '}';
+            }
+            out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+        }
+
+    }; // class Tracer
+
+    /**
+     * Records an event with the given name lasting from the construction
+     * to the destruction of this object.
+     */
+    class TraceEvent {
+
+        const char* m_name;
+        std::chrono::steady_clock::time_point m_start{};
+
+    public:
+
+        explicit TraceEvent(const char* name) noexcept :
+            m_name(name) {
+            if (Tracer::instance().enabled()) {
+                m_start = std::chrono::steady_clock::now();
+            }
+        }
+
+        TraceEvent(const TraceEvent&) = delete;
+        TraceEvent& operator=(const TraceEvent&) = delete;
+
+        TraceEvent(TraceEvent&&) = delete;
+        TraceEvent& operator=(TraceEvent&&) = delete;
+
+        ~TraceEvent() noexcept {
+            if (m_start != std::chrono::steady_clock::time_point{}) {
+                Tracer::instance().add_event(m_name, m_start, std::chrono::steady_clock::now());
+            }
+        }
+
+    }; // class TraceEvent
+
+} // namespace osmium
+
+#else
+
+namespace osmium {
+
+    class Tracer {
+
+        Tracer() = default;
+
+    public:
+
+        static Tracer& instance() {
+            static Tracer tracer;
+            return tracer;
+        }
+
+        void start() const noexcept { // NOLINT(readability-convert-member-functions-to-static)
+        }
+
+        void stop() const noexcept { // NOLINT(readability-convert-member-functions-to-static)
+        }
+
+        bool enabled() const noexcept { // NOLINT(readability-convert-member-functions-to-static)
+            return false;
+        }
+
+        void add_event(const char* /*name*/, std::chrono::steady_clock::time_point /*start*/, std::chrono::steady_clock::time_point /*end*/) const noexcept { // NOLINT(readability-convert-member-functions-to-static)
+        }
+
+        void set_thread_name(const char* /*name*/) const noexcept { // NOLINT(readability-convert-member-functions-to-static)
+        }
+
+        void write(std::ostream& /*out*/) const noexcept { // NOLINT(readability-convert-member-functions-to-static)
+        }
+
+    }; // class Tracer
+
+    class TraceEvent {
+
+    public:
+
+        explicit TraceEvent(const char* /*name*/) noexcept {
+        }
+
+    }; // class TraceEvent
+
+} // namespace osmium
+
+#endif
+
+#endif // OSMIUM_UTIL_TRACER_HPP
@@ -103,7 +103,16 @@ static header_buffer_type parse_xml(std::string input) {
         osmium::osm_entity_bits::all,
         osmium::io::read_meta::yes,
         osmium::io::buffers_type::any,
-        false
+        false,
+        osmium::io::read_mmap::no,
+        osmium::io::blob_range{},
+        osmium::Box{},
+        nullptr,
+        osmium::io::read_fields::all,
+        osmium::metadata_options{},
+        nullptr,
+        osmium::io::read_order::file,
+        nullptr
     };
     osmium::io::detail::XMLParser parser{args};
     parser.parse();
@@ -0,0 +1,87 @@
+#ifndef OSMIUM_TEST_PBF_TEST_DATA_HPP
+#define OSMIUM_TEST_PBF_TEST_DATA_HPP
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/file.hpp>
+#include <osmium/io/pbf_output.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Test data for the PBF tests: 20000 nodes, 100 ways and 10 relations.
+// The PBF writer puts at most 8000 objects into a blob, so the nodes end
+// up in three blobs (with ids 1-8000, 8001-16000, and 16001-20000 if
+// sorted) followed by one blob with the ways and one with the relations.
+//
+// All nodes have an "id" tag with their id. Way n has the nodes n and n+1,
+// relation n has way n as only member.
+
+constexpr const osmium::object_id_type pbf_test_num_nodes = 20000;
+constexpr const osmium::object_id_type pbf_test_num_ways = 100;
+constexpr const osmium::object_id_type pbf_test_num_relations = 10;
+
+// The nodes with ids up to 8000 are near (1, 2), all others near (50, 50).
+// All nodes have different locations.
+inline osmium::Location pbf_test_node_location(osmium::object_id_type id) noexcept {
+    const auto offset = static_cast<int32_t>(id * 100);
+    if (id <= 8000) {
+        return osmium::Location{10000000 + offset, 20000000 + offset};
+    }
+    return osmium::Location{500000000 + offset, 500000000 + offset};
+}
+
+// Id of the nth node in the file. In an unsorted file the ids in the blobs
+// overlap.
+inline osmium::object_id_type pbf_test_node_id(osmium::object_id_type n, bool sorted) noexcept {
+    if (sorted) {
+        return n;
+    }
+    return n % 2 == 0 ? n / 2 : pbf_test_num_nodes - n / 2;
+}
+
+// Create the test data. A new buffer is started after every
+// objects_per_buffer objects, if this is 0 everything ends up in one buffer.
+inline std::vector<osmium::memory::Buffer> create_pbf_test_data(std::size_t objects_per_buffer = 0, bool sorted = true) {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    std::vector<osmium::memory::Buffer> buffers;
+    std::size_t count = 0;
+    const auto buffer = [&]() -> osmium::memory::Buffer& {
+        if (buffers.empty() || (objects_per_buffer > 0 && count % objects_per_buffer == 0)) {
+            buffers.emplace_back(1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes);
+        }
+        ++count;
+        return buffers.back();
+    };
+
+    for (osmium::object_id_type n = 1; n <= pbf_test_num_nodes; ++n) {
+        const auto id = pbf_test_node_id(n, sorted);
+        osmium::builder::add_node(buffer(), _id(id), _version(1), _location(pbf_test_node_location(id)), _tag("id", std::to_string(id)));
+    }
+    for (osmium::object_id_type id = 1; id <= pbf_test_num_ways; ++id) {
+        osmium::builder::add_way(buffer(), _id(id), _version(1), _nodes({id, id + 1}));
+    }
+    for (osmium::object_id_type id = 1; id <= pbf_test_num_relations; ++id) {
+        osmium::builder::add_relation(buffer(), _id(id), _version(1), _member(osmium::item_type::way, id, "outer"));
+    }
+
+    return buffers;
+}
+
+// Write the test data into the given file.
+inline void write_pbf_test_file(const osmium::io::File& file, bool sorted = true) {
+    auto buffers = create_pbf_test_data(0, sorted);
+    osmium::io::Writer writer{file, osmium::io::overwrite::allow};
+    writer(std::move(buffers.front()));
+    writer.close();
+}
+
+#endif // OSMIUM_TEST_PBF_TEST_DATA_HPP
@@ -1,4 +1,9 @@
 
+#include "catch.hpp"
+
+#include <osmium/io/detail/read_write.hpp>
+
+#include <cstddef>
 #include <cstdlib>
 #include <string>
 
@@ -40,3 +45,39 @@ inline std::string with_data_dir(const char* filename) {
     return result;
 }
 
+// Read the whole contents of a file into a string.
+inline std::string read_file(const std::string& filename) {
+    const int fd = osmium::io::detail::open_for_reading(filename);
+    REQUIRE(fd > 0);
+    std::string all;
+    char buffer[4096];
+    for (auto n = osmium::io::detail::reliable_read(fd, buffer, sizeof(buffer)); n > 0; n = osmium::io::detail::reliable_read(fd, buffer, sizeof(buffer))) {
+        all.append(buffer, static_cast<std::size_t>(n));
+    }
+    osmium::io::detail::reliable_close(fd);
+    return all;
+}
+
+// Write a string into a file, overwriting it if it exists.
+inline void write_file(const std::string& filename, const std::string& data) {
+    const int fd = osmium::io::detail::open_for_writing(filename, osmium::io::overwrite::allow);
+    REQUIRE(fd > 0);
+    osmium::io::detail::reliable_write(fd, data.data(), data.size());
+    osmium::io::detail::reliable_close(fd);
+}
+
+// Decompress a whole file with the given decompressor class.
+template <typename TDecompressor>
+std::string decompress_file(const std::string& filename) {
+    const int fd = osmium::io::detail::open_for_reading(filename);
+    REQUIRE(fd > 0);
+
+    std::string all;
+    TDecompressor decomp{fd};
+    for (std::string data = decomp.read(); !data.empty(); data = decomp.read()) {
+        all += data;
+    }
+    decomp.close();
+
+    return all;
+}
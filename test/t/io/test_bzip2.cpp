@@ -4,7 +4,9 @@
 
 #include <osmium/io/bzip2_compression.hpp>
 #include <osmium/io/detail/read_write.hpp>
+#include <osmium/util/file.hpp>
 
+#include <fcntl.h>
 #include <string>
 
 static void read_from_decompressor(int fd) {
@@ -146,3 +148,119 @@ TEST_CASE("Write bzip2-compressed file with implicit close") {
     REQUIRE(osmium::file_size(output_file) > 10);
 }
 
+
+static std::string bzip2_test_data(int num) {
+    std::string data;
+    for (int i = 0; i < num; ++i) {
+        data += "w";
+        data += std::to_string(i);
+        data += " v2 dV c";
+        data += std::to_string(i * 13 % 1000);
+        data += " Tname=Street%20";
+        data += std::to_string(i % 311);
+        data += "\n";
+    }
+    return data;
+}
+
+TEST_CASE("Write and read bzip2-compressed file with many streams") {
+    const int count = count_fds();
+
+    const std::string data = bzip2_test_data(100000);
+    REQUIRE(data.size() > 3000000);
+    const std::string output_file = "test_bzip2_out_streams.txt.bz2";
+
+    {
+        const int fd = osmium::io::detail::open_for_writing(output_file, osmium::io::overwrite::allow);
+        REQUIRE(fd > 0);
+        osmium::io::Bzip2Compressor comp{fd, osmium::io::fsync::no};
+        comp.write(data.substr(0, 1000));
+        comp.write(data.substr(1000));
+        comp.close();
+        REQUIRE(comp.file_size() == osmium::file_size(output_file));
+    }
+
+    REQUIRE(count == count_fds());
+
+    const std::string compressed = read_file(output_file);
+    REQUIRE(compressed.substr(0, 4) == "BZh6");
+    REQUIRE(compressed.find("BZh6", 1) != std::string::npos);
+
+    SECTION("read with parallel decompression") {
+        REQUIRE(decompress_file<osmium::io::Bzip2Decompressor>(output_file) == data);
+    }
+
+    SECTION("read with buffer decompressor") {
+        std::string all;
+        osmium::io::Bzip2BufferDecompressor decomp{compressed.data(), compressed.size()};
+        for (std::string d = decomp.read(); !d.empty(); d = decomp.read()) {
+            all += d;
+        }
+        REQUIRE(all == data);
+    }
+
+    REQUIRE(count == count_fds());
+}
+
+TEST_CASE("Read bzip2-compressed file with many blocks in one stream") {
+    const std::string data = bzip2_test_data(30000);
+
+    // block size 1 (100k) gives a stream with many blocks
+    std::string compressed(data.size() + data.size() / 100 + 600, '\0');
+    auto size = static_cast<unsigned int>(compressed.size());
+    REQUIRE(BZ2_bzBuffToBuffCompress(&compressed[0], &size, const_cast<char*>(data.data()), static_cast<unsigned int>(data.size()), 1, 0, 0) == BZ_OK);
+    compressed.resize(size);
+
+    const std::string input_file = "test_bzip2_blocks.txt.bz2";
+
+    SECTION("one stream") {
+        write_file(input_file, compressed);
+        REQUIRE(decompress_file<osmium::io::Bzip2Decompressor>(input_file) == data);
+    }
+
+    SECTION("two streams") {
+        write_file(input_file, compressed + compressed);
+        REQUIRE(decompress_file<osmium::io::Bzip2Decompressor>(input_file) == data + data);
+    }
+
+    SECTION("truncated stream") {
+        write_file(input_file, compressed.substr(0, compressed.size() - 1000));
+        REQUIRE_THROWS_AS(decompress_file<osmium::io::Bzip2Decompressor>(input_file), osmium::bzip2_error);
+    }
+
+    SECTION("stream with garbage after it") {
+        write_file(input_file, compressed + "garbage");
+        REQUIRE_THROWS_AS(decompress_file<osmium::io::Bzip2Decompressor>(input_file), osmium::bzip2_error);
+    }
+}
+
+TEST_CASE("Write empty bzip2-compressed file") {
+    const std::string output_file = "test_bzip2_out_empty.txt.bz2";
+    {
+        const int fd = osmium::io::detail::open_for_writing(output_file, osmium::io::overwrite::allow);
+        REQUIRE(fd > 0);
+        osmium::io::Bzip2Compressor comp{fd, osmium::io::fsync::no};
+        comp.close();
+    }
+    REQUIRE(osmium::file_size(output_file) > 10);
+    REQUIRE(decompress_file<osmium::io::Bzip2Decompressor>(output_file).empty());
+}
+
+#ifdef __linux__
+TEST_CASE("Write bzip2-compressed file to full disk") {
+    const int count = count_fds();
+
+    const int fd = ::open("/dev/full", O_WRONLY); // NOLINT(hicpp-vararg,cppcoreguidelines-pro-type-vararg)
+    if (fd < 0) {
+        return;
+    }
+
+    {
+        osmium::io::Bzip2Compressor comp{fd, osmium::io::fsync::no};
+        comp.write("foo");
+        REQUIRE_THROWS_AS(comp.close(), std::system_error);
+    }
+
+    REQUIRE(count == count_fds());
+}
+#endif
@@ -4,7 +4,9 @@
 
 #include <osmium/io/detail/read_write.hpp>
 #include <osmium/io/gzip_compression.hpp>
+#include <osmium/util/options.hpp>
 
+#include <fcntl.h>
 #include <string>
 
 TEST_CASE("Invalid file descriptor of gzip-compressed file") {
@@ -135,3 +137,138 @@ TEST_CASE("Write gzip-compressed file with implicit close") {
     REQUIRE(osmium::file_size(output_file) > 10);
 }
 
+
+static std::string bgzf_test_data() {
+    std::string data;
+    for (int i = 0; i < 100000; ++i) {
+        data += "n";
+        data += std::to_string(i);
+        data += " v1 dV c";
+        data += std::to_string(i * 7 % 1000);
+        data += " x1.";
+        data += std::to_string(i % 97);
+        data += "\n";
+    }
+    return data;
+}
+
+TEST_CASE("Write gzip-compressed file in BGZF format") {
+    const int count = count_fds();
+
+    const std::string data = bgzf_test_data();
+    const std::string output_file = "test_gzip_out_blocks.txt.gz";
+
+    {
+        const int fd = osmium::io::detail::open_for_writing(output_file, osmium::io::overwrite::allow);
+        REQUIRE(fd > 0);
+
+        osmium::Options options;
+        options.set("gzip_blocks", true);
+
+        osmium::io::GzipCompressor comp{fd, osmium::io::fsync::no};
+        comp.set_options(options);
+        comp.write(data.substr(0, 1000));
+        comp.write(data.substr(1000));
+        comp.close();
+    }
+
+    REQUIRE(count == count_fds());
+
+    const std::string compressed = read_file(output_file);
+    REQUIRE(compressed.size() > 28);
+    REQUIRE(compressed.size() < data.size());
+    REQUIRE(osmium::io::detail::bgzf_block_size(compressed.data(), compressed.size()) > 0);
+
+    // there must be many blocks, each one correctly sized
+    std::size_t num_blocks = 0;
+    for (std::size_t pos = 0; pos < compressed.size(); ++num_blocks) {
+        const auto size = osmium::io::detail::bgzf_block_size(compressed.data() + pos, compressed.size() - pos);
+        REQUIRE(size > 0);
+        pos += size;
+    }
+    REQUIRE(num_blocks > data.size() / 0xff00);
+
+    // ends with the BGZF EOF marker
+    REQUIRE(compressed.substr(compressed.size() - 28, 4) == std::string{"\x1f\x8b\x08\x04", 4});
+
+    SECTION("read with parallel decompression") {
+        REQUIRE(decompress_file<osmium::io::GzipDecompressor>(output_file) == data);
+    }
+
+    SECTION("read with buffer decompressor") {
+        std::string all;
+        osmium::io::GzipBufferDecompressor decomp{compressed.data(), compressed.size()};
+        for (std::string d = decomp.read(); !d.empty(); d = decomp.read()) {
+            all += d;
+        }
+        REQUIRE(all == data);
+    }
+
+    SECTION("read BGZF file followed by normal gzip member") {
+        const std::string mixed_file = "test_gzip_out_mixed.txt.gz";
+        write_file(mixed_file, compressed + read_file(with_data_dir("t/io/data_gzip.txt.gz")));
+
+        const std::string all = decompress_file<osmium::io::GzipDecompressor>(mixed_file);
+        REQUIRE(all.size() > data.size());
+        REQUIRE(all.substr(0, data.size()) == data);
+        REQUIRE(all.substr(data.size(), 8) == "TESTDATA");
+    }
+
+    SECTION("corrupted BGZF block") {
+        std::string corrupt = compressed;
+        corrupt[100] = static_cast<char>(~corrupt[100]);
+        const std::string corrupt_file = "test_gzip_out_corrupt.txt.gz";
+        write_file(corrupt_file, corrupt);
+        REQUIRE_THROWS_AS(decompress_file<osmium::io::GzipDecompressor>(corrupt_file), osmium::gzip_error);
+    }
+
+    SECTION("BGZF block with too large uncompressed size") {
+        std::string corrupt = compressed;
+        const auto block_size = osmium::io::detail::bgzf_block_size(corrupt.data(), corrupt.size());
+        corrupt.replace(block_size - 4, 4, "\xff\xff\xff\x7f");
+        const std::string corrupt_file = "test_gzip_out_corrupt.txt.gz";
+        write_file(corrupt_file, corrupt);
+        REQUIRE_THROWS_AS(decompress_file<osmium::io::GzipDecompressor>(corrupt_file), osmium::gzip_error);
+    }
+
+    REQUIRE(count == count_fds());
+}
+
+TEST_CASE("Write empty gzip-compressed file in BGZF format") {
+    const std::string output_file = "test_gzip_out_blocks_empty.txt.gz";
+    const int fd = osmium::io::detail::open_for_writing(output_file, osmium::io::overwrite::allow);
+    REQUIRE(fd > 0);
+
+    osmium::Options options;
+    options.set("gzip_blocks", true);
+
+    osmium::io::GzipCompressor comp{fd, osmium::io::fsync::no};
+    comp.set_options(options);
+    comp.close();
+
+    REQUIRE(osmium::file_size(output_file) == 28);
+    REQUIRE(decompress_file<osmium::io::GzipDecompressor>(output_file).empty());
+}
+
+#ifdef __linux__
+TEST_CASE("Write gzip-compressed file in BGZF format to full disk") {
+    const int count = count_fds();
+
+    const int fd = ::open("/dev/full", O_WRONLY); // NOLINT(hicpp-vararg,cppcoreguidelines-pro-type-vararg)
+    if (fd < 0) {
+        return;
+    }
+
+    {
+        osmium::Options options;
+        options.set("gzip_blocks", true);
+
+        osmium::io::GzipCompressor comp{fd, osmium::io::fsync::no};
+        comp.set_options(options);
+        comp.write("foo");
+        REQUIRE_THROWS_AS(comp.close(), std::system_error);
+    }
+
+    REQUIRE(count == count_fds());
+}
+#endif
@@ -3,7 +3,11 @@
 #include "utils.hpp"
 
 #include <osmium/io/compression.hpp>
+#include <osmium/util/options.hpp>
 
+#include <fcntl.h>
+#include <fstream>
+#include <iterator>
 #include <string>
 
 TEST_CASE("Invalid file descriptor of uncompressed file") {
@@ -123,3 +127,130 @@ TEST_CASE("Write uncompressed file with implicit close") {
     REQUIRE(osmium::file_size(output_file) == 3);
 }
 
+
+TEST_CASE("Write uncompressed file with direct_io option") {
+    const int count = count_fds();
+
+    std::string data;
+    SECTION("small file") {
+        data = "foo";
+    }
+    SECTION("file larger than the direct I/O buffers") {
+        // odd size so the data is written in several full buffers and a
+        // tail that is not a multiple of the block size
+        for (std::size_t i = 0; data.size() < 20UL * 1024UL * 1024UL + 1234; ++i) {
+            data += std::to_string(i);
+            data += ' ';
+        }
+    }
+
+    const std::string output_file = "test_uncompressed_direct_out.txt";
+    const int fd = osmium::io::detail::open_for_writing(output_file, osmium::io::overwrite::allow);
+    REQUIRE(fd > 0);
+
+    {
+        osmium::io::NoCompressor comp{fd, osmium::io::fsync::yes};
+        osmium::Options options;
+        options.set("direct_io", true);
+        comp.set_options(options);
+
+        // write in pieces of different sizes
+        std::size_t pos = 0;
+        for (std::size_t len = 1; pos < data.size(); len = len * 7 % 100003) {
+            comp.write(data.substr(pos, len));
+            pos += len;
+        }
+        comp.close();
+        REQUIRE(comp.file_size() == data.size());
+    }
+
+    REQUIRE(count == count_fds());
+    REQUIRE(osmium::file_size(output_file) == data.size());
+
+    std::ifstream in{output_file, std::ios::binary};
+    const std::string content{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+    REQUIRE(content == data);
+}
+
+#ifdef __linux__
+TEST_CASE("Write uncompressed file with direct_io option to full disk") {
+    const int count = count_fds();
+
+    const int fd = ::open("/dev/full", O_WRONLY); // NOLINT(hicpp-vararg,cppcoreguidelines-pro-type-vararg)
+    if (fd < 0) {
+        return;
+    }
+
+    {
+        osmium::io::NoCompressor comp{fd, osmium::io::fsync::no};
+        osmium::Options options;
+        options.set("direct_io", true);
+        comp.set_options(options);
+
+        // more than one buffer, so it is written before close()
+        comp.write(std::string(9UL * 1024UL * 1024UL, 'x'));
+        REQUIRE_THROWS_AS(comp.close(), std::system_error);
+    }
+
+    REQUIRE(count == count_fds());
+}
+
+TEST_CASE("Direct writer restores file flags") {
+    const std::string output_file = "test_uncompressed_direct_flags.txt";
+    const int fd = osmium::io::detail::open_for_writing(output_file, osmium::io::overwrite::allow);
+    REQUIRE(fd > 0);
+    const int flags = ::fcntl(fd, F_GETFL); // NOLINT(hicpp-vararg,cppcoreguidelines-pro-type-vararg)
+
+    {
+        osmium::io::detail::direct_writer writer{fd};
+        writer.write("foo", 3);
+        writer.close();
+        REQUIRE(::fcntl(fd, F_GETFL) == flags); // NOLINT(hicpp-vararg,cppcoreguidelines-pro-type-vararg)
+    }
+
+    {
+        osmium::io::detail::direct_writer writer{fd};
+        writer.write("bar", 3);
+    }
+    REQUIRE(::fcntl(fd, F_GETFL) == flags); // NOLINT(hicpp-vararg,cppcoreguidelines-pro-type-vararg)
+
+    osmium::io::detail::reliable_close(fd);
+}
+#endif
+
+#if defined(__linux__) || defined(__FreeBSD__)
+TEST_CASE("Read ahead in uncompressed file") {
+    constexpr const std::size_t mb = 1024UL * 1024UL;
+
+    const std::string file_name = "test_uncompressed_read_ahead.txt";
+    {
+        const int fd = osmium::io::detail::open_for_writing(file_name, osmium::io::overwrite::allow);
+        osmium::io::NoCompressor comp{fd, osmium::io::fsync::no};
+        comp.write(std::string(10 * mb, 'x'));
+        comp.close();
+    }
+
+    const int fd = osmium::io::detail::open_for_reading(file_name);
+    REQUIRE(fd > 0);
+
+    SECTION("read ahead is done in chunks") {
+        osmium::io::detail::read_ahead ra{fd, 6 * mb};
+        REQUIRE(ra.requested() == 4 * mb);
+        ra.advance(3 * mb);
+        REQUIRE(ra.requested() == 8 * mb);
+        // window reaches the end of the file
+        ra.advance(1 * mb);
+        REQUIRE(ra.requested() == 10 * mb);
+        ra.advance(4 * mb);
+        REQUIRE(ra.requested() == 10 * mb);
+    }
+
+    SECTION("read ahead can be disabled") {
+        osmium::io::detail::read_ahead ra{fd, 0};
+        ra.advance(3 * mb);
+        REQUIRE(ra.requested() == 0);
+    }
+
+    osmium::io::detail::reliable_close(fd);
+}
+#endif
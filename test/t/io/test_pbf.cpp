@@ -1,10 +1,33 @@
 #include "catch.hpp"
 
+#include "pbf_test_data.hpp"
+#include "test_crc.hpp"
 #include "utils.hpp"
 
+#include <osmium/io/detail/pbf_decoder.hpp>
 #include <osmium/io/pbf_input.hpp>
+#include <osmium/io/pbf_output.hpp>
 #include <osmium/io/reader.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/memory/buffer_recycler.hpp>
+#include <osmium/osm/crc.hpp>
+#include <osmium/osm/node.hpp>
 #include <osmium/osm/object.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <protozero/pbf_reader.hpp>
+#include <protozero/pbf_writer.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
 TEST_CASE("Get supported PBF compression types") {
     const auto types = osmium::io::supported_pbf_compression_types();
@@ -13,6 +36,47 @@ TEST_CASE("Get supported PBF compression types") {
     REQUIRE(types[1] == "zlib");
 }
 
+TEST_CASE("Decode packed delta encoded sint64 field") {
+    std::vector<int64_t> values;
+    for (int64_t i = 0; i < 100; ++i) {
+        values.push_back(i);
+    }
+    values.push_back(5000);
+    values.push_back(-17);
+    values.push_back(std::numeric_limits<int32_t>::max());
+    values.push_back(std::numeric_limits<int32_t>::min());
+    for (int64_t i = 0; i < 11; ++i) {
+        values.push_back(1000000000LL + i * 3);
+    }
+
+    std::vector<int64_t> deltas;
+    int64_t last = 0;
+    for (const auto value : values) {
+        deltas.push_back(value - last);
+        last = value;
+    }
+
+    std::string data;
+    {
+        protozero::pbf_writer writer{data};
+        writer.add_packed_sint64(1, deltas.cbegin(), deltas.cend());
+    }
+
+    protozero::pbf_reader reader{data};
+    REQUIRE(reader.next(1));
+
+    std::vector<int64_t> decoded{1, 2, 3};
+    osmium::io::detail::decode_packed_sint64_delta(reader.get_view(), decoded);
+    REQUIRE(decoded == values);
+
+    osmium::io::detail::decode_packed_sint64_delta(protozero::data_view{}, decoded);
+    REQUIRE(decoded.empty());
+
+    const std::string truncated{"\x02\x04\x80"};
+    REQUIRE_THROWS_AS(osmium::io::detail::decode_packed_sint64_delta(protozero::data_view{truncated.data(), truncated.size()}, decoded),
+                      protozero::end_of_buffer_exception);
+}
+
 /**
  * Osmosis writes PBF with changeset=-1 if its input file did not contain the changeset field.
  * The default value of the version field is -1 in the OSM.PBF format.
@@ -50,3 +114,194 @@ TEST_CASE("Read PBF file with version=-1 and changeset=-1 and DenseNodes (writte
     REQUIRE(object.version() == 0);
     REQUIRE(object.changeset() == 0);
 }
+
+TEST_CASE("Read PBF file using memory mapping") {
+    const std::string filename{with_data_dir("t/io/deleted_nodes.osh.pbf")};
+
+    const osmium::memory::Buffer buffer = osmium::io::read_file(filename);
+    const osmium::memory::Buffer buffer_mmap = osmium::io::read_file(filename, osmium::io::read_mmap::yes);
+
+    REQUIRE(buffer.committed() == buffer_mmap.committed());
+    REQUIRE(std::equal(buffer.data(), buffer.data() + buffer.committed(), buffer_mmap.data()));
+}
+
+TEST_CASE("Read PBF file using buffer recycler") {
+    const std::string filename{with_data_dir("t/io/deleted_nodes.osh.pbf")};
+    osmium::memory::BufferRecycler recycler;
+
+    const osmium::memory::Buffer buffer = osmium::io::read_file(filename);
+
+    for (int i = 0; i < 2; ++i) {
+        osmium::io::Reader reader{filename, recycler};
+        osmium::memory::Buffer buffer_recycled{1024, osmium::memory::Buffer::auto_grow::yes};
+        while (auto data = reader.read()) {
+            buffer_recycled.add_buffer(data);
+            buffer_recycled.commit();
+            recycler.put(std::move(data));
+        }
+        reader.close();
+
+        REQUIRE(recycler.size() > 0);
+        REQUIRE(buffer.committed() == buffer_recycled.committed());
+        REQUIRE(std::equal(buffer.data(), buffer.data() + buffer.committed(), buffer_recycled.data()));
+    }
+}
+
+TEST_CASE("Reader using memory mapping reports offset") {
+    const osmium::io::File file{with_data_dir("t/io/deleted_nodes.osh.pbf")};
+    osmium::io::Reader reader{file, osmium::io::read_mmap::yes};
+
+    while (reader.read()) {
+    }
+    REQUIRE(reader.eof());
+    REQUIRE(reader.offset() == reader.file_size());
+    reader.close();
+}
+
+#ifdef OSMIUM_WITH_ZSTD
+TEST_CASE("Write and read PBF file with zstd-compressed blobs") {
+    const osmium::memory::Buffer buffer = osmium::io::read_file(with_data_dir("t/io/deleted_nodes.osh.pbf"));
+
+    osmium::io::File file{"test_pbf_zstd.osh.pbf"};
+    file.set("pbf_compression", "zstd");
+
+    SECTION("default compression level") {
+    }
+
+    SECTION("explicit compression level") {
+        file.set("pbf_compression_level", "19");
+    }
+
+    osmium::io::Header header;
+    header.set_has_multiple_object_versions(true);
+    osmium::io::Writer writer{file, header, osmium::io::overwrite::allow};
+    writer(buffer);
+    writer.close();
+
+    const osmium::memory::Buffer buffer_read = osmium::io::read_file(file.filename());
+    REQUIRE(buffer.committed() == buffer_read.committed());
+    REQUIRE(std::equal(buffer.data(), buffer.data() + buffer.committed(), buffer_read.data()));
+}
+#endif
+
+TEST_CASE("Compress and uncompress PBF blob data with zlib") {
+    std::string input;
+    for (int i = 0; i < 10000; ++i) {
+        input += "test data " + std::to_string(i) + "\n";
+    }
+
+    const std::string compressed = osmium::io::detail::zlib_compress(input, 9);
+    REQUIRE(compressed.size() < input.size());
+
+    std::string output;
+    const auto view = osmium::io::detail::zlib_uncompress_string(compressed.data(), compressed.size(), input.size(), output);
+    REQUIRE(std::string(view.data(), view.size()) == input);
+
+    REQUIRE_THROWS_AS(osmium::io::detail::zlib_uncompress_string(compressed.data(), compressed.size(), input.size() - 1, output), osmium::io_error);
+}
+
+namespace {
+
+    // Objects are not compared byte by byte, because padding in them
+    // (for instance in relation members) isn't always initialized.
+    uint32_t checksum(const osmium::memory::Buffer& buffer) {
+        osmium::CRC<crc_type> crc;
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            switch (object.type()) {
+                case osmium::item_type::node:
+                    crc.update(static_cast<const osmium::Node&>(object));
+                    break;
+                case osmium::item_type::way:
+                    crc.update(static_cast<const osmium::Way&>(object));
+                    break;
+                case osmium::item_type::relation:
+                    crc.update(static_cast<const osmium::Relation&>(object));
+                    break;
+                default:
+                    break;
+            }
+        }
+        return crc().checksum();
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Write PBF file from many small buffers") {
+    // Blocks are built from objects in several buffers, they are encoded
+    // in parallel but must be written in order.
+    const osmium::memory::Buffer all{std::move(create_pbf_test_data().front())};
+    std::vector<osmium::memory::Buffer> buffers = create_pbf_test_data(1000);
+
+    osmium::io::File file{"test_pbf_small_buffers.osm.pbf"};
+
+    SECTION("string table in order of first use") {
+    }
+
+    SECTION("string table sorted by frequency") {
+        file.set("pbf_sort_stringtable", "true");
+    }
+
+    SECTION("automatic compression level") {
+        file.set("pbf_compression_level", "auto");
+    }
+
+    osmium::io::Writer writer{file, osmium::io::overwrite::allow};
+    for (auto& buffer : buffers) {
+        writer(std::move(buffer));
+    }
+    writer.close();
+
+    const osmium::memory::Buffer buffer_read = osmium::io::read_file(file.filename());
+    REQUIRE(all.committed() == buffer_read.committed());
+    REQUIRE(checksum(all) == checksum(buffer_read));
+}
+
+TEST_CASE("Automatic PBF compression level") {
+    osmium::io::detail::pbf_compression_level_controller controller{1, 9, 6};
+    REQUIRE(controller.level() == 6);
+
+    const auto submit_blocks = [&controller](double queue_fill) {
+        for (int i = 0; i <= osmium::io::detail::pbf_compression_level_controller::min_blocks_at_level; ++i) {
+            controller.add_latency(std::chrono::microseconds{1});
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+            controller.block_submitted(queue_fill, 2);
+        }
+    };
+
+    SECTION("level is raised if the queue is empty and blocks are fast") {
+        submit_blocks(0.0);
+        REQUIRE(controller.level() == 7);
+        for (int i = 0; i < 5; ++i) {
+            submit_blocks(0.0);
+        }
+        REQUIRE(controller.level() == 9);
+    }
+
+    SECTION("level is lowered if the queue is full") {
+        submit_blocks(1.0);
+        REQUIRE(controller.level() == 5);
+        for (int i = 0; i < 10; ++i) {
+            submit_blocks(1.0);
+        }
+        REQUIRE(controller.level() == 1);
+    }
+
+    SECTION("level is kept if the queue is half full") {
+        submit_blocks(0.5);
+        REQUIRE(controller.level() == 6);
+    }
+}
+
+TEST_CASE("Automatic PBF compression level is not available for all compression types") {
+    osmium::thread::Pool pool{1};
+    osmium::io::detail::future_string_queue_type queue;
+
+    osmium::io::File file{"test.osm.pbf"};
+    file.set("pbf_compression_level", "auto");
+
+    file.set("pbf_compression", "none");
+    REQUIRE_THROWS_AS(osmium::io::detail::PBFOutputFormat(pool, file, queue), std::invalid_argument);
+
+    file.set("pbf_compression", "zlib");
+    const osmium::io::detail::PBFOutputFormat output{pool, file, queue};
+}
@@ -0,0 +1,256 @@
+#include "catch.hpp"
+
+#include "pbf_test_data.hpp"
+#include "utils.hpp"
+
+#include <osmium/io/pbf_blob_index.hpp>
+#include <osmium/io/pbf_input.hpp>
+#include <osmium/io/pbf_output.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/util/file.hpp>
+
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+
+    // The blob index tests need index data in the file, unless the format
+    // says otherwise.
+    void write_test_file(const std::string& filename, const char* format = "pbf,pbf_index_data=true") {
+        write_pbf_test_file(osmium::io::File{filename, format});
+    }
+
+    std::size_t count_objects(const std::string& filename, const osmium::io::blob_range& range, osmium::osm_entity_bits::type types) {
+        osmium::io::Reader reader{filename, range};
+        std::size_t count = 0;
+        while (const auto buffer = reader.read()) {
+            for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                if (types & osmium::osm_entity_bits::from_item_type(object.type())) {
+                    ++count;
+                }
+            }
+        }
+        reader.close();
+        return count;
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Create PBF blob index") {
+    const std::string filename{"test-pbf-blob-index.osm.pbf"};
+    write_test_file(filename);
+
+    const auto index = osmium::io::create_pbf_blob_index(filename);
+    REQUIRE(index.size() == 5);
+    REQUIRE(index.file_size() == osmium::file_size(filename));
+    REQUIRE(index[4].end() == index.file_size());
+
+    REQUIRE(index[0].types == osmium::osm_entity_bits::node);
+    REQUIRE(index[0].min_id == 1);
+    REQUIRE(index[0].max_id == 8000);
+    REQUIRE(index[2].min_id == 16001);
+    REQUIRE(index[2].max_id == 20000);
+    REQUIRE(index[3].types == osmium::osm_entity_bits::way);
+    REQUIRE(index[4].types == osmium::osm_entity_bits::relation);
+    REQUIRE(index[4].max_id == 10);
+
+    REQUIRE(index[0].bbox == osmium::Box(pbf_test_node_location(1), pbf_test_node_location(8000)));
+    REQUIRE(index[1].bbox == osmium::Box(pbf_test_node_location(8001), pbf_test_node_location(16000)));
+    REQUIRE_FALSE(index[3].bbox.valid());
+    REQUIRE_FALSE(index[4].bbox.valid());
+
+    for (std::size_t n = 1; n < index.size(); ++n) {
+        REQUIRE(index[n].offset == index[n - 1].end());
+    }
+
+    SECTION("Save and load index") {
+        const std::string index_filename{"test-pbf-blob-index.osm.pbf.idx"};
+        index.save(index_filename);
+        const auto loaded = osmium::io::PBFBlobIndex::load(index_filename);
+        REQUIRE(loaded.size() == index.size());
+        REQUIRE(loaded.file_size() == index.file_size());
+        for (std::size_t n = 0; n < index.size(); ++n) {
+            REQUIRE(loaded[n].offset == index[n].offset);
+            REQUIRE(loaded[n].size == index[n].size);
+            REQUIRE(loaded[n].types == index[n].types);
+            REQUIRE(loaded[n].min_id == index[n].min_id);
+            REQUIRE(loaded[n].max_id == index[n].max_id);
+            REQUIRE(loaded[n].bbox == index[n].bbox);
+        }
+    }
+
+    SECTION("Read only relations") {
+        const auto range = index.range(osmium::osm_entity_bits::relation);
+        REQUIRE(range.begin == index[4].offset);
+        REQUIRE(count_objects(filename, range, osmium::osm_entity_bits::object) == 10);
+    }
+
+    SECTION("Read some node blobs") {
+        REQUIRE(count_objects(filename, index.range(1, 3), osmium::osm_entity_bits::node) == 12000);
+    }
+
+    SECTION("Read split ranges") {
+        const auto ranges = index.split(3);
+        REQUIRE(ranges.size() >= 2);
+        std::size_t count = 0;
+        for (const auto& range : ranges) {
+            count += count_objects(filename, range, osmium::osm_entity_bits::object);
+        }
+        REQUIRE(count == 20110);
+    }
+
+    SECTION("Read split ranges with memory mapping") {
+        std::size_t count = 0;
+        for (const auto& range : index.split(2)) {
+            osmium::io::Reader reader{filename, range, osmium::io::read_mmap::yes};
+            while (const auto buffer = reader.read()) {
+                count += std::distance(buffer.select<osmium::OSMObject>().begin(), buffer.select<osmium::OSMObject>().end());
+            }
+            reader.close();
+        }
+        REQUIRE(count == 20110);
+    }
+}
+
+TEST_CASE("Create PBF blob index from file without index data") {
+    const std::string filename{"test-pbf-blob-index.osm.pbf"};
+    const std::string filename_no_data{"test-pbf-blob-index-no-data.osm.pbf"};
+    write_test_file(filename);
+    write_test_file(filename_no_data, "pbf");
+
+    const auto index = osmium::io::create_pbf_blob_index(filename);
+    const auto index_no_data = osmium::io::create_pbf_blob_index(filename_no_data);
+
+    REQUIRE(index_no_data.size() == index.size());
+    REQUIRE(index_no_data.file_size() < index.file_size());
+    for (std::size_t n = 0; n < index.size(); ++n) {
+        REQUIRE(index_no_data[n].types == index[n].types);
+        REQUIRE(index_no_data[n].min_id == index[n].min_id);
+        REQUIRE(index_no_data[n].max_id == index[n].max_id);
+    }
+}
+
+TEST_CASE("Read only some entity types from PBF file with and without index data") {
+    const std::string filename{"test-pbf-blob-index-types.osm.pbf"};
+    const std::string filename_no_data{"test-pbf-blob-index-types-no-data.osm.pbf"};
+    write_test_file(filename);
+    write_test_file(filename_no_data, "pbf");
+
+    const auto count = [](const std::string& filename, osmium::osm_entity_bits::type types) {
+        osmium::io::Reader reader{filename, types};
+        std::size_t n = 0;
+        while (const auto buffer = reader.read()) {
+            n += std::distance(buffer.select<osmium::OSMObject>().begin(), buffer.select<osmium::OSMObject>().end());
+        }
+        reader.close();
+        return n;
+    };
+
+    for (const auto& name : {filename, filename_no_data}) {
+        REQUIRE(count(name, osmium::osm_entity_bits::relation) == 10);
+        REQUIRE(count(name, osmium::osm_entity_bits::way | osmium::osm_entity_bits::relation) == 110);
+        REQUIRE(count(name, osmium::osm_entity_bits::node) == 20000);
+    }
+}
+
+TEST_CASE("Index data without marker is ignored") {
+    const std::string filename{"test-pbf-blob-index-foreign.osm.pbf"};
+    write_test_file(filename);
+
+    // Overwrite the marker in all BlobHeaders so the index data looks
+    // like something written by another program.
+    std::string data = read_file(filename);
+    const std::string marker{osmium::io::detail::OSMIndexData::marker};
+    std::size_t markers = 0;
+    for (auto pos = data.find(marker); pos != std::string::npos; pos = data.find(marker, pos)) {
+        data.replace(pos, marker.size(), marker.size(), 'X');
+        ++markers;
+    }
+    REQUIRE(markers == 5);
+    write_file(filename, data);
+
+    const auto index = osmium::io::create_pbf_blob_index(filename);
+    REQUIRE(index.size() == 5);
+    REQUIRE(index[0].types == osmium::osm_entity_bits::node);
+    REQUIRE(index[0].max_id == 8000);
+    REQUIRE_FALSE(index[0].bbox.valid());
+    REQUIRE(index[4].types == osmium::osm_entity_bits::relation);
+
+    osmium::io::Reader reader{filename, osmium::Box{-10.0, -10.0, -5.0, -5.0}, osmium::osm_entity_bits::node};
+    std::size_t count = 0;
+    while (const auto buffer = reader.read()) {
+        count += std::distance(buffer.select<osmium::OSMObject>().begin(), buffer.select<osmium::OSMObject>().end());
+    }
+    reader.close();
+    REQUIRE(count == 20000);
+}
+
+TEST_CASE("Decoding broken index data does not throw") {
+    using osmium::io::detail::decode_index_data;
+    const std::string marker{osmium::io::detail::OSMIndexData::marker};
+
+    REQUIRE_FALSE(decode_index_data(protozero::data_view{}).valid());
+    REQUIRE_FALSE(decode_index_data(protozero::data_view{"foo"}).valid());
+    REQUIRE_FALSE(decode_index_data(protozero::data_view{marker}).valid());
+
+    const std::string truncated = marker + "\x08\xff";
+    REQUIRE_FALSE(decode_index_data(protozero::data_view{truncated}).valid());
+
+    const std::string min_greater_max = marker + "\x08\x01\x10\x04\x18\x02";
+    REQUIRE_FALSE(decode_index_data(protozero::data_view{min_greater_max}).valid());
+
+    const std::string good = marker + "\x08\x01\x10\x02\x18\x04";
+    const auto index_data = decode_index_data(protozero::data_view{good});
+    REQUIRE(index_data.valid());
+    REQUIRE(index_data.types == osmium::osm_entity_bits::node);
+    REQUIRE(index_data.min_id == 1);
+    REQUIRE(index_data.max_id == 2);
+}
+
+TEST_CASE("Read only PBF blobs overlapping a bounding box") {
+    const std::string filename{"test-pbf-blob-index-bbox.osm.pbf"};
+    write_test_file(filename);
+
+    const auto count = [&filename](const osmium::Box& box, osmium::osm_entity_bits::type types) {
+        osmium::io::Reader reader{filename, box, types};
+        std::size_t n = 0;
+        while (const auto buffer = reader.read()) {
+            n += std::distance(buffer.select<osmium::OSMObject>().begin(), buffer.select<osmium::OSMObject>().end());
+        }
+        reader.close();
+        return n;
+    };
+
+    REQUIRE(count(osmium::Box{0.0, 0.0, 5.0, 5.0}, osmium::osm_entity_bits::node) == 8000);
+    REQUIRE(count(osmium::Box{40.0, 40.0, 60.0, 60.0}, osmium::osm_entity_bits::node) == 12000);
+    REQUIRE(count(osmium::Box{-10.0, -10.0, -5.0, -5.0}, osmium::osm_entity_bits::node) == 0);
+    REQUIRE(count(osmium::Box{}, osmium::osm_entity_bits::node) == 20000);
+
+    // blobs with ways (without locations) and relations are always read
+    REQUIRE(count(osmium::Box{-10.0, -10.0, -5.0, -5.0}, osmium::osm_entity_bits::object) == 110);
+}
+
+TEST_CASE("Loading something that is not a blob index fails") {
+    REQUIRE_THROWS_AS(osmium::io::PBFBlobIndex::load(with_data_dir("t/io/data.osm")), osmium::pbf_error);
+}
+
+TEST_CASE("Loading something that is not a blob index does not leak file descriptors") {
+    const int count = count_fds();
+    REQUIRE_THROWS_AS(osmium::io::PBFBlobIndex::load(with_data_dir("t/io/data.osm")), osmium::pbf_error);
+    REQUIRE(count == count_fds());
+}
+
+TEST_CASE("Create PBF blob index from truncated file") {
+    const std::string filename{"test-pbf-blob-index-truncated.osm.pbf"};
+    write_test_file(filename);
+
+    const std::string data = read_file(filename);
+    write_file(filename, data.substr(0, data.size() - 100));
+
+    const int count = count_fds();
+    REQUIRE_THROWS_AS(osmium::io::create_pbf_blob_index(filename), osmium::pbf_error);
+    REQUIRE(count == count_fds());
+}
@@ -0,0 +1,66 @@
+#include "catch.hpp"
+
+#include "pbf_test_data.hpp"
+
+#include <osmium/handler/node_locations_for_ways.hpp>
+#include <osmium/index/map/sparse_mem_array.hpp>
+#include <osmium/io/file.hpp>
+#include <osmium/io/pbf_node_columns_reader.hpp>
+#include <osmium/osm/location.hpp>
+
+#include <string>
+
+namespace {
+
+    void check_columns(const std::string& filename) {
+        osmium::io::PBFNodeColumnsReader reader{filename};
+
+        osmium::object_id_type expected_id = 1;
+        std::size_t num_blobs = 0;
+        for (auto columns = reader.read(); !columns.empty(); columns = reader.read()) {
+            ++num_blobs;
+            REQUIRE(columns.x().size() == columns.size());
+            REQUIRE(columns.y().size() == columns.size());
+            for (std::size_t n = 0; n < columns.size(); ++n) {
+                REQUIRE(columns.id(n) == expected_id);
+                REQUIRE(columns.location(n) == pbf_test_node_location(expected_id));
+                ++expected_id;
+            }
+        }
+
+        REQUIRE(expected_id == 20001);
+        REQUIRE(num_blobs == 3);
+        REQUIRE(reader.read().empty());
+        reader.close();
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Read node columns from PBF file with dense nodes") {
+    const std::string filename{"test-pbf-node-columns-dense.osm.pbf"};
+    write_pbf_test_file(osmium::io::File{filename});
+    check_columns(filename);
+}
+
+TEST_CASE("Read node columns from PBF file without dense nodes") {
+    const std::string filename{"test-pbf-node-columns-nodense.osm.pbf"};
+    write_pbf_test_file(osmium::io::File{filename, "pbf,pbf_dense_nodes=false"});
+    check_columns(filename);
+}
+
+TEST_CASE("Fill location index from node columns") {
+    const std::string filename{"test-pbf-node-columns-index.osm.pbf"};
+    write_pbf_test_file(osmium::io::File{filename});
+
+    using index_type = osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type, osmium::Location>;
+    index_type index;
+    osmium::handler::NodeLocationsForWays<index_type> handler{index};
+
+    osmium::io::PBFNodeColumnsReader reader{filename};
+    osmium::io::apply_node_columns(reader, handler);
+
+    REQUIRE(index.size() == 20000);
+    REQUIRE(handler.get_node_location(1) == pbf_test_node_location(1));
+    REQUIRE(handler.get_node_location(12345) == pbf_test_node_location(12345));
+    REQUIRE_FALSE(handler.get_node_location(20001).valid());
+}
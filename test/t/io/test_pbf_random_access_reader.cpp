@@ -0,0 +1,111 @@
+#include "catch.hpp"
+
+#include "pbf_test_data.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/pbf_output.hpp>
+#include <osmium/io/pbf_random_access_reader.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <string>
+
+TEST_CASE("Random access to objects in sorted PBF file") {
+    const std::string filename{"test-pbf-random-access.osm.pbf"};
+    write_pbf_test_file(osmium::io::File{filename});
+
+    osmium::io::PBFRandomAccessReader reader{filename, 2};
+    REQUIRE(reader.sorted());
+    REQUIRE(reader.index().size() == 5);
+    REQUIRE(reader.num_cached_blobs() == 0);
+
+    for (const osmium::object_id_type id : {1, 7999, 8000, 8001, 12345, 20000}) {
+        const auto* node = reader.get<osmium::Node>(id);
+        REQUIRE(node);
+        REQUIRE(node->id() == id);
+        REQUIRE(std::string{node->tags()["id"]} == std::to_string(id));
+    }
+    REQUIRE(reader.num_cached_blobs() == 2);
+
+    REQUIRE_FALSE(reader.get<osmium::Node>(0));
+    REQUIRE_FALSE(reader.get<osmium::Node>(20001));
+
+    const auto* way = reader.get<osmium::Way>(42);
+    REQUIRE(way);
+    REQUIRE(way->nodes().size() == 2);
+    REQUIRE(way->nodes()[0].ref() == 42);
+    REQUIRE_FALSE(reader.get<osmium::Way>(101));
+
+    const auto* relation = reader.get<osmium::Relation>(10);
+    REQUIRE(relation);
+    REQUIRE(relation->members().begin()->ref() == 10);
+    REQUIRE(reader.get(osmium::item_type::relation, 3)->id() == 3);
+
+    REQUIRE(reader.num_cached_blobs() == 2);
+    reader.close();
+    REQUIRE(reader.num_cached_blobs() == 0);
+}
+
+TEST_CASE("Random access to objects in unsorted PBF file") {
+    const std::string filename{"test-pbf-random-access-unsorted.osm.pbf"};
+    write_pbf_test_file(osmium::io::File{filename}, false);
+
+    osmium::io::PBFRandomAccessReader reader{filename};
+    REQUIRE_FALSE(reader.sorted());
+
+    for (const osmium::object_id_type id : {1, 5000, 10000, 10001, 15000, 20000}) {
+        const auto* node = reader.get<osmium::Node>(id);
+        REQUIRE(node);
+        REQUIRE(node->id() == id);
+    }
+    REQUIRE_FALSE(reader.get<osmium::Node>(20001));
+    REQUIRE(reader.get<osmium::Way>(100));
+}
+
+TEST_CASE("Random access with index from sidecar file") {
+    const std::string filename{"test-pbf-random-access-sidecar.osm.pbf"};
+    write_pbf_test_file(osmium::io::File{filename});
+
+    const std::string index_filename{filename + ".idx"};
+    osmium::io::create_pbf_blob_index(filename).save(index_filename);
+
+    osmium::io::PBFRandomAccessReader reader{filename, osmium::io::PBFBlobIndex::load(index_filename)};
+    REQUIRE(reader.get<osmium::Node>(17)->id() == 17);
+
+    const osmium::io::PBFBlobIndex wrong_index{1};
+    REQUIRE_THROWS_AS(osmium::io::PBFRandomAccessReader(filename, wrong_index), osmium::pbf_error);
+}
+
+TEST_CASE("Random access to last version of object in history file") {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    // Each blob contains 8000 nodes, so the versions of node 8000 end up
+    // in two blobs.
+    osmium::memory::Buffer buffer{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+    for (osmium::object_id_type id = 1; id <= 12000; ++id) {
+        osmium::builder::add_node(buffer, _id(id), _version(1), _location(1.0, 2.0));
+        if (id == 8000) {
+            osmium::builder::add_node(buffer, _id(id), _version(2), _location(1.0, 2.0));
+        }
+    }
+
+    const std::string filename{"test-pbf-random-access-history.osh.pbf"};
+    osmium::io::Writer writer{filename, osmium::io::overwrite::allow};
+    writer(std::move(buffer));
+    writer.close();
+
+    osmium::io::PBFRandomAccessReader reader{filename};
+    REQUIRE(reader.sorted());
+    REQUIRE(reader.index().size() == 2);
+    REQUIRE(reader.index()[0].max_id == 8000);
+    REQUIRE(reader.index()[1].min_id == 8000);
+
+    const auto* node = reader.get<osmium::Node>(8000);
+    REQUIRE(node);
+    REQUIRE(node->version() == 2);
+    REQUIRE(reader.get<osmium::Node>(7999)->version() == 1);
+    REQUIRE(reader.get<osmium::Node>(8001)->version() == 1);
+}
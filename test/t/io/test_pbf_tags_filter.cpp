@@ -0,0 +1,118 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/file.hpp>
+#include <osmium/io/pbf_input.hpp>
+#include <osmium/io/pbf_output.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/tags/tags_filter.hpp>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+    void write_test_file(const osmium::io::File& file) {
+        using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+        osmium::memory::Buffer buffer{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+
+        // first two blocks of nodes without any matching tags
+        for (osmium::object_id_type id = 1; id <= 16000; ++id) {
+            osmium::builder::add_node(buffer, _id(id), _version(1), _cid(id), _uid(id), _user("foo"), _location(1.0, 2.0), _tag("name", "x"));
+        }
+        // some matching nodes in the third block
+        for (osmium::object_id_type id = 16001; id <= 16100; ++id) {
+            if (id % 10 == 0) {
+                osmium::builder::add_node(buffer, _id(id), _version(2), _cid(id), _uid(id), _user("bar"), _location(1.0, 2.0), _tag("name", "y"), _tag("amenity", "cafe"));
+            } else {
+                osmium::builder::add_node(buffer, _id(id), _version(2), _cid(id), _uid(id), _user("bar"), _location(1.0, 2.0));
+            }
+        }
+
+        osmium::builder::add_way(buffer, _id(1), _version(1), _nodes({1, 2}), _tag("highway", "primary"));
+        osmium::builder::add_way(buffer, _id(2), _version(1), _nodes({2, 3}), _tag("highway", "motorway"));
+        osmium::builder::add_way(buffer, _id(3), _version(1), _nodes({3, 4}), _tag("name", "highway"));
+        osmium::builder::add_relation(buffer, _id(1), _version(1), _member(osmium::item_type::way, 1, "amenity"));
+        osmium::builder::add_relation(buffer, _id(2), _version(1), _member(osmium::item_type::way, 1), _tag("amenity", "parking"));
+
+        osmium::io::Writer writer{file, osmium::io::overwrite::allow};
+        writer(std::move(buffer));
+        writer.close();
+    }
+
+    osmium::TagsFilter make_filter() {
+        osmium::TagsFilter filter{false};
+        filter.add_rule(false, "highway", "motorway");
+        filter.add_rule(true, "highway");
+        filter.add_rule(true, "amenity");
+        return filter;
+    }
+
+    template <typename... TArgs>
+    std::vector<std::string> read_ids(const std::string& filename, TArgs&&... args) {
+        osmium::io::Reader reader{filename, make_filter(), std::forward<TArgs>(args)...};
+
+        std::vector<std::string> ids;
+        while (const auto buffer = reader.read()) {
+            for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                ids.push_back(osmium::item_type_to_char(object.type()) + std::to_string(object.id()));
+            }
+        }
+        reader.close();
+
+        return ids;
+    }
+
+    const std::vector<std::string> expected_ids = {
+        "n16010", "n16020", "n16030", "n16040", "n16050",
+        "n16060", "n16070", "n16080", "n16090", "n16100",
+        "w1", "r2"
+    };
+
+} // anonymous namespace
+
+TEST_CASE("Read PBF file with tags filter") {
+    const std::string filename{"test-pbf-tags-filter.osm.pbf"};
+    write_test_file(osmium::io::File{filename});
+
+    SECTION("with metadata") {
+        REQUIRE(read_ids(filename) == expected_ids);
+    }
+
+    SECTION("without metadata") {
+        REQUIRE(read_ids(filename, osmium::io::read_meta::no) == expected_ids);
+    }
+
+    SECTION("without tags") {
+        REQUIRE(read_ids(filename, osmium::io::read_fields::nothing) == expected_ids);
+    }
+}
+
+TEST_CASE("Read PBF file without DenseNodes with tags filter") {
+    const std::string filename{"test-pbf-tags-filter-nodense.osm.pbf"};
+    write_test_file(osmium::io::File{filename, "pbf,pbf_dense_nodes=false"});
+
+    REQUIRE(read_ids(filename) == expected_ids);
+}
+
+TEST_CASE("Tags filter keeps tags and metadata of matching objects") {
+    const std::string filename{"test-pbf-tags-filter-keep.osm.pbf"};
+    write_test_file(osmium::io::File{filename});
+
+    osmium::io::Reader reader{filename, make_filter(), osmium::osm_entity_bits::node};
+    const auto buffer = reader.read();
+    reader.close();
+
+    const auto& node = *buffer.select<osmium::Node>().begin();
+    REQUIRE(node.id() == 16010);
+    REQUIRE(node.changeset() == 16010);
+    REQUIRE(node.uid() == 16010);
+    REQUIRE(std::string{node.user()} == "bar");
+    REQUIRE(node.tags().size() == 2);
+    REQUIRE(std::string{node.tags()["amenity"]} == "cafe");
+}
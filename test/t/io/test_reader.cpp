@@ -2,14 +2,22 @@
 
 #include "utils.hpp"
 
+#include <osmium/builder/attr.hpp>
 #include <osmium/handler.hpp>
 #include <osmium/io/any_compression.hpp>
 #include <osmium/io/any_input.hpp>
+#include <osmium/io/any_output.hpp>
 #include <osmium/memory/buffer.hpp>
+#include <osmium/osm/metadata_options.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/way.hpp>
 #include <osmium/visitor.hpp>
 
+#include <algorithm>
 #include <iterator>
 #include <stdexcept>
+#include <string>
+#include <utility>
 #include <vector>
 
 struct CountHandler : public osmium::handler::Handler {
@@ -378,3 +386,194 @@ TEST_CASE("Reader with single object type per buffer") {
     check_buffer_counts("t/io/data-n5w1r0", {{5, 0, 0}, {0, 1, 0}}, osmium::io::buffers_type::single);
 }
 
+
+void check_read_fields(const std::string& filename) {
+    osmium::metadata_options metadata{"version+changeset"};
+    osmium::io::Reader reader{filename, osmium::io::read_fields::way_nodes, metadata};
+
+    int count = 0;
+    while (const osmium::memory::Buffer buffer = reader.read()) {
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            ++count;
+            REQUIRE(object.version() == 1);
+            REQUIRE(object.changeset() == 1);
+            REQUIRE_FALSE(object.timestamp().valid());
+            REQUIRE(object.uid() == 0);
+            REQUIRE(std::string{object.user()}.empty());
+            REQUIRE(object.tags().empty());
+            if (object.type() == osmium::item_type::way) {
+                REQUIRE(static_cast<const osmium::Way&>(object).nodes().size() == 2);
+            } else if (object.type() == osmium::item_type::relation) {
+                REQUIRE(static_cast<const osmium::Relation&>(object).members().empty());
+            }
+        }
+    }
+    reader.close();
+
+    REQUIRE(count == 9);
+}
+
+TEST_CASE("Reader only reads requested fields") {
+    const std::string filename = with_data_dir("t/io/data-n5w1r3");
+
+    SECTION("XML") {
+        check_read_fields(filename + ".osm");
+    }
+
+    SECTION("O5M") {
+        check_read_fields(filename + ".osm.o5m");
+    }
+
+    SECTION("PBF") {
+        const std::string pbf_filename{"test-reader-read-fields.osm.pbf"};
+        {
+            osmium::io::Reader reader{filename + ".osm"};
+            osmium::io::Writer writer{pbf_filename, osmium::io::overwrite::allow};
+            while (osmium::memory::Buffer buffer = reader.read()) {
+                writer(std::move(buffer));
+            }
+            writer.close();
+            reader.close();
+        }
+        check_read_fields(pbf_filename);
+    }
+}
+
+TEST_CASE("Reader returns PBF buffers in any order if asked to") {
+    const std::string filename{"test-reader-read-order.osm.pbf"};
+    {
+        osmium::memory::Buffer buffer{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+        for (osmium::object_id_type id = 1; id <= 30000; ++id) {
+            osmium::builder::add_node(buffer, osmium::builder::attr::_id(id));
+        }
+        osmium::io::Writer writer{filename, osmium::io::overwrite::allow};
+        writer(std::move(buffer));
+        writer.close();
+    }
+
+    std::vector<std::pair<std::size_t, osmium::object_id_type>> file_order;
+    {
+        osmium::io::Reader reader{filename};
+        while (const osmium::memory::Buffer buffer = reader.read()) {
+            file_order.emplace_back(buffer.sequence(), buffer.select<osmium::Node>().cbegin()->id());
+        }
+        reader.close();
+    }
+
+    std::vector<std::pair<std::size_t, osmium::object_id_type>> any_order;
+    std::size_t count = 0;
+    {
+        osmium::io::Reader reader{filename, osmium::io::read_order::any};
+        while (const osmium::memory::Buffer buffer = reader.read()) {
+            any_order.emplace_back(buffer.sequence(), buffer.select<osmium::Node>().cbegin()->id());
+            count += std::distance(buffer.select<osmium::Node>().cbegin(), buffer.select<osmium::Node>().cend());
+        }
+        reader.close();
+    }
+
+    REQUIRE(count == 30000);
+    REQUIRE(file_order.front().first == 1);
+    REQUIRE(file_order.back().first == 4);
+    REQUIRE(std::is_sorted(file_order.cbegin(), file_order.cend(), [](const std::pair<std::size_t, osmium::object_id_type>& lhs,
+                                                                      const std::pair<std::size_t, osmium::object_id_type>& rhs) {
+        return lhs.first < rhs.first;
+    }));
+
+    std::sort(file_order.begin(), file_order.end());
+    std::sort(any_order.begin(), any_order.end());
+    REQUIRE(any_order == file_order);
+}
+
+TEST_CASE("Reader with any read order and Writer sharing a small pool") {
+    const std::string filename{"test-reader-read-order-pool.osm.pbf"};
+    const std::string filename_copy{"test-reader-read-order-pool-copy.osm.pbf"};
+    {
+        osmium::memory::Buffer buffer{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+        for (osmium::object_id_type id = 1; id <= 200000; ++id) {
+            osmium::builder::add_node(buffer, osmium::builder::attr::_id(id));
+        }
+        osmium::io::Writer writer{filename, osmium::io::overwrite::allow};
+        writer(std::move(buffer));
+        writer.close();
+    }
+
+    // The decoder tasks of the reader must not block the only pool
+    // thread while the writer needs it.
+    osmium::thread::Pool pool{1};
+    osmium::io::Reader reader{filename, osmium::io::read_order::any, pool, osmium::io::max_queue_bytes{1}};
+    osmium::io::Writer writer{filename_copy, osmium::io::overwrite::allow, pool, osmium::io::max_queue_bytes{1}};
+    std::size_t count = 0;
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        count += std::distance(buffer.select<osmium::Node>().cbegin(), buffer.select<osmium::Node>().cend());
+        writer(std::move(buffer));
+    }
+    writer.close();
+    reader.close();
+
+    REQUIRE(count == 200000);
+}
+
+TEST_CASE("Reader and Writer with small byte limit on queues") {
+    const std::string filename{"test-reader-max-queue-bytes.osm.pbf"};
+    {
+        osmium::memory::Buffer buffer{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+        for (osmium::object_id_type id = 1; id <= 30000; ++id) {
+            osmium::builder::add_node(buffer, osmium::builder::attr::_id(id));
+        }
+        osmium::io::Writer writer{filename, osmium::io::overwrite::allow, osmium::io::max_queue_bytes{1}};
+        writer(std::move(buffer));
+        writer.close();
+    }
+
+    osmium::io::Reader reader{filename, osmium::io::max_queue_bytes{1}};
+    CountHandler handler;
+    osmium::apply(reader, handler);
+    reader.close();
+
+    REQUIRE(handler.count == 30000);
+}
+
+TEST_CASE("Reader collects statistics") {
+    osmium::io::Reader reader{with_data_dir("t/io/data.osm")};
+    REQUIRE(reader.stats().osmdata_queue.pop_count == 0);
+
+    CountHandler handler;
+    osmium::apply(reader, handler);
+    reader.close();
+    REQUIRE(handler.count == 1);
+
+    const auto stats = reader.stats();
+    REQUIRE(stats.bytes_read == reader.file_size());
+    REQUIRE(stats.parse_time.count() > 0);
+    REQUIRE(stats.decompress_time.count() == 0);
+    REQUIRE(stats.input_queue.push_count > 0);
+    REQUIRE(stats.osmdata_queue.push_count > 0);
+    REQUIRE(stats.osmdata_queue.pop_count > 0);
+}
+
+TEST_CASE("Reader collects statistics for PBF file") {
+    const std::string filename{"test-reader-stats.osm.pbf"};
+    {
+        osmium::memory::Buffer buffer{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+        for (osmium::object_id_type id = 1; id <= 1000; ++id) {
+            osmium::builder::add_node(buffer, osmium::builder::attr::_id(id));
+        }
+        osmium::io::Writer writer{filename, osmium::io::overwrite::allow};
+        writer(std::move(buffer));
+        writer.close();
+    }
+
+    osmium::io::Reader reader{filename};
+
+    CountHandler handler;
+    osmium::apply(reader, handler);
+    reader.close();
+    REQUIRE(handler.count == 1000);
+
+    const auto stats = reader.stats();
+    REQUIRE(stats.bytes_read == reader.file_size());
+    REQUIRE(stats.read_time.count() > 0);
+    REQUIRE(stats.decompress_time.count() > 0);
+    REQUIRE(stats.parse_time.count() > 0);
+    REQUIRE(stats.osmdata_queue.push_count > 0);
+}
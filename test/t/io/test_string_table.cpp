@@ -6,75 +6,6 @@
 #include <iterator>
 #include <string>
 
-TEST_CASE("Empty StringStore") {
-    const osmium::io::detail::StringStore ss{100};
-
-    REQUIRE(ss.begin() == ss.end());
-    REQUIRE(ss.get_chunk_size() == 100);
-    REQUIRE(ss.get_chunk_count() == 1);
-}
-
-TEST_CASE("Add zero-length string to StringStore") {
-    osmium::io::detail::StringStore ss{100};
-
-    const char* s1 = ss.add("");
-    REQUIRE(std::string{s1}.empty());
-
-    auto it = ss.begin();
-    REQUIRE(s1 == *it);
-    REQUIRE(std::string{*it}.empty());
-    REQUIRE(++it == ss.end());
-
-    REQUIRE(ss.get_chunk_count() == 1);
-}
-
-TEST_CASE("Add strings to StringStore") {
-    osmium::io::detail::StringStore ss{100};
-
-    const char* s1 = ss.add("foo");
-    const char* s2 = ss.add("bar");
-    REQUIRE(s1 != s2);
-    REQUIRE(std::string{s1} == "foo");
-    REQUIRE(std::string{s2} == "bar");
-
-    auto it = ss.begin();
-    REQUIRE(s1 == *it++);
-    REQUIRE(s2 == *it++);
-    REQUIRE(it == ss.end());
-}
-
-TEST_CASE("Add zero-length string and longer strings to StringStore") {
-    osmium::io::detail::StringStore ss{100};
-
-    ss.add("");
-    ss.add("xxx");
-    ss.add("yyyyy");
-
-    auto it = ss.begin();
-    REQUIRE(std::string{*it++}.empty());
-    REQUIRE(std::string{*it++} == "xxx");
-    REQUIRE(std::string{*it++} == "yyyyy");
-    REQUIRE(it == ss.end());
-}
-
-TEST_CASE("Add many strings to StringStore") {
-    for (const char* teststring : {"", "a", "abc", "abcd", "abcde"}) {
-        osmium::io::detail::StringStore ss{100};
-        int i = 0;
-        for (; i < 200; ++i) {
-            ss.add(teststring);
-        }
-
-        for (const char* s : ss) {
-            REQUIRE(std::string{s} == teststring);
-            --i;
-        }
-
-        REQUIRE(i == 0);
-        REQUIRE(ss.get_chunk_count() > 1);
-    }
-}
-
 TEST_CASE("Empty StringTable") {
     const osmium::io::detail::StringTable st;
 
@@ -129,3 +60,68 @@ TEST_CASE("Lots of strings in string table so chunk overflows") {
     REQUIRE(it == st.end());
 }
 
+
+TEST_CASE("Clear StringTable and reuse it") {
+    osmium::io::detail::StringTable st;
+
+    REQUIRE(st.add("foo") == 1);
+    REQUIRE(st.add("bar") == 2);
+
+    st.clear();
+    REQUIRE(st.size() == 1);
+    REQUIRE(std::next(st.begin()) == st.end());
+
+    REQUIRE(st.add("bar") == 1);
+    REQUIRE(st.add("baz") == 2);
+    REQUIRE(st.add("bar") == 1);
+    REQUIRE(st.size() == 3);
+
+    auto it = st.begin();
+    REQUIRE(std::string{} == *it++);
+    REQUIRE(std::string{"bar"} == *it++);
+    REQUIRE(std::string{"baz"} == *it++);
+    REQUIRE(it == st.end());
+}
+
+TEST_CASE("Clear StringTable many times after growing it") {
+    osmium::io::detail::StringTable st;
+
+    for (int round = 0; round < 100; ++round) {
+        st.clear();
+        for (int i = 0; i < 5000; ++i) {
+            const auto s = std::to_string(i + round);
+            REQUIRE(st.add(s.c_str()) == i + 1);
+        }
+        REQUIRE(st.size() == 5001);
+        REQUIRE(st.add(std::to_string(round).c_str()) == 1);
+    }
+}
+
+TEST_CASE("Sort StringTable by frequency") {
+    osmium::io::detail::StringTable st;
+
+    st.add("rare");
+    st.add("often");
+    st.add("sometimes");
+    st.add("often");
+    st.add("sometimes");
+    st.add("often");
+    st.add("also rare");
+
+    st.sort_by_frequency();
+    REQUIRE(st.size() == 5);
+
+    auto it = st.begin();
+    REQUIRE(std::string{} == *it++);
+    REQUIRE(std::string{"often"} == *it++);
+    REQUIRE(std::string{"sometimes"} == *it++);
+    REQUIRE(std::string{"rare"} == *it++);
+    REQUIRE(std::string{"also rare"} == *it++);
+    REQUIRE(it == st.end());
+
+    REQUIRE(st.add("often") == 1);
+    REQUIRE(st.add("sometimes") == 2);
+    REQUIRE(st.add("rare") == 3);
+    REQUIRE(st.add("also rare") == 4);
+    REQUIRE(st.add("new") == 5);
+}
@@ -223,3 +223,44 @@ TEST_CASE("Writer with user-provided pool with outlier positive number of thread
     REQUIRE(count == count_fds());
 }
 
+
+TEST_CASE("Writer collects statistics") {
+    auto buffer = get_buffer();
+    osmium::io::Writer writer{"test-writer-stats.osm", osmium::io::overwrite::allow};
+    REQUIRE(writer.stats().bytes_written == 0);
+    writer(std::move(buffer));
+    const auto size = writer.close();
+
+    const auto stats = writer.stats();
+    REQUIRE(stats.bytes_written == size);
+    REQUIRE(stats.encode_time.count() > 0);
+    REQUIRE(stats.write_time.count() > 0);
+    REQUIRE(stats.compress_time.count() == 0);
+    REQUIRE(stats.output_queue.push_count > 0);
+    REQUIRE(stats.output_queue.push_count == stats.output_queue.pop_count);
+}
+
+TEST_CASE("Writer writes gzip file in BGZF format if gzip_blocks option is set") {
+    const int count = count_fds();
+
+    auto buffer = get_buffer();
+    const auto num = std::distance(buffer.select<osmium::OSMObject>().cbegin(), buffer.select<osmium::OSMObject>().cend());
+
+    osmium::io::File file{"test-writer-out-blocks.osm.gz"};
+    file.set("gzip_blocks", true);
+    osmium::io::Writer writer{file, osmium::io::overwrite::allow};
+    writer(std::move(buffer));
+    writer.close();
+
+    REQUIRE(count == count_fds());
+
+    osmium::io::Reader reader{"test-writer-out-blocks.osm.gz"};
+    const auto buffer_check = reader.read();
+    reader.close();
+
+    REQUIRE(buffer_check);
+    REQUIRE(std::distance(buffer_check.select<osmium::OSMObject>().cbegin(), buffer_check.select<osmium::OSMObject>().cend()) == num);
+    REQUIRE(reader.offset() == reader.file_size());
+
+    REQUIRE(count == count_fds());
+}
@@ -0,0 +1,214 @@
+#include "catch.hpp"
+
+#include "utils.hpp"
+
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/zstd_compression.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/options.hpp>
+
+#include <zstd.h>
+
+#include <atomic>
+#include <cstddef>
+#include <fcntl.h>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+static std::string zstd_test_data() {
+    std::string data;
+    for (int i = 0; i < 100000; ++i) {
+        data += "TESTDATA ";
+        data += std::to_string(i);
+        data += '\n';
+    }
+    return data;
+}
+
+static std::string read_all(osmium::io::Decompressor& decomp) {
+    std::string all;
+    for (std::string data = decomp.read(); !data.empty(); data = decomp.read()) {
+        all += data;
+    }
+    return all;
+}
+
+TEST_CASE("Non-open file descriptor of zstd-compressed file") {
+    // 12345 is just a random file descriptor that should not be open
+    osmium::io::ZstdDecompressor decomp{12345};
+    REQUIRE_THROWS_AS(decomp.read(), std::system_error);
+}
+
+TEST_CASE("Empty zstd-compressed file") {
+    const int count = count_fds();
+
+    const std::string input_file = with_data_dir("t/io/empty_file");
+    const int fd = osmium::io::detail::open_for_reading(input_file);
+    REQUIRE(fd > 0);
+
+    osmium::io::ZstdDecompressor decomp{fd};
+    REQUIRE(decomp.read().empty());
+    decomp.close();
+
+    REQUIRE(count == count_fds());
+}
+
+TEST_CASE("Compressor: Invalid file descriptor for zstd-compressed file") {
+    osmium::io::ZstdCompressor comp{-1, osmium::io::fsync::no};
+    comp.write("foo");
+    REQUIRE_THROWS_AS(comp.close(), std::system_error);
+}
+
+TEST_CASE("Write and read zstd-compressed file") {
+    const int count = count_fds();
+    const std::string input = zstd_test_data();
+
+    const std::string output_file = "test_zstd_out.txt.zst";
+    const int fd = osmium::io::detail::open_for_writing(output_file, osmium::io::overwrite::allow);
+    REQUIRE(fd > 0);
+
+    {
+        osmium::io::ZstdCompressor comp{fd, osmium::io::fsync::no};
+        comp.write(input.substr(0, 1000));
+        comp.write(input.substr(1000));
+        comp.close();
+        REQUIRE(comp.file_size() == osmium::file_size(output_file));
+    }
+
+    REQUIRE(count == count_fds());
+    REQUIRE(osmium::file_size(output_file) < input.size() / 2);
+
+    const int in_fd = osmium::io::detail::open_for_reading(output_file);
+    REQUIRE(in_fd > 0);
+    {
+        std::atomic<std::size_t> offset{0};
+        osmium::io::ZstdDecompressor decomp{in_fd};
+        decomp.set_offset_ptr(&offset);
+        REQUIRE(read_all(decomp) == input);
+        REQUIRE(offset == osmium::file_size(output_file));
+    }
+
+    REQUIRE(count == count_fds());
+}
+
+TEST_CASE("Write zstd-compressed file readable by libzstd") {
+    const std::string output_file = "test_zstd_out_libzstd.txt.zst";
+    const int fd = osmium::io::detail::open_for_writing(output_file, osmium::io::overwrite::allow);
+    REQUIRE(fd > 0);
+
+    {
+        osmium::io::ZstdCompressor comp{fd, osmium::io::fsync::no};
+        comp.write("TESTDATA");
+    }
+
+    const std::string compressed = read_file(output_file);
+    std::string output(100, '\0');
+    const auto size = ZSTD_decompress(&*output.begin(), output.size(), compressed.data(), compressed.size());
+    REQUIRE_FALSE(ZSTD_isError(size));
+    output.resize(size);
+    REQUIRE(output == "TESTDATA");
+}
+
+TEST_CASE("Write zstd-compressed file with compression level") {
+    const std::string input = zstd_test_data();
+
+    osmium::Options options;
+    options.set("zstd_level", "1");
+
+    const std::string output_file = "test_zstd_out_level.txt.zst";
+    const int fd = osmium::io::detail::open_for_writing(output_file, osmium::io::overwrite::allow);
+    REQUIRE(fd > 0);
+
+    {
+        osmium::io::ZstdCompressor comp{fd, osmium::io::fsync::no};
+        comp.set_options(options);
+        comp.write(input);
+    }
+
+    REQUIRE(decompress_file<osmium::io::ZstdDecompressor>(output_file) == input);
+}
+
+TEST_CASE("Invalid zstd compression level") {
+    const int fd = osmium::io::detail::open_for_writing("test_zstd_out_invalid_level.txt.zst", osmium::io::overwrite::allow);
+    REQUIRE(fd > 0);
+    osmium::io::ZstdCompressor comp{fd, osmium::io::fsync::no};
+
+    osmium::Options options;
+    options.set("zstd_level", "foo");
+    REQUIRE_THROWS_AS(comp.set_options(options), std::invalid_argument);
+
+    options.set("zstd_level", "1000");
+    REQUIRE_THROWS_AS(comp.set_options(options), std::invalid_argument);
+}
+
+TEST_CASE("Read zstd-compressed file with several frames") {
+    const int count = count_fds();
+
+    std::string compressed;
+    std::string input;
+    for (int i = 0; i < 3; ++i) {
+        const std::string part = "frame " + std::to_string(i) + "\n";
+        std::string frame(ZSTD_compressBound(part.size()), '\0');
+        const auto size = ZSTD_compress(&*frame.begin(), frame.size(), part.data(), part.size(), 3);
+        REQUIRE_FALSE(ZSTD_isError(size));
+        frame.resize(size);
+        compressed += frame;
+        input += part;
+    }
+
+    const std::string file_name = "test_zstd_frames.txt.zst";
+    write_file(file_name, compressed);
+
+    REQUIRE(decompress_file<osmium::io::ZstdDecompressor>(file_name) == input);
+
+    osmium::io::ZstdBufferDecompressor decomp{compressed.data(), compressed.size()};
+    REQUIRE(read_all(decomp) == input);
+
+    REQUIRE(count == count_fds());
+}
+
+TEST_CASE("Truncated zstd-compressed file") {
+    const std::string input = zstd_test_data();
+    std::string compressed(ZSTD_compressBound(input.size()), '\0');
+    const auto size = ZSTD_compress(&*compressed.begin(), compressed.size(), input.data(), input.size(), 3);
+    REQUIRE_FALSE(ZSTD_isError(size));
+    compressed.resize(size / 2);
+
+    const std::string file_name = "test_zstd_truncated.txt.zst";
+    write_file(file_name, compressed);
+
+    REQUIRE_THROWS_AS(decompress_file<osmium::io::ZstdDecompressor>(file_name), osmium::zstd_error);
+
+    osmium::io::ZstdBufferDecompressor buffer_decomp{compressed.data(), compressed.size()};
+    REQUIRE_THROWS_AS(read_all(buffer_decomp), osmium::zstd_error);
+}
+
+TEST_CASE("Corrupted zstd-compressed file") {
+    const std::string file_name = "test_zstd_corrupt.txt.zst";
+    write_file(file_name, "this is not zstd-compressed");
+
+    const int fd = osmium::io::detail::open_for_reading(file_name);
+    REQUIRE(fd > 0);
+    osmium::io::ZstdDecompressor decomp{fd};
+    REQUIRE_THROWS_AS(decomp.read(), osmium::zstd_error);
+}
+
+#ifdef __linux__
+TEST_CASE("Write zstd-compressed file to full disk") {
+    const int count = count_fds();
+
+    const int fd = ::open("/dev/full", O_WRONLY); // NOLINT(hicpp-vararg,cppcoreguidelines-pro-type-vararg)
+    if (fd < 0) {
+        return;
+    }
+
+    {
+        osmium::io::ZstdCompressor comp{fd, osmium::io::fsync::no};
+        comp.write("foo");
+        REQUIRE_THROWS_AS(comp.close(), std::system_error);
+    }
+
+    REQUIRE(count == count_fds());
+}
+#endif
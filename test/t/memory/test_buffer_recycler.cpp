@@ -0,0 +1,91 @@
+#include "catch.hpp"
+
+#include <osmium/memory/buffer.hpp>
+#include <osmium/memory/buffer_recycler.hpp>
+
+#include <array>
+#include <utility>
+
+TEST_CASE("Get buffer from empty recycler") {
+    osmium::memory::BufferRecycler recycler;
+    REQUIRE(recycler.size() == 0);
+
+    const auto buffer = recycler.get(1000);
+    REQUIRE(buffer);
+    REQUIRE(buffer.capacity() >= 1000);
+    REQUIRE(buffer.committed() == 0);
+}
+
+TEST_CASE("Recycled buffer is reused") {
+    osmium::memory::BufferRecycler recycler;
+
+    osmium::memory::Buffer buffer{10000};
+    buffer.reserve_space(104);
+    buffer.commit();
+    const auto* data = buffer.data();
+
+    recycler.put(std::move(buffer));
+    REQUIRE(recycler.size() == 1);
+
+    const auto reused = recycler.get(1000);
+    REQUIRE(recycler.size() == 0);
+    REQUIRE(reused.data() == data);
+    REQUIRE(reused.capacity() >= 10000);
+    REQUIRE(reused.committed() == 0);
+}
+
+TEST_CASE("Recycled buffer grows if it is too small") {
+    osmium::memory::BufferRecycler recycler;
+    recycler.put(osmium::memory::Buffer{1000});
+
+    const auto buffer = recycler.get(20000);
+    REQUIRE(buffer.capacity() >= 20000);
+}
+
+TEST_CASE("Nested buffers are recycled too") {
+    osmium::memory::BufferRecycler recycler;
+
+    osmium::memory::Buffer buffer{128, osmium::memory::Buffer::auto_grow::internal};
+    for (int i = 0; i < 10; ++i) {
+        buffer.reserve_space(64);
+        buffer.commit();
+    }
+    REQUIRE(buffer.has_nested_buffers());
+
+    recycler.put(std::move(buffer));
+    REQUIRE(recycler.size() > 1);
+}
+
+TEST_CASE("Recycler ignores invalid buffers and buffers with external memory") {
+    osmium::memory::BufferRecycler recycler;
+
+    recycler.put(osmium::memory::Buffer{});
+
+    alignas(osmium::memory::align_bytes) std::array<unsigned char, 64> data{};
+    recycler.put(osmium::memory::Buffer{data.data(), data.size(), 0});
+
+    REQUIRE(recycler.size() == 0);
+}
+
+TEST_CASE("Recycler keeps only a limited number of buffers") {
+    osmium::memory::BufferRecycler recycler{2};
+
+    for (int i = 0; i < 5; ++i) {
+        recycler.put(osmium::memory::Buffer{100});
+    }
+    REQUIRE(recycler.size() == 2);
+}
+
+TEST_CASE("Recycler handle does not use the recycler after it was detached") {
+    osmium::memory::BufferRecycler recycler;
+    recycler.put(osmium::memory::Buffer{100});
+    recycler.put(osmium::memory::Buffer{100});
+
+    osmium::memory::detail::recycler_handle handle{recycler};
+    REQUIRE(handle.get(100));
+    REQUIRE(recycler.size() == 1);
+
+    handle.detach();
+    REQUIRE(handle.get(100));
+    REQUIRE(recycler.size() == 1);
+}
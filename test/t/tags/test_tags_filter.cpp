@@ -45,6 +45,28 @@ TEST_CASE("Tags filter") {
         REQUIRE_FALSE(filter(*std::next(tag_list2.begin())));
     }
 
+    SECTION("Filter on key and value strings") {
+        osmium::TagsFilter filter;
+        filter.add_rule(false, "highway", "motorway");
+        filter.add_rule(true, "highway");
+        REQUIRE(filter("highway", "primary"));
+        REQUIRE_FALSE(filter("highway", "motorway"));
+        REQUIRE_FALSE(filter("name", "primary"));
+    }
+
+    SECTION("Match keys only") {
+        osmium::TagsFilter filter{true};
+        filter.add_rule(false, "source");
+        filter.add_rule(true, "highway", "primary");
+
+        bool result = false;
+        REQUIRE(filter.match_key("source", result));
+        REQUIRE_FALSE(result);
+        REQUIRE(filter.match_key("name", result));
+        REQUIRE(result);
+        REQUIRE_FALSE(filter.match_key("highway", result));
+    }
+
     SECTION("Filter based on key only: fail") {
         osmium::TagsFilter filter;
         filter.add_rule(true, osmium::StringMatcher::equal{"foo"});
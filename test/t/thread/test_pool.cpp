@@ -2,7 +2,10 @@
 
 #include <osmium/thread/pool.hpp>
 
+#include <atomic>
+#include <future>
 #include <stdexcept>
+#include <vector>
 
 struct test_job_with_result {
     int operator()() const {
@@ -43,6 +46,11 @@ TEST_CASE("number of threads in pool") {
     REQUIRE(osmium::thread::detail::get_pool_size(-100, 0, 16) ==  1);
     REQUIRE(osmium::thread::detail::get_pool_size(1000, 0, 16) == 32);
 
+    // more cores than the default maximum
+    REQUIRE(osmium::thread::detail::get_pool_size(  64, 0, 128) ==  64);
+    REQUIRE(osmium::thread::detail::get_pool_size(1000, 0, 128) == 128);
+    REQUIRE(osmium::thread::detail::get_pool_size(   0, 0, 128) == 126);
+
 }
 
 TEST_CASE("if zero number of threads requested, threads configured") {
@@ -104,3 +112,53 @@ TEST_CASE("can throw from job in user provided thread pool") {
     REQUIRE_THROWS_AS(future.get(), std::runtime_error);
 }
 
+
+TEST_CASE("can send many jobs to thread pool") {
+    osmium::thread::Pool pool{4, 3};
+    std::vector<std::future<int>> futures;
+    for (int i = 0; i < 1000; ++i) {
+        futures.push_back(pool.submit([i]() {
+            return i;
+        }));
+    }
+
+    int sum = 0;
+    for (auto& future : futures) {
+        sum += future.get();
+    }
+    REQUIRE(sum == 999 * 1000 / 2);
+}
+
+TEST_CASE("jobs in thread pool can submit jobs") {
+    std::atomic<int> count{0};
+    {
+        osmium::thread::Pool pool{3};
+        std::vector<std::future<void>> futures;
+        for (int i = 0; i < 10; ++i) {
+            futures.push_back(pool.submit([&pool, &count]() {
+                for (int j = 0; j < 10; ++j) {
+                    pool.submit([&count]() {
+                        ++count;
+                    });
+                }
+            }));
+        }
+        for (auto& future : futures) {
+            future.get();
+        }
+    }
+    REQUIRE(count == 100);
+}
+
+TEST_CASE("all jobs are done before thread pool shuts down") {
+    std::atomic<int> count{0};
+    {
+        osmium::thread::Pool pool{4};
+        for (int i = 0; i < 100; ++i) {
+            pool.submit([&count]() {
+                ++count;
+            });
+        }
+    }
+    REQUIRE(count == 100);
+}
@@ -2,6 +2,10 @@
 
 #include <osmium/thread/queue.hpp>
 
+#include <chrono>
+#include <string>
+#include <thread>
+
 TEST_CASE("Basic use of thread-safe queue") {
     osmium::thread::Queue<int> queue;
     REQUIRE(queue.empty());
@@ -45,3 +49,77 @@ TEST_CASE("When queue is shut down, nothing goes in or out") {
     queue.wait_and_pop(value);
     REQUIRE(value.empty());
 }
+
+TEST_CASE("Queue with byte limit accepts large element when empty") {
+    osmium::thread::Queue<int> queue;
+    queue.set_max_bytes(100);
+    REQUIRE(queue.max_bytes() == 100);
+    queue.push(1, 500);
+    REQUIRE(queue.size() == 1);
+    REQUIRE(queue.bytes() == 500);
+
+    int value = 0;
+    queue.wait_and_pop(value);
+    REQUIRE(value == 1);
+    REQUIRE(queue.bytes() == 0);
+}
+
+TEST_CASE("Queue with byte limit blocks producer until there is space") {
+    osmium::thread::Queue<int> queue;
+    queue.set_max_bytes(100);
+    queue.push(1, 60);
+
+    std::thread producer{[&queue]() {
+        queue.push(2, 60);
+    }};
+
+    std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    REQUIRE(queue.size() == 1);
+
+    int value = 0;
+    queue.wait_and_pop(value);
+    REQUIRE(value == 1);
+    queue.wait_and_pop(value);
+    REQUIRE(value == 2);
+    producer.join();
+
+    REQUIRE(queue.empty());
+    REQUIRE(queue.bytes() == 0);
+}
+
+TEST_CASE("Queue keeps usage statistics") {
+    osmium::thread::Queue<int> queue{10, "stats"};
+    queue.push(1);
+    queue.push(2);
+
+    int value = 0;
+    queue.wait_and_pop(value);
+    REQUIRE(queue.try_pop(value));
+    REQUIRE_FALSE(queue.try_pop(value));
+
+    const auto stats = queue.stats();
+    REQUIRE(stats.max_size == 10);
+    REQUIRE(stats.size == 0);
+    REQUIRE(stats.largest_size == 2);
+    REQUIRE(stats.push_count == 2);
+    REQUIRE(stats.full_count == 0);
+    REQUIRE(stats.pop_count == 3);
+    REQUIRE(stats.empty_count == 1);
+}
+
+TEST_CASE("Queue statistics record time consumer was blocked") {
+    osmium::thread::Queue<int> queue;
+
+    std::thread producer{[&queue]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds{20});
+        queue.push(1);
+    }};
+
+    int value = 0;
+    queue.wait_and_pop(value);
+    producer.join();
+
+    const auto stats = queue.stats();
+    REQUIRE(stats.empty_count == 1);
+    REQUIRE(stats.pop_wait_time >= std::chrono::milliseconds{10});
+}
@@ -0,0 +1,175 @@
+#include "catch.hpp"
+
+#include <osmium/thread/spsc_queue.hpp>
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+TEST_CASE("Basic use of single-producer single-consumer queue") {
+    osmium::thread::SPSCQueue<int> queue;
+    REQUIRE(queue.empty());
+    queue.push(22);
+    REQUIRE_FALSE(queue.empty());
+    REQUIRE(queue.size() == 1);
+    int value = 0;
+    queue.wait_and_pop(value);
+    REQUIRE(value == 22);
+    REQUIRE(queue.empty());
+}
+
+TEST_CASE("SPSCQueue can have max elements and can be named") {
+    const osmium::thread::SPSCQueue<int> queue{100, "Queue of max size 100"};
+    REQUIRE(queue.max_size() == 100);
+}
+
+TEST_CASE("SPSCQueue without max size gets default size") {
+    const osmium::thread::SPSCQueue<int> queue;
+    REQUIRE(queue.max_size() > 0);
+}
+
+TEST_CASE("When SPSCQueue is shut down, nothing goes in or out") {
+    osmium::thread::SPSCQueue<std::string> queue;
+    REQUIRE(queue.in_use());
+    REQUIRE(queue.empty());
+    queue.push("foo");
+    queue.push("bar");
+    queue.push("baz");
+    REQUIRE(queue.size() == 3);
+
+    std::string value;
+
+    queue.wait_and_pop(value);
+    REQUIRE(value == "foo");
+    REQUIRE(queue.size() == 2);
+    REQUIRE(queue.in_use());
+    queue.shutdown();
+    REQUIRE_FALSE(queue.in_use());
+    REQUIRE(queue.empty());
+    queue.push("lost");
+    REQUIRE(queue.empty());
+
+    value.clear();
+    queue.try_pop(value);
+    REQUIRE(value.empty());
+    queue.wait_and_pop(value);
+    REQUIRE(value.empty());
+}
+
+TEST_CASE("SPSCQueue wraps around and blocks when full") {
+    osmium::thread::SPSCQueue<int> queue{3};
+
+    std::thread producer{[&queue]() {
+        for (int i = 1; i <= 10000; ++i) {
+            queue.push(i);
+        }
+    }};
+
+    long sum = 0;
+    int last = 0;
+    bool in_order = true;
+    for (int i = 1; i <= 10000; ++i) {
+        int value = 0;
+        queue.wait_and_pop(value);
+        in_order = in_order && (value == last + 1);
+        last = value;
+        sum += value;
+    }
+    producer.join();
+
+    REQUIRE(in_order);
+    REQUIRE(sum == 10000L * 10001L / 2);
+    REQUIRE(queue.empty());
+}
+
+TEST_CASE("Shutting down SPSCQueue wakes up blocked producer") {
+    osmium::thread::SPSCQueue<int> queue{1};
+    queue.push(1);
+
+    std::thread producer{[&queue]() {
+        queue.push(2);
+    }};
+
+    while (queue.size() < 1) {
+        std::this_thread::yield();
+    }
+    queue.shutdown();
+    producer.join();
+
+    REQUIRE_FALSE(queue.in_use());
+}
+
+TEST_CASE("SPSCQueue with byte limit accepts large element when empty") {
+    osmium::thread::SPSCQueue<int> queue;
+    queue.set_max_bytes(100);
+    REQUIRE(queue.max_bytes() == 100);
+    queue.push(1, 500);
+    REQUIRE(queue.size() == 1);
+    REQUIRE(queue.bytes() == 500);
+
+    int value = 0;
+    queue.wait_and_pop(value);
+    REQUIRE(value == 1);
+    REQUIRE(queue.bytes() == 0);
+}
+
+TEST_CASE("SPSCQueue with byte limit blocks producer until there is space") {
+    osmium::thread::SPSCQueue<int> queue;
+    queue.set_max_bytes(100);
+    queue.push(1, 60);
+
+    std::thread producer{[&queue]() {
+        queue.push(2, 60);
+    }};
+
+    std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    REQUIRE(queue.size() == 1);
+
+    int value = 0;
+    queue.wait_and_pop(value);
+    REQUIRE(value == 1);
+    queue.wait_and_pop(value);
+    REQUIRE(value == 2);
+    producer.join();
+
+    REQUIRE(queue.empty());
+    REQUIRE(queue.bytes() == 0);
+}
+
+TEST_CASE("SPSCQueue keeps usage statistics") {
+    osmium::thread::SPSCQueue<int> queue{10, "stats"};
+    queue.push(1);
+    queue.push(2);
+
+    int value = 0;
+    queue.wait_and_pop(value);
+    REQUIRE(queue.try_pop(value));
+    REQUIRE_FALSE(queue.try_pop(value));
+
+    const auto stats = queue.stats();
+    REQUIRE(stats.max_size == 10);
+    REQUIRE(stats.size == 0);
+    REQUIRE(stats.largest_size == 2);
+    REQUIRE(stats.push_count == 2);
+    REQUIRE(stats.full_count == 0);
+    REQUIRE(stats.pop_count == 3);
+    REQUIRE(stats.empty_count == 1);
+}
+
+TEST_CASE("SPSCQueue statistics record time producer was blocked") {
+    osmium::thread::SPSCQueue<int> queue{1};
+    queue.push(1);
+
+    std::thread producer{[&queue]() {
+        queue.push(2);
+    }};
+
+    std::this_thread::sleep_for(std::chrono::milliseconds{20});
+    int value = 0;
+    queue.wait_and_pop(value);
+    producer.join();
+
+    const auto stats = queue.stats();
+    REQUIRE(stats.full_count == 1);
+    REQUIRE(stats.push_wait_time >= std::chrono::milliseconds{10});
+}
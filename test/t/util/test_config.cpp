@@ -82,3 +82,31 @@ TEST_CASE("get_max_queue_size") {
     REQUIRE(osmium::config::get_max_queue_size("NAME", 7) == 3);
 }
 
+
+TEST_CASE("get_max_queue_bytes") {
+    osmium::detail::env = nullptr;
+    REQUIRE(osmium::config::get_max_queue_bytes("NAME") == 0);
+    REQUIRE(osmium::detail::name == "OSMIUM_MAX_NAME_QUEUE_MB");
+
+    osmium::detail::env = "";
+    REQUIRE(osmium::config::get_max_queue_bytes("NAME") == 0);
+    osmium::detail::env = "0";
+    REQUIRE(osmium::config::get_max_queue_bytes("NAME") == 0);
+    osmium::detail::env = "3";
+    REQUIRE(osmium::config::get_max_queue_bytes("NAME") == 3 * 1024 * 1024);
+}
+
+TEST_CASE("get_read_ahead_bytes") {
+    osmium::detail::env = nullptr;
+    REQUIRE(osmium::config::get_read_ahead_bytes() == 32 * 1024 * 1024);
+    REQUIRE(osmium::detail::name == "OSMIUM_READ_AHEAD_MB");
+
+    osmium::detail::env = "";
+    REQUIRE(osmium::config::get_read_ahead_bytes() == 32 * 1024 * 1024);
+    osmium::detail::env = "foo";
+    REQUIRE(osmium::config::get_read_ahead_bytes() == 32 * 1024 * 1024);
+    osmium::detail::env = "0";
+    REQUIRE(osmium::config::get_read_ahead_bytes() == 0);
+    osmium::detail::env = "100";
+    REQUIRE(osmium::config::get_read_ahead_bytes() == 100 * 1024 * 1024);
+}
@@ -0,0 +1,19 @@
+#include "catch.hpp"
+
+#include <osmium/util/tracer.hpp>
+
+#include <sstream>
+
+TEST_CASE("tracer") {
+    auto& tracer = osmium::Tracer::instance();
+    tracer.start();
+    REQUIRE_FALSE(tracer.enabled());
+    {
+        const osmium::TraceEvent event{"test_event"};
+    }
+    tracer.stop();
+
+    std::ostringstream out;
+    tracer.write(out);
+    REQUIRE(out.str().empty());
+}
@@ -0,0 +1,59 @@
+#include "catch.hpp"
+
+#include "utils.hpp"
+
+#define OSMIUM_WITH_TRACE
+#include <osmium/io/xml_input.hpp>
+#include <osmium/thread/util.hpp>
+#include <osmium/util/tracer.hpp>
+
+#include <sstream>
+#include <string>
+#include <thread>
+
+TEST_CASE("tracer records events with thread names") {
+    auto& tracer = osmium::Tracer::instance();
+    tracer.start();
+    REQUIRE(tracer.enabled());
+
+    std::thread thread{[]() {
+        osmium::thread::set_thread_name("_osmium_test");
+        const osmium::TraceEvent event{"test_event"};
+    }};
+    thread.join();
+
+    tracer.stop();
+    {
+        const osmium::TraceEvent event{"after_stop"};
+    }
+
+    std::ostringstream out;
+    tracer.write(out);
+    const std::string trace = out.str();
+
+    REQUIRE(trace.find(R"({"traceEvents":[)") == 0);
+    REQUIRE(trace.find(R"("args":{"name":"_osmium_test"})") != std::string::npos);
+    REQUIRE(trace.find(R"({"name":"test_event","cat":"osmium","ph":"X")") != std::string::npos);
+    REQUIRE(trace.find("after_stop") == std::string::npos);
+}
+
+TEST_CASE("tracer records stages of the reader") {
+    auto& tracer = osmium::Tracer::instance();
+    tracer.start();
+
+    osmium::io::Reader reader{with_data_dir("t/io/data.osm")};
+    while (reader.read()) {
+    }
+    reader.close();
+
+    tracer.stop();
+
+    std::ostringstream out;
+    tracer.write(out);
+    const std::string trace = out.str();
+
+    REQUIRE(trace.find(R"("args":{"name":"_osmium_xml_in"})") != std::string::npos);
+    REQUIRE(trace.find(R"({"name":"read",)") != std::string::npos);
+    REQUIRE(trace.find(R"({"name":"parse",)") != std::string::npos);
+    REQUIRE(trace.find(R"({"name":"wait",)") != std::string::npos);
+}